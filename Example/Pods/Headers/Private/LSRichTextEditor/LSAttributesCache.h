@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSAttributesCache.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../../Pod/Classes/Parser/LSBBCodeSerializer.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSBatchConverter.h
\ No newline at end of file
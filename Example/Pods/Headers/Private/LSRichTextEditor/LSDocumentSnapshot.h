@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSDocumentSnapshot.h
\ No newline at end of file
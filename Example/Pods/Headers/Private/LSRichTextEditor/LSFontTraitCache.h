@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSFontTraitCache.h
\ No newline at end of file
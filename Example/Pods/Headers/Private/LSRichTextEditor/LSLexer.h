@@ -0,0 +1 @@
+../../../../../Pod/Classes/Parser/LSLexer.h
\ No newline at end of file
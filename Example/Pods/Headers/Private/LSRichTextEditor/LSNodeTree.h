@@ -0,0 +1 @@
+../../../../../Pod/Classes/Parser/LSNodeTree.h
\ No newline at end of file
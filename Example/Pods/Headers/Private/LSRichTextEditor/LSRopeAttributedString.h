@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSRopeAttributedString.h
\ No newline at end of file
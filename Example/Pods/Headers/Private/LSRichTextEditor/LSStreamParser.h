@@ -0,0 +1 @@
+../../../../../Pod/Classes/Parser/LSStreamParser.h
\ No newline at end of file
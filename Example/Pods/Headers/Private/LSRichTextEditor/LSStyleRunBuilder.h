@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSStyleRunBuilder.h
\ No newline at end of file
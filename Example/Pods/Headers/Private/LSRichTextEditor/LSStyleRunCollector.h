@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSStyleRunCollector.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../../Pod/Classes/Parser/LSTagRegistry.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../../Pod/Classes/Parser/LSTokenBuffer.h
\ No newline at end of file
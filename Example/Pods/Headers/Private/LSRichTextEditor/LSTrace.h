@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSTrace.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../../Pod/Classes/LSUIKitStyleAdapter.h
\ No newline at end of file
@@ -8,6 +8,21 @@
 #import "LSNode.h"
 #import "LSParser.h"
 #import "LSToken.h"
+#import "LSLexer.h"
+#import "LSTokenBuffer.h"
+#import "LSNodeTree.h"
+#import "LSRopeAttributedString.h"
+#import "LSBBCodeSerializer.h"
+#import "LSStreamParser.h"
+#import "LSFontTraitCache.h"
+#import "LSStyleRunBuilder.h"
+#import "LSTagRegistry.h"
+#import "LSTrace.h"
+#import "LSStyleRunCollector.h"
+#import "LSUIKitStyleAdapter.h"
+#import "LSBatchConverter.h"
+#import "LSAttributesCache.h"
+#import "LSDocumentSnapshot.h"
 
 FOUNDATION_EXPORT double LSRichTextEditorVersionNumber;
 FOUNDATION_EXPORT const unsigned char LSRichTextEditorVersionString[];
@@ -0,0 +1,73 @@
+//
+//  LSAttributesCacheTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "LSAttributesCache.h"
+
+@interface LSAttributesCacheTests : XCTestCase
+
+@property (nonatomic) LSAttributesCache *testAttributesCache;
+
+@end
+
+@implementation LSAttributesCacheTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testAttributesCache = [[LSAttributesCache alloc] init];
+}
+
+- (void)tearDown {
+    self.testAttributesCache = nil;
+    [super tearDown];
+}
+
+- (void)testInternedAttributesShareOneInstance
+{
+    UIFont *font = [UIFont fontWithName:@"Georgia" size:18];
+    NSMutableDictionary *attributes = [NSMutableDictionary dictionaryWithObject:font forKey:NSFontAttributeName];
+    NSDictionary *equalAttributes = @{NSFontAttributeName : font};
+
+    NSDictionary *internedAttributes = [self.testAttributesCache internedAttributes:attributes];
+
+    XCTAssertEqual([self.testAttributesCache internedAttributes:equalAttributes], internedAttributes, @"Equal attributes aren't shared!");
+    XCTAssertEqualObjects(internedAttributes, attributes, @"Interned attributes aren't equal!");
+    XCTAssertFalse([internedAttributes isKindOfClass:[NSMutableDictionary class]], @"Interned attributes are mutable!");
+
+    attributes[NSUnderlineStyleAttributeName] = @(NSUnderlineStyleSingle);
+
+    XCTAssertEqual(internedAttributes.count, 1, @"Interned attributes change with their source!");
+    XCTAssertNotEqual([self.testAttributesCache internedAttributes:attributes], internedAttributes, @"Different attributes are shared!");
+    XCTAssertEqual(self.testAttributesCache.count, 2, @"Interned attributes aren't counted!");
+}
+
+- (void)testAttributesForStyleCallsBlockOncePerStyle
+{
+    NSDictionary *baseAttributes = @{NSFontAttributeName : [UIFont fontWithName:@"Georgia" size:18]};
+    __block NSUInteger blockCalls = 0;
+
+    LSAttributesCacheBlock block = ^NSDictionary *(LSBBCodeStyle style, NSUInteger context, NSDictionary *base) {
+        blockCalls++;
+        NSMutableDictionary *attributes = [base mutableCopy];
+        attributes[NSUnderlineStyleAttributeName] = @(NSUnderlineStyleSingle);
+        return attributes;
+    };
+
+    NSDictionary *attributes = [self.testAttributesCache attributesForStyle:LSBBCodeStyleUnderlined andContext:NSNotFound
+                                                         withBaseAttributes:baseAttributes usingBlock:block];
+    NSDictionary *cachedAttributes = [self.testAttributesCache attributesForStyle:LSBBCodeStyleUnderlined andContext:NSNotFound
+                                                               withBaseAttributes:[baseAttributes mutableCopy] usingBlock:block];
+    [self.testAttributesCache attributesForStyle:LSBBCodeStyleUnderlined andContext:0
+                              withBaseAttributes:baseAttributes usingBlock:block];
+
+    XCTAssertEqual(attributes, cachedAttributes, @"Attributes of a style aren't cached!");
+    XCTAssertEqual(blockCalls, 2, @"Block isn't called once per style and context!");
+}
+
+@end
@@ -0,0 +1,79 @@
+//
+//  LSBatchConverterTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "LSBatchConverter.h"
+#import "LSStyleRunBuilder.h"
+#import "LSStyleRunCollector.h"
+
+@interface LSBatchConverterTests : XCTestCase
+
+@property (nonatomic) LSBatchConverter *testConverter;
+
+@end
+
+@implementation LSBatchConverterTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testConverter = [[LSBatchConverter alloc] initWithTagRegistry:nil];
+}
+
+- (void)tearDown {
+    self.testConverter = nil;
+    [super tearDown];
+}
+
+- (void)testNormalizeMarkupStringsKeepsOrder
+{
+    NSMutableArray *markupStrings = [NSMutableArray array];
+    NSMutableArray *expectedStrings = [NSMutableArray array];
+
+    for (NSUInteger index = 0; index < 500; index++) {
+        NSString *markup = [NSString stringWithFormat:@"[b]%lu[/b][b] [i]post[/b] %lu[/i] [x]%lu[/x]",
+                            (unsigned long)index, (unsigned long)index, (unsigned long)index];
+        [markupStrings addObject:markup];
+        [expectedStrings addObject:[LSStyleRunCollector normalizedMarkupFromString:markup withTagRegistry:nil error:nil]];
+    }
+
+    NSArray *errors;
+    NSArray *results = [self.testConverter normalizeMarkupStrings:markupStrings errors:&errors];
+
+    XCTAssertEqualObjects(results, expectedStrings, @"Results aren't returned in the order of the documents!");
+    XCTAssertEqual([errors indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
+        return obj != [NSNull null];
+    }].count, 0, @"Valid documents have errors!");
+}
+
+- (void)testConvertMarkupStringsReportsErrorsPerDocument
+{
+    NSArray *errors;
+    NSArray *results = [self.testConverter convertMarkupStrings:@[@"[b]one[/b]", @"[b two", @"three"]
+                                                     usingBlock:^id(LSStyleRunBuilder *runBuilder, LSStyleRunCollector *collector) {
+        return [runBuilder string];
+    } errors:&errors];
+
+    XCTAssertEqualObjects(results, (@[@"one", [NSNull null], @"three"]), @"Results of valid documents aren't kept!");
+    XCTAssertEqual(errors[0], [NSNull null], @"Valid document has an error!");
+    XCTAssert([errors[1] isKindOfClass:[NSError class]], @"Malformed document has no error!");
+    XCTAssertEqual(errors[2], [NSNull null], @"Valid document after a malformed one has an error!");
+}
+
+- (void)testConvertMarkupStringsWithOneWorker
+{
+    self.testConverter.maximumConcurrency = 1;
+
+    NSArray *results = [self.testConverter convertMarkupStrings:@[@"[u]one[/u]", @"[s]two[/s]", @""]
+                                                     usingBlock:^id(LSStyleRunBuilder *runBuilder, LSStyleRunCollector *collector) {
+        return @(runBuilder.runCount);
+    } errors:nil];
+
+    XCTAssertEqualObjects(results, (@[@1, @1, @0]), @"Reused run builder isn't reset!");
+}
+
+@end
@@ -0,0 +1,142 @@
+//
+//  LSBenchmark.h
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/*!
+ * @typedef LSBenchmarkCorpus
+ *
+ * @brief The kind of generated markup a benchmark runs on.
+ *
+ * @field LSBenchmarkCorpusFlat       plain text lines with a few style tags
+ * @field LSBenchmarkCorpusNested     style tags nested 32 levels deep
+ * @field LSBenchmarkCorpusAttributes tags with several quoted and unquoted attributes
+ * @field LSBenchmarkCorpusMismatched open and close tags that don't match each other
+ */
+typedef NS_ENUM(NSUInteger, LSBenchmarkCorpus) {
+    LSBenchmarkCorpusFlat,
+    LSBenchmarkCorpusNested,
+    LSBenchmarkCorpusAttributes,
+    LSBenchmarkCorpusMismatched
+};
+
+/*!
+ *  The result of one benchmark run.
+ */
+@interface LSBenchmarkResult : NSObject
+
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, assign) NSUInteger length;
+@property (nonatomic, assign) NSUInteger iterations;
+
+/*!
+ *  The median time of one iteration in seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval seconds;
+
+/*!
+ *  The processed markup in MB per second, the corpora are ASCII so characters are bytes.
+ */
+@property (nonatomic, assign) double throughput;
+
+/*!
+ *  The largest growth of the heap during one iteration, before autoreleased objects are released.
+ */
+@property (nonatomic, assign) NSUInteger allocatedBytes;
+
+/*!
+ *  The peak resident set size of the process after the run.
+ */
+@property (nonatomic, assign) NSUInteger peakResidentBytes;
+
+/*!
+ *  A one line report of the result.
+ */
+- (NSString *)report;
+
+@end
+
+/*!
+ *  @discussion LSBenchmark generates markup corpora and measures blocks working on them.
+ *              It only depends on Foundation, so the parser and serializer benchmarks can run
+ *              without UIKit. Results are compared with a baseline of throughputs by name.
+ */
+@interface LSBenchmark : NSObject
+
+/*!
+ *  The results measured so far.
+ */
+@property (nonatomic, strong, readonly) NSArray *results;
+
+/*!
+ *  Generates a deterministic corpus.
+ *
+ *  @param corpus the kind of markup.
+ *  @param length the length of the corpus in characters.
+ *
+ *  @return the generated markup.
+ */
++ (NSString *)corpus:(LSBenchmarkCorpus)corpus withLength:(NSUInteger)length;
+
+/*!
+ *  Returns the name of a corpus used in result names.
+ */
++ (NSString *)nameOfCorpus:(LSBenchmarkCorpus)corpus;
+
+/*!
+ *  Returns the corpus lengths from 1 KB to 50 MB which aren't longer than the given one.
+ */
++ (NSArray *)corpusLengthsUpToLength:(NSUInteger)maximumLength;
+
+/*!
+ *  Initializes a benchmark comparing with a baseline.
+ *
+ *  @param baseline  a dictionary of throughputs by result name, can be nil.
+ *  @param tolerance the fraction the throughput may fall below the baseline, e.g. 0.2.
+ *
+ *  @return an instance of LSBenchmark.
+ */
+- (instancetype)initWithBaseline:(NSDictionary *)baseline andTolerance:(double)tolerance;
+
+/*!
+ *  Measures a block until five iterations or one second of work are done.
+ *
+ *  @param name   the name of the result.
+ *  @param length the length of the processed markup.
+ *  @param setUp  called before every iteration and not measured, can be nil.
+ *  @param block  the measured work.
+ *
+ *  @return the result, it's added to the results.
+ */
+- (LSBenchmarkResult *)measure:(NSString *)name withLength:(NSUInteger)length
+                         setUp:(void (^)(void))setUp usingBlock:(void (^)(void))block;
+
+/*!
+ *  Returns reports of the results slower than the baseline allows.
+ */
+- (NSArray *)regressions;
+
+/*!
+ *  Returns reports of the results not scaling linearly with the corpus length. Results are
+ *  grouped by name without the length, the throughput on the longest corpus of a group may
+ *  fall by the factor at most compared to the reference length. Shorter corpora are dominated
+ *  by constant costs and aren't compared.
+ *
+ *  @param prefix          the prefix of the compared result names.
+ *  @param referenceLength the corpus length the longer corpora are compared with.
+ *  @param factor          the allowed slowdown per character, e.g. 3.
+ *
+ *  @return an array of reports, empty if no group has a result longer than the reference.
+ */
+- (NSArray *)nonlinearScalingsWithPrefix:(NSString *)prefix fromLength:(NSUInteger)referenceLength andFactor:(double)factor;
+
+/*!
+ *  Returns the throughputs by result name, the format of the baseline.
+ */
+- (NSDictionary *)resultsDictionary;
+
+@end
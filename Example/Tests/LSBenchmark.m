@@ -0,0 +1,268 @@
+//
+//  LSBenchmark.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import "LSBenchmark.h"
+#import <sys/resource.h>
+
+#if defined(__APPLE__)
+#import <malloc/malloc.h>
+#else
+#import <malloc.h>
+#endif
+
+#define LSBENCHMARK_MAX_ITERATIONS 5
+#define LSBENCHMARK_MIN_DURATION 1.0
+
+static NSUInteger LSBenchmarkHeapInUse(void)
+{
+#if defined(__APPLE__)
+    malloc_statistics_t statistics;
+    malloc_zone_statistics(NULL, &statistics);
+    return statistics.size_in_use;
+#else
+    struct mallinfo info = mallinfo();
+    return (NSUInteger)info.uordblks;
+#endif
+}
+
+static NSUInteger LSBenchmarkPeakResidentSize(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#if defined(__APPLE__)
+    return (NSUInteger)usage.ru_maxrss;
+#else
+    // Linux reports kilobytes
+    return (NSUInteger)usage.ru_maxrss * 1024;
+#endif
+}
+
+static inline uint32_t LSBenchmarkRandom(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+@implementation LSBenchmarkResult
+
+- (NSString *)report
+{
+    return [NSString stringWithFormat:@"%-36@ %10lu chars %4lu runs %10.3f ms %9.2f MB/s %10lu KB heap %8lu MB peak RSS",
+            self.name, (unsigned long)self.length, (unsigned long)self.iterations, self.seconds * 1000.0, self.throughput,
+            (unsigned long)(self.allocatedBytes / 1024), (unsigned long)(self.peakResidentBytes / (1024 * 1024))];
+}
+
+@end
+
+@implementation LSBenchmark {
+    NSDictionary *_baseline;
+    double _tolerance;
+    NSMutableArray *_results;
+}
+
+#pragma mark - corpora
+
++ (NSString *)corpus:(LSBenchmarkCorpus)corpus withLength:(NSUInteger)length
+{
+    static NSString * const words[] = {@"lorem", @"ipsum", @"dolor", @"sit", @"amet", @"markup", @"editor", @"style"};
+    static NSString * const tags[] = {@"s", @"u", @"i", @"b"};
+
+    NSMutableString *string = [NSMutableString stringWithCapacity:length];
+    uint32_t seed = 42;
+
+    while (string.length < length) {
+        NSMutableString *chunk = [NSMutableString string];
+
+        switch (corpus) {
+            case LSBenchmarkCorpusFlat:
+                for (NSUInteger index = 0; index < 12; index++) {
+                    NSString *word = words[LSBenchmarkRandom(&seed) % 8];
+                    if (LSBenchmarkRandom(&seed) % 10 == 0) {
+                        NSString *tag = tags[LSBenchmarkRandom(&seed) % 4];
+                        [chunk appendFormat:@"[%@]%@[/%@] ", tag, word, tag];
+                    } else {
+                        [chunk appendFormat:@"%@ ", word];
+                    }
+                }
+                [chunk appendString:@"\n"];
+                break;
+
+            case LSBenchmarkCorpusNested:
+                for (NSUInteger depth = 0; depth < 32; depth++) {
+                    [chunk appendFormat:@"[%@]%@ ", tags[depth % 4], words[depth % 8]];
+                }
+                for (NSInteger depth = 31; depth >= 0; depth--) {
+                    [chunk appendFormat:@"[/%@]", tags[depth % 4]];
+                }
+                [chunk appendString:@"\n"];
+                break;
+
+            case LSBenchmarkCorpusAttributes:
+                [chunk appendFormat:@"[color=#%06x]%@ [url=\"http://lshift.de/%u\" title=\"a \\\"quoted\\\" title\" rel=nofollow]%@[/url][/color] ",
+                 LSBenchmarkRandom(&seed) & 0xFFFFFF, words[LSBenchmarkRandom(&seed) % 8],
+                 LSBenchmarkRandom(&seed) % 1000, words[LSBenchmarkRandom(&seed) % 8]];
+                [chunk appendFormat:@"[size=%u]%@[/size]\n", 10 + LSBenchmarkRandom(&seed) % 20, words[LSBenchmarkRandom(&seed) % 8]];
+                break;
+
+            case LSBenchmarkCorpusMismatched:
+                for (NSUInteger index = 0; index < 12; index++) {
+                    NSString *tag = tags[LSBenchmarkRandom(&seed) % 4];
+                    BOOL isCloseTag = LSBenchmarkRandom(&seed) % 2;
+                    [chunk appendFormat:isCloseTag ? @"[/%@]%@ " : @"[%@]%@ ", tag, words[LSBenchmarkRandom(&seed) % 8]];
+                }
+                [chunk appendString:@"\n"];
+                break;
+        }
+
+        if (string.length + chunk.length > length) {
+            // the corpus isn't cut within a tag, the rest is filled with plain text
+            [string appendString:[@"" stringByPaddingToLength:length - string.length withString:@"x" startingAtIndex:0]];
+        } else {
+            [string appendString:chunk];
+        }
+    }
+
+    return string;
+}
+
++ (NSString *)nameOfCorpus:(LSBenchmarkCorpus)corpus
+{
+    return @[@"flat", @"nested", @"attributes", @"mismatched"][corpus];
+}
+
++ (NSArray *)corpusLengthsUpToLength:(NSUInteger)maximumLength
+{
+    NSArray *lengths = @[@(1024), @(64 * 1024), @(1024 * 1024), @(8 * 1024 * 1024), @(50 * 1024 * 1024)];
+
+    return [lengths filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"unsignedIntegerValue <= %lu", (unsigned long)maximumLength]];
+}
+
+#pragma mark - measuring
+
+- (instancetype)initWithBaseline:(NSDictionary *)baseline andTolerance:(double)tolerance
+{
+    if (self = [super init]) {
+        _baseline = baseline;
+        _tolerance = tolerance;
+        _results = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (NSArray *)results
+{
+    return [_results copy];
+}
+
+- (LSBenchmarkResult *)measure:(NSString *)name withLength:(NSUInteger)length
+                         setUp:(void (^)(void))setUp usingBlock:(void (^)(void))block
+{
+    NSMutableArray *durations = [NSMutableArray array];
+    NSTimeInterval totalDuration = 0;
+    NSUInteger allocatedBytes = 0;
+
+    while (durations.count < LSBENCHMARK_MAX_ITERATIONS && (durations.count == 0 || totalDuration < LSBENCHMARK_MIN_DURATION)) {
+        @autoreleasepool {
+            if (setUp) {
+                setUp();
+            }
+
+            NSUInteger heapBefore = LSBenchmarkHeapInUse();
+            NSDate *start = [NSDate date];
+
+            block();
+
+            NSTimeInterval duration = -[start timeIntervalSinceNow];
+            NSUInteger heapAfter = LSBenchmarkHeapInUse();
+
+            allocatedBytes = MAX(allocatedBytes, (heapAfter > heapBefore) ? heapAfter - heapBefore : 0);
+            totalDuration += duration;
+            [durations addObject:@(duration)];
+        }
+    }
+
+    [durations sortUsingSelector:@selector(compare:)];
+
+    LSBenchmarkResult *result = [LSBenchmarkResult new];
+    result.name = name;
+    result.length = length;
+    result.iterations = durations.count;
+    result.seconds = [durations[durations.count / 2] doubleValue];
+    result.throughput = (length / (1024.0 * 1024.0)) / MAX(result.seconds, 1e-9);
+    result.allocatedBytes = allocatedBytes;
+    result.peakResidentBytes = LSBenchmarkPeakResidentSize();
+
+    [_results addObject:result];
+
+    return result;
+}
+
+- (NSArray *)regressions
+{
+    NSMutableArray *regressions = [NSMutableArray array];
+
+    for (LSBenchmarkResult *result in _results) {
+        NSNumber *baselineThroughput = _baseline[result.name];
+
+        if (baselineThroughput && result.throughput < baselineThroughput.doubleValue * (1.0 - _tolerance)) {
+            [regressions addObject:[NSString stringWithFormat:@"%@: %.2f MB/s, baseline %.2f MB/s",
+                                    result.name, result.throughput, baselineThroughput.doubleValue]];
+        }
+    }
+
+    return regressions;
+}
+
+- (NSArray *)nonlinearScalingsWithPrefix:(NSString *)prefix fromLength:(NSUInteger)referenceLength andFactor:(double)factor
+{
+    NSMutableDictionary *referenceResults = [NSMutableDictionary dictionary];
+    NSMutableDictionary *longestResults = [NSMutableDictionary dictionary];
+
+    for (LSBenchmarkResult *result in _results) {
+        if (![result.name hasPrefix:prefix]) {
+            continue;
+        }
+
+        NSString *group = [result.name stringByDeletingLastPathComponent];
+        LSBenchmarkResult *longestResult = longestResults[group];
+
+        if (result.length == referenceLength) {
+            referenceResults[group] = result;
+        } else if (result.length > referenceLength && (!longestResult || result.length > longestResult.length)) {
+            longestResults[group] = result;
+        }
+    }
+
+    NSMutableArray *scalings = [NSMutableArray array];
+
+    [longestResults enumerateKeysAndObjectsUsingBlock:^(NSString *group, LSBenchmarkResult *longestResult, BOOL *stop) {
+        LSBenchmarkResult *referenceResult = referenceResults[group];
+
+        if (referenceResult && longestResult.throughput * factor < referenceResult.throughput) {
+            [scalings addObject:[NSString stringWithFormat:@"%@: %.2f MB/s for %lu characters, %.2f MB/s for %lu characters",
+                                 group, longestResult.throughput, (unsigned long)longestResult.length,
+                                 referenceResult.throughput, (unsigned long)referenceResult.length]];
+        }
+    }];
+
+    return scalings;
+}
+
+- (NSDictionary *)resultsDictionary
+{
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:_results.count];
+
+    for (LSBenchmarkResult *result in _results) {
+        dictionary[result.name] = @(result.throughput);
+    }
+
+    return dictionary;
+}
+
+@end
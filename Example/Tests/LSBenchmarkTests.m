@@ -0,0 +1,286 @@
+//
+//  LSBenchmarkTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+//  Benchmarks run on corpora up to 64 KB by default. The environment of the test run
+//  configures them:
+//
+//  LSBENCHMARK_MAX_LENGTH  the longest corpus in characters, up to 52428800 (50 MB)
+//  LSBENCHMARK_BASELINE    a plist of throughputs by result name, slower results fail
+//  LSBENCHMARK_TOLERANCE   the allowed fraction below the baseline, 0.2 by default
+//  LSBENCHMARK_RESULTS     a plist the throughputs are written to, e.g. a new baseline
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "LSBenchmark.h"
+#import "LSParser.h"
+#import "LSBatchConverter.h"
+#import "LSDocumentSnapshot.h"
+#import "LSRopeAttributedString.h"
+#import "LSTextStorage.h"
+#import "LSRichTextView.h"
+
+@interface LSTextStorage (Benchmark)
+
+- (void)applyStylesToRange:(NSRange)searchRange withAttributedText:(NSAttributedString *)attributedText;
+
+@end
+
+@interface LSBenchmarkTests : XCTestCase
+
+@property (nonatomic, strong) LSBenchmark *benchmark;
+@property (nonatomic, strong) NSArray *corpusLengths;
+
+@end
+
+@implementation LSBenchmarkTests
+
+- (void)setUp {
+    [super setUp];
+
+    NSDictionary *environment = [NSProcessInfo processInfo].environment;
+    NSUInteger maximumLength = [environment[@"LSBENCHMARK_MAX_LENGTH"] integerValue] ?: 64 * 1024;
+    double tolerance = [environment[@"LSBENCHMARK_TOLERANCE"] doubleValue] ?: 0.2;
+    NSDictionary *baseline = environment[@"LSBENCHMARK_BASELINE"]
+        ? [NSDictionary dictionaryWithContentsOfFile:environment[@"LSBENCHMARK_BASELINE"]]
+        : nil;
+
+    self.benchmark = [[LSBenchmark alloc] initWithBaseline:baseline andTolerance:tolerance];
+    self.corpusLengths = [LSBenchmark corpusLengthsUpToLength:maximumLength];
+}
+
+- (void)tearDown {
+    for (LSBenchmarkResult *result in self.benchmark.results) {
+        NSLog(@"%@", result.report);
+    }
+
+    for (NSString *regression in self.benchmark.regressions) {
+        XCTFail(@"Benchmark is slower than its baseline, %@", regression);
+    }
+
+    NSString *resultsPath = [NSProcessInfo processInfo].environment[@"LSBENCHMARK_RESULTS"];
+
+    if (resultsPath) {
+        // every test adds its results to the ones written before
+        NSMutableDictionary *results = [NSMutableDictionary dictionaryWithContentsOfFile:resultsPath] ?: [NSMutableDictionary dictionary];
+        [results addEntriesFromDictionary:self.benchmark.resultsDictionary];
+        [results writeToFile:resultsPath atomically:YES];
+    }
+
+    [super tearDown];
+}
+
+#pragma mark - parser benchmarks
+
+- (void)testBenchmarkScan
+{
+    LSParser *parser = [[LSParser alloc] init];
+
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        [self.benchmark measure:[@"scan/" stringByAppendingString:name] withLength:corpus.length setUp:nil usingBlock:^{
+            [parser scan:corpus error:nil];
+        }];
+    }];
+}
+
+- (void)testBenchmarkParseTokens
+{
+    LSParser *parser = [[LSParser alloc] init];
+
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        NSMutableArray *tokens = [parser scan:corpus error:nil];
+
+        [self.benchmark measure:[@"parseTokens/" stringByAppendingString:name] withLength:corpus.length setUp:nil usingBlock:^{
+            [parser parseTokens:tokens];
+        }];
+    }];
+}
+
+- (void)testBenchmarkParsePathological
+{
+    LSParser *parser = [[LSParser alloc] init];
+    // every close tag reopens the inner tags, the open tags are nested deeper with every repetition
+    NSArray *pathologicalLines = @[@"[b][i][u]x[/b]", @"[a][b][c][d][e][f][g][h]x[/a]", @"[/b][/i]x[b]"];
+
+    for (NSNumber *length in self.corpusLengths) {
+        for (NSUInteger lineIndex = 0; lineIndex < pathologicalLines.count; lineIndex++) {
+            @autoreleasepool {
+                NSString *corpus = [@"" stringByPaddingToLength:length.unsignedIntegerValue withString:pathologicalLines[lineIndex] startingAtIndex:0];
+                NSString *resultName = [NSString stringWithFormat:@"parsePathological/%lu/%@", (unsigned long)lineIndex, length];
+
+                [self.benchmark measure:resultName withLength:corpus.length setUp:nil usingBlock:^{
+                    [parser parseNodeTreeFromString:corpus error:nil];
+                }];
+            }
+        }
+    }
+
+    [self checkLinearScalingWithPrefix:@"parsePathological/"];
+}
+
+- (void)testBenchmarkBatchConversion
+{
+    NSUInteger processorCount = [NSProcessInfo processInfo].activeProcessorCount;
+
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        // every line of the corpus is a post of its own, like a thread export
+        NSMutableArray *posts = [NSMutableArray array];
+        [corpus enumerateSubstringsInRange:NSMakeRange(0, corpus.length) options:NSStringEnumerationByParagraphs
+                                usingBlock:^(NSString *substring, NSRange substringRange, NSRange enclosingRange, BOOL *stop) {
+            [posts addObject:substring];
+        }];
+
+        for (NSUInteger concurrency = 1; concurrency <= processorCount; concurrency *= 2) {
+            LSBatchConverter *converter = [[LSBatchConverter alloc] initWithTagRegistry:nil];
+            converter.maximumConcurrency = concurrency;
+
+            NSString *resultName = [NSString stringWithFormat:@"batchConversion/%lu/%@", (unsigned long)concurrency, name];
+            [self.benchmark measure:resultName withLength:corpus.length setUp:nil usingBlock:^{
+                [converter normalizeMarkupStrings:posts errors:nil];
+            }];
+        }
+    }];
+}
+
+#pragma mark - text storage benchmarks
+
+- (void)testBenchmarkApplyStyles
+{
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        NSAttributedString *attributedCorpus = [self attributedStringWithString:corpus];
+        __block LSTextStorage *textStorage;
+
+        [self.benchmark measure:[@"applyStyles/" stringByAppendingString:name] withLength:corpus.length setUp:^{
+            textStorage = [self createTextStorageWithTextCheckingTypes:0];
+        } usingBlock:^{
+            [textStorage applyStylesToRange:NSMakeRange(0, attributedCorpus.length) withAttributedText:attributedCorpus];
+        }];
+    }];
+
+    [self checkLinearScalingWithPrefix:@"applyStyles/"];
+}
+
+- (void)testBenchmarkCreateOutputString
+{
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        LSTextStorage *textStorage = [self createTextStorageWithTextCheckingTypes:0];
+        [textStorage applyStylesToRange:NSMakeRange(0, corpus.length) withAttributedText:[self attributedStringWithString:corpus]];
+
+        [self.benchmark measure:[@"createOutputString/" stringByAppendingString:name] withLength:corpus.length setUp:nil usingBlock:^{
+            [textStorage createOutputString];
+        }];
+    }];
+}
+
+- (void)testBenchmarkDataDetection
+{
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        LSTextStorage *textStorage = [self createTextStorageWithTextCheckingTypes:NSTextCheckingTypeLink];
+        [textStorage applyStylesToRange:NSMakeRange(0, corpus.length) withAttributedText:[self attributedStringWithString:corpus]];
+
+        [self.benchmark measure:[@"processDataDetection/" stringByAppendingString:name] withLength:corpus.length setUp:nil usingBlock:^{
+            [textStorage processDataDetection];
+        }];
+    }];
+}
+
+- (void)testBenchmarkLoadSnapshot
+{
+    [self enumerateCorporaUsingBlock:^(NSString *name, NSString *corpus) {
+        __block LSTextStorage *textStorage;
+        LSTagRegistry *tagRegistry = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll].tagRegistry;
+        NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:corpus withTagRegistry:tagRegistry error:nil];
+
+        // a warm load validates and copies the snapshot, compare with applyStyles of the same corpus
+        [self.benchmark measure:[@"loadSnapshot/" stringByAppendingString:name] withLength:corpus.length setUp:nil usingBlock:^{
+            [[LSDocumentSnapshot alloc] initWithData:data andTagRegistry:tagRegistry error:nil];
+        }];
+
+        LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:data andTagRegistry:tagRegistry error:nil];
+
+        [self.benchmark measure:[@"setSnapshot/" stringByAppendingString:name] withLength:corpus.length setUp:^{
+            textStorage = [self createTextStorageWithTextCheckingTypes:0];
+        } usingBlock:^{
+            [textStorage setSnapshot:snapshot];
+        }];
+    }];
+}
+
+#pragma mark - backing store benchmarks
+
+- (void)testBenchmarkRandomEdits
+{
+    NSArray *attributes = @[@{},
+                            @{NSFontAttributeName : [UIFont boldSystemFontOfSize:12]},
+                            @{NSUnderlineStyleAttributeName : @(NSUnderlineStyleSingle)}];
+    NSArray *storeClasses = @[[NSMutableAttributedString class], [LSRopeAttributedString class]];
+
+    for (NSNumber *length in self.corpusLengths) {
+        @autoreleasepool {
+            NSString *corpus = [LSBenchmark corpus:LSBenchmarkCorpusFlat withLength:length.unsignedIntegerValue];
+
+            for (Class storeClass in storeClasses) {
+                __block NSMutableAttributedString *store;
+                NSString *resultName = [NSString stringWithFormat:@"randomEdits/%@/%@", NSStringFromClass(storeClass), length];
+
+                // the number of edits is fixed, so the throughput shows how much longer stores slow them down
+                [self.benchmark measure:resultName withLength:corpus.length setUp:^{
+                    store = [[storeClass alloc] initWithString:corpus];
+                    srand48(42);
+                } usingBlock:^{
+                    for (NSUInteger edit = 0; edit < 500; edit++) {
+                        NSUInteger location = lrand48() % (store.length - 16);
+                        [store replaceCharactersInRange:NSMakeRange(location, edit % 2) withString:@"x"];
+                        [store setAttributes:attributes[edit % attributes.count] range:NSMakeRange(location, 16)];
+                    }
+                }];
+            }
+        }
+    }
+}
+
+#pragma mark - helpers
+
+- (void)checkLinearScalingWithPrefix:(NSString *)prefix
+{
+    // only checked if LSBENCHMARK_MAX_LENGTH adds corpora longer than the 64 KB reference
+    for (NSString *scaling in [self.benchmark nonlinearScalingsWithPrefix:prefix fromLength:64 * 1024 andFactor:3]) {
+        XCTFail(@"Benchmark doesn't scale linearly, %@", scaling);
+    }
+}
+
+- (void)enumerateCorporaUsingBlock:(void (^)(NSString *name, NSString *corpus))block
+{
+    for (NSNumber *length in self.corpusLengths) {
+        for (LSBenchmarkCorpus corpus = LSBenchmarkCorpusFlat; corpus <= LSBenchmarkCorpusMismatched; corpus++) {
+            @autoreleasepool {
+                NSString *name = [NSString stringWithFormat:@"%@/%@", [LSBenchmark nameOfCorpus:corpus], length];
+                block(name, [LSBenchmark corpus:corpus withLength:length.unsignedIntegerValue]);
+            }
+        }
+    }
+}
+
+- (NSAttributedString *)attributedStringWithString:(NSString *)string
+{
+    return [[NSAttributedString alloc] initWithString:string attributes:@{NSFontAttributeName:[UIFont fontWithName:@"Georgia" size:18]}];
+}
+
+- (LSTextStorage *)createTextStorageWithTextCheckingTypes:(NSTextCheckingType)textCheckingTypes
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    configuration.textCheckingTypes = textCheckingTypes;
+
+    LSRichTextView *textView = [OCMockObject niceMockForClass:[LSRichTextView class]];
+    OCMStub([textView font]).andReturn([UIFont fontWithName:@"Georgia" size:18]);
+    OCMStub([textView tintColor]).andReturn([UIColor blueColor]);
+    OCMStub([textView richTextConfiguration]).andReturn(configuration);
+
+    return [[LSTextStorage alloc] initWithTextView:textView];
+}
+
+@end
@@ -0,0 +1,144 @@
+//
+//  LSDocumentSnapshotTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "LSDocumentSnapshot.h"
+#import "LSStyleRunBuilder.h"
+#import "LSStyleRunCollector.h"
+#import "LSTagRegistry.h"
+
+@interface LSDocumentSnapshotTests : XCTestCase
+
+@property (nonatomic) LSTagRegistry *testTagRegistry;
+@property (nonatomic) NSUInteger testMarkTagID;
+
+@end
+
+@implementation LSDocumentSnapshotTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testTagRegistry = [[LSTagRegistry alloc] init];
+    self.testMarkTagID = [self.testTagRegistry registerTagName:@"mark" withStyle:LSBBCodeStyleNone
+                                                    andHandler:^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {
+    }];
+}
+
+- (void)tearDown {
+    self.testTagRegistry = nil;
+    [super tearDown];
+}
+
+- (void)testSnapshotKeepsTextAndStyleRuns
+{
+    NSString *markup = @"[b]one[/b] [i][u]two[/u][/i] thäree\n[s]four[/s]";
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:markup withTagRegistry:nil error:nil];
+
+    NSError *error;
+    LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:data andTagRegistry:nil error:&error];
+
+    XCTAssertNotNil(snapshot, @"Snapshot isn't loaded: %@", error);
+    XCTAssertEqualObjects(snapshot.string, @"one two thäree\nfour", @"Text of the snapshot isn't kept!");
+    XCTAssertEqual(snapshot.runCount, 5, @"Runs of the snapshot aren't kept!");
+
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:snapshot.string];
+    [snapshot addRunsToBuilder:runBuilder];
+
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:nil andTagRegistry:nil];
+    [runBuilder serializeWithSerializer:serializer];
+    [serializer finishWithError:nil];
+
+    XCTAssertEqualObjects(serializer.string, [LSStyleRunCollector normalizedMarkupFromString:markup withTagRegistry:nil error:nil],
+                          @"Styles of the snapshot aren't kept!");
+}
+
+- (void)testSnapshotResolvesTagContextsByName
+{
+    NSString *markup = @"[mark=yellow]one [b]two[/b][/mark] [mark]three[/mark]";
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:markup withTagRegistry:self.testTagRegistry error:nil];
+
+    // the tag gets another ID in the registry the snapshot is loaded with
+    LSTagRegistry *tagRegistry = [[LSTagRegistry alloc] init];
+    [tagRegistry registerTagName:@"quote" withStyle:LSBBCodeStyleNone andHandler:nil];
+    NSUInteger markTagID = [tagRegistry registerTagName:@"mark" withStyle:LSBBCodeStyleNone andHandler:nil];
+
+    LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:data andTagRegistry:tagRegistry error:nil];
+
+    XCTAssertEqualObjects(snapshot.tagContexts, (@[@[@[@(markTagID), @{@"mark" : @"yellow"}]],
+                                                   @[@[@(markTagID), [NSNull null]]]]), @"Tag contexts aren't resolved!");
+
+    NSMutableArray *contexts = [NSMutableArray array];
+    [snapshot enumerateRunsUsingBlock:^(NSRange range, LSBBCodeStyle style, NSUInteger context, BOOL *stop) {
+        [contexts addObject:@(context)];
+    }];
+
+    XCTAssertEqualObjects(contexts, (@[@0, @0, @(NSNotFound), @1]), @"Runs don't reference their tag contexts!");
+}
+
+- (void)testSnapshotWithUnknownTagIsRejected
+{
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:@"[mark]one[/mark]" withTagRegistry:self.testTagRegistry error:nil];
+
+    NSError *error;
+    LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:data andTagRegistry:nil error:&error];
+
+    XCTAssertNil(snapshot, @"Snapshot with an unregistered tag is loaded!");
+    XCTAssertEqual(error.code, LSDocumentSnapshotErrorUnknownTag, @"Wrong error for an unregistered tag!");
+}
+
+- (void)testSnapshotValidation
+{
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:@"[b]one[/b] two" withTagRegistry:nil error:nil];
+    NSError *error;
+
+    NSMutableData *corruptedData = [data mutableCopy];
+    ((uint8_t *)corruptedData.mutableBytes)[corruptedData.length - 4] ^= 0x01;
+    XCTAssertNil([[LSDocumentSnapshot alloc] initWithData:corruptedData andTagRegistry:nil error:&error], @"Corrupted snapshot is loaded!");
+    XCTAssertEqual(error.code, LSDocumentSnapshotErrorChecksumMismatch, @"Wrong error for a corrupted snapshot!");
+
+    NSMutableData *staleData = [data mutableCopy];
+    ((uint32_t *)staleData.mutableBytes)[1] = 0;
+    XCTAssertNil([[LSDocumentSnapshot alloc] initWithData:staleData andTagRegistry:nil error:&error], @"Snapshot of another version is loaded!");
+    XCTAssertEqual(error.code, LSDocumentSnapshotErrorUnsupportedVersion, @"Wrong error for a snapshot of another version!");
+
+    NSData *truncatedData = [data subdataWithRange:NSMakeRange(0, data.length - 4)];
+    XCTAssertNil([[LSDocumentSnapshot alloc] initWithData:truncatedData andTagRegistry:nil error:&error], @"Truncated snapshot is loaded!");
+    XCTAssertEqual(error.code, LSDocumentSnapshotErrorMalformed, @"Wrong error for a truncated snapshot!");
+
+    XCTAssertNil([[LSDocumentSnapshot alloc] initWithData:[@"[b]one[/b] two" dataUsingEncoding:NSUTF8StringEncoding] andTagRegistry:nil error:&error],
+                 @"Markup is loaded as snapshot!");
+    XCTAssertEqual(error.code, LSDocumentSnapshotErrorMalformed, @"Wrong error for data which isn't a snapshot!");
+}
+
+- (void)testSnapshotWithContentsOfFile
+{
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:@"[i]one[/i] two" withTagRegistry:nil error:nil];
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [data writeToFile:path atomically:YES];
+
+    LSDocumentSnapshot *snapshot = [LSDocumentSnapshot snapshotWithContentsOfFile:path andTagRegistry:nil error:nil];
+
+    XCTAssertEqualObjects(snapshot.string, @"one two", @"Snapshot file isn't loaded!");
+    XCTAssertEqual(snapshot.runCount, 2, @"Runs of the snapshot file aren't loaded!");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testSnapshotOfUnalignedData
+{
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:@"[u]one[/u] two" withTagRegistry:nil error:nil];
+    NSMutableData *shiftedData = [NSMutableData dataWithLength:1];
+    [shiftedData appendData:data];
+
+    NSData *unalignedData = [NSData dataWithBytesNoCopy:(uint8_t *)shiftedData.mutableBytes + 1 length:data.length freeWhenDone:NO];
+    LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:unalignedData andTagRegistry:nil error:nil];
+
+    XCTAssertEqualObjects(snapshot.string, @"one two", @"Unaligned snapshot isn't loaded!");
+}
+
+@end
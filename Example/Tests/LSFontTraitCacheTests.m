@@ -0,0 +1,111 @@
+//
+//  LSFontTraitCacheTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "LSFontTraitCache.h"
+#import "LSRichTextConfiguration.h"
+
+@interface LSFontTraitCacheTests : XCTestCase
+
+@property (nonatomic) LSFontTraitCache *testFontCache;
+@property (nonatomic) UIFont *testPreconditionFont;
+
+@end
+
+@implementation LSFontTraitCacheTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testFontCache = [[LSFontTraitCache alloc] init];
+    self.testPreconditionFont = [UIFont fontWithName:@"Georgia" size:18];
+}
+
+- (void)tearDown {
+    self.testFontCache = nil;
+    [super tearDown];
+}
+
+- (void)testFontWithDescriptorResolvesTraits
+{
+    UIFont *font = [self.testFontCache fontWithDescriptor:self.testPreconditionFont.fontDescriptor
+                                        andSymbolicTraits:UIFontDescriptorTraitBold];
+
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitBold, @"Resolved font isn't bold!");
+    XCTAssertEqual(font.pointSize, self.testPreconditionFont.pointSize, @"Resolved font size was changed!");
+}
+
+- (void)testFontWithDescriptorCountsHitsAndMisses
+{
+    UIFontDescriptor *fontDescriptor = self.testPreconditionFont.fontDescriptor;
+
+    UIFont *firstFont = [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitItalic];
+    UIFont *secondFont = [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitItalic];
+    [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+
+    XCTAssertEqual(firstFont, secondFont, @"Cached font isn't reused!");
+    XCTAssertEqual(self.testFontCache.hitCount, 1, @"Cache hits aren't counted!");
+    XCTAssertEqual(self.testFontCache.missCount, 2, @"Cache misses aren't counted!");
+}
+
+- (void)testFontWithDescriptorHitsForEqualDescriptors
+{
+    UIFontDescriptor *fontDescriptor = [UIFontDescriptor fontDescriptorWithName:@"Georgia" size:18];
+    UIFontDescriptor *equalFontDescriptor = [UIFontDescriptor fontDescriptorWithName:@"Georgia" size:18];
+    UIFontDescriptor *largerFontDescriptor = [UIFontDescriptor fontDescriptorWithName:@"Georgia" size:24];
+
+    [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+    [self.testFontCache fontWithDescriptor:equalFontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+    UIFont *largerFont = [self.testFontCache fontWithDescriptor:largerFontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+
+    XCTAssertEqual(self.testFontCache.hitCount, 1, @"Equal descriptor isn't answered from the cache!");
+    XCTAssertEqual(largerFont.pointSize, 24, @"Font of another size is answered from the cache!");
+}
+
+- (void)testInvalidateResolvesFontsAgain
+{
+    UIFontDescriptor *fontDescriptor = self.testPreconditionFont.fontDescriptor;
+
+    [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+    [self.testFontCache invalidate];
+    [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+
+    XCTAssertEqual(self.testFontCache.hitCount, 0, @"Invalidated font is still cached!");
+    XCTAssertEqual(self.testFontCache.missCount, 2, @"Invalidated font isn't resolved again!");
+}
+
+- (void)testConfigurationInvalidatesCacheForNewInitialAttributes
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    LSRichTextConfiguration *copiedConfiguration = [configuration copy];
+    UIFontDescriptor *fontDescriptor = self.testPreconditionFont.fontDescriptor;
+
+    XCTAssertEqual(configuration.fontCache, copiedConfiguration.fontCache, @"Copied configuration doesn't share the font cache!");
+
+    [configuration.fontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+    configuration.initialTextAttributes = [@{NSFontAttributeName : self.testPreconditionFont} mutableCopy];
+    [configuration.fontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:UIFontDescriptorTraitBold];
+
+    XCTAssertEqual(configuration.fontCache.hitCount, 0, @"Font cache isn't invalidated by new initial attributes!");
+}
+
+- (void)testFontWithDescriptorConcurrently
+{
+    UIFontDescriptor *fontDescriptor = self.testPreconditionFont.fontDescriptor;
+    UIFontDescriptorSymbolicTraits traits[] = {UIFontDescriptorTraitBold, UIFontDescriptorTraitItalic,
+                                               UIFontDescriptorTraitBold | UIFontDescriptorTraitItalic};
+
+    dispatch_apply(300, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        [self.testFontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:traits[index % 3]];
+    });
+
+    XCTAssertEqual(self.testFontCache.hitCount + self.testFontCache.missCount, 300, @"Concurrent lookups are lost!");
+    XCTAssert(self.testFontCache.missCount >= 3, @"Concurrent lookups aren't resolved!");
+}
+
+@end
@@ -12,6 +12,7 @@
 #import "LSRichTextView.h"
 #import "LSTextStorage.h"
 #import "LSRichTextConfiguration.h"
+#import "LSBBCodeSerializer.h"
 
 @interface LSOutputFormatter_Tests : XCTestCase
 
@@ -53,6 +54,8 @@
     
     LSRichTextConfiguration *configuration = [OCMockObject mockForClass:[LSRichTextConfiguration class]];
     OCMStub([configuration configurationFeatures]).andReturn(LSRichTextFeaturesAll);
+    OCMStub([configuration fontCache]).andReturn([[LSFontTraitCache alloc] init]);
+    OCMStub([configuration tagRegistry]).andReturn([[LSTagRegistry alloc] init]);
     
     self.testTextView = [OCMockObject mockForClass:[LSRichTextView class]];
     OCMStub([self.testTextView font]).andReturn(self.testPreconditionFont);
@@ -93,4 +96,45 @@
     XCTAssertEqualObjects(formatResult, expectedString, @"Formatted string result string isn't correct!");
 }
 
+- (void)testCreateOutputStringSharesTagsOfAdjacentRuns
+{
+    UIFont *boldFont = [UIFont fontWithDescriptor:[[self.testPreconditionFont fontDescriptor] fontDescriptorWithSymbolicTraits:UIFontDescriptorTraitBold] size:0];
+    NSMutableAttributedString *inString = [[NSMutableAttributedString alloc] initWithString:@"rich text" attributes:@{NSFontAttributeName:boldFont}];
+    [inString addAttributes:@{NSForegroundColorAttributeName:[UIColor redColor]} range:NSMakeRange(0, 2)];
+    [inString addAttributes:@{NSUnderlineStyleAttributeName:@(NSUnderlineStyleSingle)} range:NSMakeRange(4, 5)];
+
+    NSString *formatResult = [self.testTextStorage createOutputStringFromStore:inString];
+
+    XCTAssertEqualObjects(formatResult, @"[b]rich[u] text[/u][/b]", @"Formatted string repeats tags of adjacent runs!");
+}
+
+- (void)testCreateOutputStringRoundTrip
+{
+    NSString *formatResult = [self.testTextStorage createOutputStringFromStore:self.testString];
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:formatResult attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage setAttributedText:inString];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, self.testString.string, @"Parsed output string isn't the source string!");
+    XCTAssertEqualObjects([self.testTextStorage createOutputString], formatResult, @"Parsed output string isn't formatted the same!");
+}
+
+- (void)testSerializerWritesToStream
+{
+    NSString *inputString = [[@"" stringByPaddingToLength:4095 withString:@"a" startingAtIndex:0] stringByAppendingString:@"\U0001F600 €"];
+    NSOutputStream *outputStream = [NSOutputStream outputStreamToMemory];
+    [outputStream open];
+
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:outputStream];
+    [serializer appendCharactersOfString:inputString inRange:NSMakeRange(0, inputString.length) withStyle:LSBBCodeStyleBold];
+
+    NSError *error;
+    XCTAssert([serializer finishWithError:&error], @"Serializer failed writing to the stream!");
+
+    NSData *outputData = [outputStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    NSString *expectedString = [NSString stringWithFormat:@"[b]%@[/b]", inputString];
+
+    XCTAssertEqualObjects(outputData, [expectedString dataUsingEncoding:NSUTF8StringEncoding], @"Serializer stream output isn't UTF-8 encoded correctly!");
+}
+
 @end
@@ -0,0 +1,75 @@
+//
+//  LSRichTextToolbarTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "LSRichTextToolbar.h"
+#import "LSToggleButton.h"
+
+@interface LSRichTextToolbarTests : XCTestCase
+
+@property (nonatomic) LSRichTextConfiguration *testConfiguration;
+@property (nonatomic) LSRichTextToolbar *testToolbar;
+
+@end
+
+@implementation LSRichTextToolbarTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testConfiguration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    self.testToolbar = [[LSRichTextToolbar alloc] initWithFrame:CGRectMake(0, 0, 320, 44) withDelegate:nil
+                                               andConfiguration:self.testConfiguration];
+}
+
+- (void)tearDown {
+    self.testToolbar = nil;
+    self.testConfiguration = nil;
+    [super tearDown];
+}
+
+- (void)testUpdateStateWithStyleActivatesButtons
+{
+    [self.testToolbar updateStateWithStyle:LSBBCodeStyleBold | LSBBCodeStyleUnderlined];
+
+    XCTAssertTrue([[self.testToolbar valueForKey:@"buttonBold"] isActive], @"Bold button isn't active!");
+    XCTAssertFalse([[self.testToolbar valueForKey:@"buttonItalic"] isActive], @"Italic button is active!");
+    XCTAssertTrue([[self.testToolbar valueForKey:@"buttonUnderlined"] isActive], @"Underline button isn't active!");
+    XCTAssertFalse([[self.testToolbar valueForKey:@"buttonStrikeThrough"] isActive], @"Strike through button is active!");
+}
+
+- (void)testUpdateStateWithStyleUpdatesChangedButtonsOnly
+{
+    [self.testToolbar updateStateWithStyle:LSBBCodeStyleBold];
+
+    id boldButtonMock = OCMPartialMock([self.testToolbar valueForKey:@"buttonBold"]);
+    id italicButtonMock = OCMPartialMock([self.testToolbar valueForKey:@"buttonItalic"]);
+    [[boldButtonMock reject] setIsActive:YES];
+    [[italicButtonMock expect] setIsActive:YES];
+
+    [self.testToolbar updateStateWithStyle:LSBBCodeStyleBold | LSBBCodeStyleItalic];
+
+    OCMVerifyAll(boldButtonMock);
+    OCMVerifyAll(italicButtonMock);
+}
+
+- (void)testUpdateStateWithAttributesMatchesStyle
+{
+    UIFont *font = [UIFont fontWithName:@"Georgia" size:18];
+    UIFont *italicFont = [UIFont fontWithDescriptor:[font.fontDescriptor fontDescriptorWithSymbolicTraits:UIFontDescriptorTraitItalic] size:0];
+
+    [self.testToolbar updateStateWithAttributes:@{NSFontAttributeName : italicFont,
+                                                  NSStrikethroughStyleAttributeName : @(NSUnderlineStyleSingle)}];
+
+    XCTAssertFalse([[self.testToolbar valueForKey:@"buttonBold"] isActive], @"Bold button is active!");
+    XCTAssertTrue([[self.testToolbar valueForKey:@"buttonItalic"] isActive], @"Italic button isn't active!");
+    XCTAssertTrue([[self.testToolbar valueForKey:@"buttonStrikeThrough"] isActive], @"Strike through button isn't active!");
+}
+
+@end
@@ -129,4 +129,20 @@
     OCMVerify([[self.richTextPartialMock reject] setSelectedRange:NSMakeRange(7, 0)]);
 }
 
+- (void)testSetTextStylesVisibleTextFirst
+{
+    OCMStub([self.mockTextStorage string]).andReturn(@"");
+    OCMStub([self.richTextPartialMock selectedRange]).andReturn(NSMakeRange(0, 0));
+    _richTextView.richTextConfiguration.stylesVisibleTextFirst = YES;
+
+    [_richTextView setText:@"[b]This is a long text[/b]"];
+
+    OCMVerify([self.mockTextStorage setUnstyledAttributedText:[OCMArg checkWithBlock:^BOOL(NSAttributedString *attributedText) {
+        return [attributedText.string isEqualToString:@"[b]This is a long text[/b]"];
+    }]]);
+
+    // data is detected in the chunks when they are styled, the markup isn't searched
+    OCMVerify([[self.mockTextStorage reject] processDataDetection]);
+}
+
 @end
@@ -0,0 +1,103 @@
+//
+//  LSRopeAttributedStringTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "LSRopeAttributedString.h"
+
+@interface LSRopeAttributedStringTests : XCTestCase
+
+@property (nonatomic, strong) NSArray *testAttributes;
+
+@end
+
+@implementation LSRopeAttributedStringTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testAttributes = @[@{},
+                            @{NSFontAttributeName : [UIFont boldSystemFontOfSize:12]},
+                            @{NSUnderlineStyleAttributeName : @(NSUnderlineStyleSingle)}];
+}
+
+- (void)testInitWithString
+{
+    LSRopeAttributedString *ropeString = [[LSRopeAttributedString alloc] initWithString:@"rope" attributes:self.testAttributes[1]];
+
+    XCTAssertEqualObjects(ropeString.string, @"rope", @"Rope string isn't initialized!");
+    XCTAssertEqualObjects([ropeString attributesAtIndex:3 effectiveRange:nil], self.testAttributes[1], @"Rope attributes aren't initialized!");
+    XCTAssertEqual([[LSRopeAttributedString alloc] init].length, 0, @"Empty rope isn't empty!");
+}
+
+- (void)testRandomEditsMatchAttributedString
+{
+    NSMutableString *inputString = [NSMutableString string];
+    while (inputString.length < 20 * 1024) {
+        [inputString appendString:@"Lorem ipsum dolor sit amet, consectetur adipiscing elit.\n"];
+    }
+
+    NSMutableAttributedString *expectedString = [[NSMutableAttributedString alloc] initWithString:inputString];
+    LSRopeAttributedString *ropeString = [[LSRopeAttributedString alloc] initWithString:inputString];
+
+    srand48(42);
+
+    for (NSUInteger edit = 0; edit < 2000; edit++) {
+        NSUInteger location = lrand48() % (expectedString.length + 1);
+        NSUInteger length = MIN(lrand48() % 3000, expectedString.length - location);
+        NSRange range = NSMakeRange(location, (lrand48() % 4 == 0) ? length : length % 8);
+
+        if (edit % 3 == 2) {
+            NSDictionary *attributes = self.testAttributes[lrand48() % self.testAttributes.count];
+            [expectedString setAttributes:attributes range:range];
+            [ropeString setAttributes:attributes range:range];
+        } else {
+            NSString *replacement = [inputString substringWithRange:NSMakeRange(lrand48() % 1000, lrand48() % ((edit % 50 == 0) ? 5000 : 10))];
+            [expectedString replaceCharactersInRange:range withString:replacement];
+            [ropeString replaceCharactersInRange:range withString:replacement];
+        }
+    }
+
+    XCTAssertEqualObjects(ropeString.string, expectedString.string, @"Rope string differs after random edits!");
+    XCTAssert([expectedString isEqualToAttributedString:ropeString], @"Rope attributes differ after random edits!");
+}
+
+- (void)testRandomEditsAtBoundariesMatchAttributedString
+{
+    NSString *markupLine = @"Lorem ipsum dolor sit amet, consectetur adipiscing elit.\n";
+
+    for (long seed = 1; seed <= 8; seed++) {
+        NSMutableAttributedString *expectedString = [[NSMutableAttributedString alloc] initWithString:markupLine];
+        LSRopeAttributedString *ropeString = [[LSRopeAttributedString alloc] initWithString:markupLine];
+
+        srand48(seed);
+
+        // edits at both ends and ones emptying the string cover the splits and merges of leaf nodes
+        for (NSUInteger edit = 0; edit < 500; edit++) {
+            NSUInteger length = expectedString.length;
+            NSUInteger location = (edit % 4 == 0) ? 0 : (edit % 4 == 1) ? length : lrand48() % (length + 1);
+            NSRange range = NSMakeRange(location, (edit % 97 == 0) ? length - location : MIN(lrand48() % 64, length - location));
+
+            if (edit % 5 == 4) {
+                NSDictionary *attributes = self.testAttributes[lrand48() % self.testAttributes.count];
+                [expectedString addAttributes:attributes range:range];
+                [ropeString addAttributes:attributes range:range];
+            } else {
+                NSString *replacement = [markupLine substringToIndex:lrand48() % markupLine.length];
+                [expectedString replaceCharactersInRange:range withString:replacement];
+                [ropeString replaceCharactersInRange:range withString:replacement];
+            }
+
+            XCTAssertEqual(ropeString.length, expectedString.length, @"Rope length differs after edit %lu with seed %ld!", (unsigned long)edit, seed);
+        }
+
+        XCTAssertEqualObjects(ropeString.string, expectedString.string, @"Rope string differs with seed %ld!", seed);
+        XCTAssert([expectedString isEqualToAttributedString:ropeString], @"Rope attributes differ with seed %ld!", seed);
+    }
+}
+
+@end
@@ -11,6 +11,8 @@
 #import "LSParser.h"
 #import "LSToken.h"
 #import "LSNode.h"
+#import "LSLexer.h"
+#import "LSTokenBuffer.h"
 
 @interface LSParser (Test)
 
@@ -81,6 +83,168 @@
     NSLog(@"==> rebuilt string: %@ ", [LSParser debugScannedString:tokens]);
 }
 
+- (void)testScanMultipleNewlines
+{
+    NSString *testString = @"this\n\nis [b]just\n[/b]\n";
+    NSString *expectedString = @":4-this::8-\n::8-\n::4-is ::1-b::4-just::8-\n::2-b::8-\n:";
+
+    NSMutableArray *tokens = [self.testParser scan:testString error:nil];
+    NSString *resultString = [LSParser debugScannedString:tokens];
+
+    XCTAssertEqualObjects(resultString, expectedString, @"Scanned token result isn't correct!");
+}
+
+- (void)testScanMalformedTags
+{
+    NSArray *testStrings = @[@"this is [b", @"this is [/b", @"this is [] text", @"this is [/] text"];
+
+    for (NSString *testString in testStrings) {
+        NSError *error = nil;
+        NSMutableArray *tokens = [self.testParser scan:testString error:&error];
+
+        XCTAssertNil(tokens, @"Malformed markup shouldn't be scanned!");
+        XCTAssertEqualObjects(error.domain, LSLexerErrorDomain, @"Malformed markup error isn't set!");
+    }
+}
+
+- (void)testScanTokenBufferRanges
+{
+    NSString *testString = @"this is [b][i] just[/i] [/b]text";
+
+    LSTokenBuffer *tokenBuffer = [self.testParser scanTokens:testString error:nil];
+    const LSTokenRecord *tokens = tokenBuffer.tokens;
+
+    XCTAssertEqual(tokenBuffer.count, 8, @"Token count isn't correct!");
+    XCTAssertEqual(tokens[0].type, LSTokenTypeContent, @"Token type isn't correct!");
+    XCTAssert(NSEqualRanges(tokens[0].range, NSMakeRange(0, 8)), @"Content token range isn't correct!");
+    XCTAssert(NSEqualRanges(tokens[1].range, NSMakeRange(9, 1)), @"Tag token range isn't correct!");
+    XCTAssertEqual(tokens[1].tagIndex, tokens[6].tagIndex, @"Tag names aren't interned!");
+    XCTAssertEqual([tokenBuffer valueOfTokenAtIndex:1], [tokenBuffer valueOfTokenAtIndex:6], @"Tag names aren't interned!");
+    XCTAssertEqualObjects([tokenBuffer valueOfTokenAtIndex:3], @" just", @"Token value isn't correct!");
+}
+
+- (void)testScanTagAttributes
+{
+    NSDictionary *expectedAttributes = @{@"id" : @"bla", @"img" : @"http:://blablub.de"};
+
+    LSTokenBuffer *tokenBuffer = [self.testParser scanTokens:self.testString error:nil];
+
+    XCTAssertEqualObjects([tokenBuffer valueOfTokenAtIndex:3], @"u", @"Tag name isn't correct!");
+    XCTAssertEqualObjects([tokenBuffer attributesOfTokenAtIndex:3], expectedAttributes, @"Tag attributes aren't correct!");
+    XCTAssertNil([tokenBuffer attributesOfTokenAtIndex:1], @"Tag attributes aren't empty!");
+}
+
+- (void)testScanQuotedTagAttributesWithEscapes
+{
+    NSDictionary *expectedAttributes = @{@"name" : @"say \"hi\" = x", @"alt" : @"it's", @"w" : @"5"};
+
+    LSToken *token = [self.testParser scanOpenTagValue:@"quote name=\"say \\\"hi\\\" = x\" alt=\"it's\" w=5"];
+
+    XCTAssertEqualObjects(token.value, @"quote", @"Tag name isn't correct!");
+    XCTAssertEqualObjects(token.attributes, expectedAttributes, @"Quoted tag attributes aren't correct!");
+}
+
+- (void)testScanTagAttributesInternsKeys
+{
+    LSTokenBuffer *tokenBuffer = [self.testParser scanTokens:@"[a href=\"one\"]1[/a][a href=\"two\"]2[/a]" error:nil];
+
+    NSString *firstKey = [[tokenBuffer attributesOfTokenAtIndex:0] allKeys].firstObject;
+    NSString *secondKey = [[tokenBuffer attributesOfTokenAtIndex:3] allKeys].firstObject;
+
+    XCTAssertEqualObjects(firstKey, @"href", @"Attribute key isn't correct!");
+    XCTAssertEqual(firstKey, secondKey, @"Attribute keys aren't interned!");
+    XCTAssertEqualObjects([tokenBuffer attributesOfTokenAtIndex:3][@"href"], @"two", @"Attribute value isn't correct!");
+}
+
+- (void)testScanTagNamesWithLongCommonPrefix
+{
+    NSString *prefix = [@"" stringByPaddingToLength:40 withString:@"x" startingAtIndex:0];
+    NSMutableString *markup = [NSMutableString string];
+
+    for (NSUInteger index = 0; index < 100; index++) {
+        [markup appendFormat:@"[%@%lu]%lu[/%@%lu]", prefix, (unsigned long)index, (unsigned long)index, prefix, (unsigned long)index];
+    }
+
+    LSTokenBuffer *tokenBuffer = [self.testParser scanTokens:markup error:nil];
+    const LSTokenRecord *tokens = [tokenBuffer tokens];
+
+    for (NSUInteger index = 0; index < 100; index++) {
+        NSString *tagName = [NSString stringWithFormat:@"%@%lu", prefix, (unsigned long)index];
+
+        XCTAssertEqualObjects([tokenBuffer valueOfTokenAtIndex:index * 3], tagName, @"Tag names sharing a prefix are mixed up!");
+        XCTAssertEqual(tokens[index * 3].tagIndex, tokens[index * 3 + 2].tagIndex, @"Open and close tag don't share the interned name!");
+    }
+}
+
+- (void)testScanTagAttributesMatchesRegularExpression
+{
+    NSString *keyCharacters = @"abcxyz_-09";
+    NSString *valueCharacters = @"abcdefghijklmnopqrstuvwxyzABC0123456789:/._-#%?&";
+    NSArray *quotes = @[@"", @"\"", @"'"];
+
+    srand48(42);
+
+    for (NSUInteger iteration = 0; iteration < 2000; iteration++) {
+        NSMutableArray *attributes = [NSMutableArray array];
+
+        for (NSUInteger attribute = 0; attribute < 1 + lrand48() % 4; attribute++) {
+            NSString *key = [self randomStringWithCharacters:keyCharacters andLength:1 + lrand48() % 6];
+            NSString *quote = quotes[lrand48() % quotes.count];
+            NSMutableString *value = [NSMutableString string];
+
+            // unquoted values contain spaces sometimes, the regular expression allows both
+            NSUInteger words = (quote.length > 0 || lrand48() % 2) ? 1 + lrand48() % 3 : 1;
+            for (NSUInteger word = 0; word < words; word++) {
+                [value appendFormat:@"%@%@", (word > 0) ? @" " : @"", [self randomStringWithCharacters:valueCharacters andLength:1 + lrand48() % 8]];
+            }
+
+            // the regular expression drops values of a single character
+            if (value.length < 2) {
+                [value appendString:@"x"];
+            }
+
+            [attributes addObject:[NSString stringWithFormat:@"%@=%@%@%@", key, quote, value, quote]];
+        }
+
+        NSString *attributesString = [attributes componentsJoinedByString:(lrand48() % 2) ? @" " : @"  "];
+        LSToken *token = [self.testParser scanOpenTagValue:[@"tag " stringByAppendingString:attributesString]];
+
+        XCTAssertEqualObjects(token.attributes, [self regularExpressionAttributesOfString:attributesString],
+                              @"Tag attributes differ from the regular expression for: %@", attributesString);
+    }
+}
+
+- (NSString *)randomStringWithCharacters:(NSString *)characters andLength:(NSUInteger)length
+{
+    NSMutableString *string = [NSMutableString stringWithCapacity:length];
+
+    for (NSUInteger index = 0; index < length; index++) {
+        [string appendFormat:@"%C", [characters characterAtIndex:lrand48() % characters.length]];
+    }
+
+    return string;
+}
+
+// the attribute scanner formerly used by the parser, kept as reference
+- (NSDictionary *)regularExpressionAttributesOfString:(NSString *)attributesString
+{
+    NSMutableDictionary *attributes = [NSMutableDictionary dictionary];
+    NSRegularExpression *regex = [NSRegularExpression
+                                  regularExpressionWithPattern:@"(\\S+)=[\"']?((?:.(?![\"\']?\\s+(?:\\S+)=|[>\"']))+.)[\"']?"
+                                  options:0
+                                  error:nil];
+
+    [regex enumerateMatchesInString:attributesString
+                            options:0
+                              range:NSMakeRange(0, attributesString.length)
+                         usingBlock:^(NSTextCheckingResult *match, NSMatchingFlags flags, BOOL *stop) {
+                             [attributes setValue:[attributesString substringWithRange:[match rangeAtIndex:2]]
+                                           forKey:[attributesString substringWithRange:[match rangeAtIndex:1]]];
+                         }];
+
+    return attributes;
+}
+
 #pragma mark - parse tests
 
 - (void)testParseSimpleTokens
@@ -163,4 +327,141 @@
     NSLog(@"=+>\n\n %@\n\n", [LSParser debugParsedString:rootNode]);
 }
 
+- (void)testParseNodeTreeSharesTagPaths
+{
+    NSString *testString = @"[b]one[/b] two [b]three[/b]";
+
+    LSNodeTree *nodeTree = [self.testParser parseNodeTreeFromString:testString error:nil];
+    LSNodeRecord rootNode = [nodeTree nodeAtIndex:nodeTree.rootIndex];
+    LSNodeRecord firstNode = [nodeTree nodeAtIndex:rootNode.firstChild];
+    LSNodeRecord secondNode = [nodeTree nodeAtIndex:firstNode.nextSibling];
+    LSNodeRecord thirdNode = [nodeTree nodeAtIndex:secondNode.nextSibling];
+
+    XCTAssertEqual(nodeTree.count, 6, @"Node count isn't correct!");
+    XCTAssertEqual(firstNode.tagPath, thirdNode.tagPath, @"Equal tag paths aren't shared!");
+    XCTAssertEqual(secondNode.tagPath, rootNode.tagPath, @"Content node doesn't share the parent tag path!");
+    XCTAssertEqual([nodeTree nodeAtIndex:firstNode.firstChild].tagPath, firstNode.tagPath, @"Content node doesn't share the parent tag path!");
+    XCTAssertEqualObjects([nodeTree tagNamesOfTagPath:thirdNode.tagPath], (@[@"ROOT", @"b"]), @"Tag path names aren't correct!");
+}
+
+- (void)testParseNodeTreeReusesTokenBufferAndNodeTree
+{
+    LSTokenBuffer *tokenBuffer = [[LSTokenBuffer alloc] initWithString:@""];
+    LSNodeTree *nodeTree = [[LSNodeTree alloc] initWithSourceString:@"" andRootTagName:@"ROOT"];
+
+    [self.testParser parseNodeTreeFromString:@"[i]one[u]two[/u][/i]" withTokenBuffer:tokenBuffer andNodeTree:nodeTree error:nil];
+    LSNodeTree *resultTree = [self.testParser parseNodeTreeFromString:@"[b]three[/b] four" withTokenBuffer:tokenBuffer
+                                                          andNodeTree:nodeTree error:nil];
+
+    LSNodeTree *expectedTree = [self.testParser parseNodeTreeFromString:@"[b]three[/b] four" error:nil];
+
+    XCTAssertEqual(resultTree, nodeTree, @"Node tree isn't reused!");
+    XCTAssertEqual(tokenBuffer.count, 4, @"Token buffer isn't reset!");
+    XCTAssertEqualObjects([LSParser debugParsedString:resultTree.rootNode], [LSParser debugParsedString:expectedTree.rootNode],
+                          @"Reused node tree differs from a new one!");
+    XCTAssertNil([self.testParser parseNodeTreeFromString:@"[b" withTokenBuffer:tokenBuffer andNodeTree:nodeTree error:nil],
+                 @"Malformed markup is parsed!");
+}
+
+- (void)testParseIgnoresUnmatchedRootCloseTag
+{
+    NSString *testString = @"[b]one[/ROOT] two[/b]";
+    NSString *expectedString = @":b-(null)*ROOT b *::(null)-one*ROOT b *::(null)- two*ROOT b *:";
+
+    LSNode *rootNode = [self.testParser parseString:testString error:nil];
+
+    XCTAssertEqualObjects([LSParser debugParsedString:rootNode], expectedString, @"Root node is closed by markup!");
+}
+
+- (void)testParseDropsTagsBeyondMaximumDepth
+{
+    NSString *testString = @"[b][i][u]deep[/u][/i] bold[/b] plain";
+    NSString *expectedString = @":b-(null)*ROOT b *::i-(null)*ROOT b i *::(null)-deep*ROOT b i *::(null)- bold*ROOT b *::(null)- plain*ROOT *:";
+
+    self.testParser.maximumTagDepth = 2;
+    LSNode *rootNode = [self.testParser parseString:testString error:nil];
+
+    XCTAssertEqualObjects([LSParser debugParsedString:rootNode], expectedString, @"Tags beyond the maximum depth aren't dropped!");
+}
+
+- (void)testParseDroppedTagDoesNotSwallowLaterCloseTag
+{
+    NSString *testString = @"[i][b]x[/i][b]y[/b]z";
+    NSString *expectedString = @":i-(null)*ROOT i *::(null)-x*ROOT i *::b-(null)*ROOT b *::(null)-y*ROOT b *::(null)-z*ROOT *:";
+
+    self.testParser.maximumTagDepth = 1;
+    LSNode *rootNode = [self.testParser parseString:testString error:nil];
+
+    XCTAssertEqualObjects([LSParser debugParsedString:rootNode], expectedString, @"Close tag is swallowed by a dropped tag!");
+}
+
+- (void)testParsePathologicalMarkupBoundsNodeCount
+{
+    // every close tag reopens the inner tags, the open tags are nested deeper with every repetition
+    NSArray *pathologicalLines = @[@"[b][i][u]x[/b]", @"[a][b][c][d][e][f][g][h]x[/a]", @"[/b][/i]x[b]"];
+
+    self.testParser.maximumTagDepth = 4;
+
+    for (NSString *pathologicalLine in pathologicalLines) {
+        NSString *testString = [@"" stringByPaddingToLength:pathologicalLine.length * 200 withString:pathologicalLine startingAtIndex:0];
+        LSTokenBuffer *tokenBuffer = [self.testParser scanTokens:testString error:nil];
+        LSNodeTree *nodeTree = [self.testParser parseNodeTreeFromString:testString error:nil];
+
+        NSUInteger closeTagCount = 0;
+        for (NSUInteger index = 0; index < tokenBuffer.count; index++) {
+            closeTagCount += (tokenBuffer.tokens[index].type == LSTokenTypeCloseTag) ? 1 : 0;
+        }
+
+        // a token adds at most one node besides the root, a close tag reopens at most the other open tags
+        NSUInteger nodeBound = 1 + tokenBuffer.count + closeTagCount * (self.testParser.maximumTagDepth - 1);
+
+        XCTAssertNotNil(nodeTree, @"Pathological markup %@ isn't parsed!", pathologicalLine);
+        XCTAssert(nodeTree.count <= nodeBound, @"Node count of %@ exceeds the documented bound!", pathologicalLine);
+    }
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+
+- (void)testDetachedNodesKeepTheirProperties
+{
+    LSNode *rootNode = [LSNode nodeWithTagName:@"root" andContent:nil andAttributes:nil];
+    LSNode *childNode = [rootNode nodeFromParentNode:@"b" andContent:@"bold" andAttributes:@{@"b" : @"x"}];
+    [rootNode addChildNode:childNode];
+
+    XCTAssertEqualObjects(childNode.tagNames, (@[@"root", @"b"]), @"Tag names of the parent aren't extended!");
+    XCTAssertEqualObjects(childNode.content, @"bold", @"Content isn't kept!");
+    XCTAssertEqual(childNode.parentNode, rootNode, @"Parent node isn't set!");
+    XCTAssertEqualObjects(rootNode.children, @[childNode], @"Child node isn't added!");
+}
+
+#pragma clang diagnostic pop
+
+- (void)testSettingPropertyOfTreeNodeDetachesIt
+{
+    LSNode *rootNode = [self.testParser parseString:@"[b]one[/b] two" error:nil];
+    LSNode *boldNode = rootNode.children.firstObject;
+    LSNode *contentNode = boldNode.children.firstObject;
+
+    contentNode.content = @"three";
+
+    XCTAssertEqualObjects(contentNode.content, @"three", @"Content of the tree node isn't set!");
+    XCTAssertEqualObjects(contentNode.tagNames, (@[@"ROOT", @"b"]), @"Tag names aren't kept when detaching!");
+    XCTAssertEqualObjects([contentNode.tree nodeObjectAtIndex:contentNode.index].content, @"one", @"The tree is changed!");
+}
+
+- (void)testChangingTagNamesOfTreeNodeKeepsChanges
+{
+    LSNode *rootNode = [self.testParser parseString:@"[b]one[/b] two" error:nil];
+    LSNode *contentNode = [rootNode.children.firstObject children].firstObject;
+
+    [contentNode.tagNames addObject:@"i"];
+
+    XCTAssertEqualObjects(contentNode.tagNames, (@[@"ROOT", @"b", @"i"]), @"Added tag name is discarded!");
+
+    [contentNode.tagNames removeObject:@"b"];
+
+    XCTAssertEqualObjects(contentNode.tagNames, (@[@"ROOT", @"i"]), @"Removed tag name is still there!");
+}
+
 @end
@@ -0,0 +1,121 @@
+//
+//  LSStreamParserTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "LSStreamParser.h"
+#import "LSLexer.h"
+
+@interface LSStreamParserTests : XCTestCase <LSStreamParserDelegate>
+
+@property (nonatomic, strong) NSString *testString;
+@property (nonatomic, strong) NSMutableString *events;
+@property (nonatomic, strong) NSMutableString *content;
+
+@end
+
+@implementation LSStreamParserTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testString = @"this is [b][i][u id=\"bla\" img=\"http:://blablub.de\"]just another \n 3 and 4 € [/u][/u]rich [/i]text [/b][s]formatted[/s]  dough!";
+    self.events = [NSMutableString string];
+    self.content = [NSMutableString string];
+}
+
+#pragma mark - LSStreamParserDelegate
+
+- (void)streamParser:(LSStreamParser *)streamParser foundContent:(NSString *)content
+{
+    [self.content appendString:content];
+}
+
+- (void)streamParser:(LSStreamParser *)streamParser didOpenTag:(NSString *)tagName withAttributes:(NSDictionary *)attributes
+{
+    [self.events appendFormat:@":%@-%@%@:", @"open", tagName, attributes ? @"+" : @""];
+}
+
+- (void)streamParser:(LSStreamParser *)streamParser didCloseTag:(NSString *)tagName
+{
+    [self.events appendFormat:@":%@-%@:", @"close", tagName];
+}
+
+#pragma mark - tests
+
+- (void)testParseDataInChunks
+{
+    NSData *testData = [self.testString dataUsingEncoding:NSUTF8StringEncoding];
+
+    LSStreamParser *parser = [[LSStreamParser alloc] initWithDelegate:self];
+    XCTAssert([parser parseData:testData error:nil], @"Markup isn't parsed!");
+    XCTAssert([parser finishWithError:nil], @"Markup isn't finished!");
+
+    NSString *expectedEvents = [self.events copy];
+    NSString *expectedContent = [self.content copy];
+
+    XCTAssertEqualObjects(expectedEvents, @":open-b::open-i::open-u+::close-u::close-i::close-b::open-s::close-s:", @"Stream parser events aren't correct!");
+    XCTAssertEqualObjects(expectedContent, @"this is just another \n 3 and 4 € rich text formatted  dough!", @"Stream parser content isn't correct!");
+
+    // every chunk size splits tags and the multibyte € sign at least once
+    for (NSUInteger chunkSize = 1; chunkSize < 16; chunkSize++) {
+        self.events = [NSMutableString string];
+        self.content = [NSMutableString string];
+        parser = [[LSStreamParser alloc] initWithDelegate:self];
+
+        for (NSUInteger location = 0; location < testData.length; location += chunkSize) {
+            NSData *chunk = [testData subdataWithRange:NSMakeRange(location, MIN(chunkSize, testData.length - location))];
+            XCTAssert([parser parseData:chunk error:nil], @"Markup chunk isn't parsed!");
+        }
+        XCTAssert([parser finishWithError:nil], @"Markup isn't finished!");
+
+        XCTAssertEqualObjects(self.events, expectedEvents, @"Stream parser events differ for chunk size %lu!", (unsigned long)chunkSize);
+        XCTAssertEqualObjects(self.content, expectedContent, @"Stream parser content differs for chunk size %lu!", (unsigned long)chunkSize);
+    }
+}
+
+- (void)testParseStringReopensInnerTags
+{
+    LSStreamParser *parser = [[LSStreamParser alloc] initWithDelegate:self];
+
+    XCTAssert([parser parseString:@"[b]x[i]y[/b]z" error:nil], @"Markup isn't parsed!");
+    XCTAssertEqualObjects(parser.openTagNames, @[@"i"], @"Inner tag isn't open after closing the outer tag!");
+    XCTAssert([parser finishWithError:nil], @"Markup isn't finished!");
+
+    XCTAssertEqualObjects(self.events, @":open-b::open-i::close-i::close-b::open-i::close-i:", @"Stream parser events aren't correct!");
+    XCTAssertEqualObjects(self.content, @"xyz", @"Stream parser content isn't correct!");
+}
+
+- (void)testParseDroppedTagDoesNotSwallowLaterCloseTag
+{
+    LSStreamParser *parser = [[LSStreamParser alloc] initWithDelegate:self];
+    parser.maximumTagDepth = 1;
+
+    XCTAssert([parser parseString:@"[i][b]x[/i][b]y[/b]z" error:nil], @"Markup isn't parsed!");
+    XCTAssertEqualObjects(parser.openTagNames, @[], @"Close tag is swallowed by a dropped tag!");
+    XCTAssert([parser finishWithError:nil], @"Markup isn't finished!");
+
+    XCTAssertEqualObjects(self.events, @":open-i::close-i::open-b::close-b:", @"Stream parser events aren't correct!");
+}
+
+- (void)testParseMalformedMarkup
+{
+    NSError *error;
+    LSStreamParser *parser = [[LSStreamParser alloc] initWithDelegate:self];
+
+    XCTAssert([parser parseString:@"text [b" error:&error], @"Incomplete tag isn't kept for the next chunk!");
+    XCTAssertFalse([parser finishWithError:&error], @"Unterminated tag isn't reported!");
+    XCTAssertEqual(error.code, LSLexerErrorMalformedTag, @"Unterminated tag error isn't set!");
+
+    parser = [[LSStreamParser alloc] initWithDelegate:self];
+    parser.maximumTagLength = 8;
+
+    XCTAssertFalse([parser parseString:@"[url href=\"http://lshift.de\"]" error:&error], @"Long tag isn't reported!");
+    XCTAssertEqual(error.code, LSLexerErrorTagTooLong, @"Long tag error isn't set!");
+}
+
+@end
@@ -0,0 +1,132 @@
+//
+//  LSStyleRunBuilderTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "LSStyleRunBuilder.h"
+#import "LSUIKitStyleAdapter.h"
+
+@interface LSStyleRunBuilderTests : XCTestCase
+
+@property (nonatomic) NSAttributedString *testSourceText;
+@property (nonatomic) LSStyleRunBuilder *testRunBuilder;
+
+@end
+
+@implementation LSStyleRunBuilderTests
+
+- (void)setUp {
+    [super setUp];
+
+    UIFont *font = [UIFont fontWithName:@"Georgia" size:18];
+    self.testSourceText = [[NSAttributedString alloc] initWithString:@"[u]one[/u][u]two[/u] three"
+                                                          attributes:@{NSFontAttributeName : font}];
+    self.testRunBuilder = [[LSStyleRunBuilder alloc] initWithSourceText:self.testSourceText];
+}
+
+- (void)tearDown {
+    self.testRunBuilder = nil;
+    [super tearDown];
+}
+
+- (void)testAddRunMergesAdjacentRunsOfSameStyle
+{
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(3, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(13, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(20, 6) andStyle:LSBBCodeStyleNone];
+
+    XCTAssertEqual(self.testRunBuilder.runCount, 2, @"Adjacent runs of the same style aren't merged!");
+}
+
+- (void)testAddRunKeepsRunsOfDifferentContexts
+{
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(3, 3) andStyle:LSBBCodeStyleNone andContext:0];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(13, 3) andStyle:LSBBCodeStyleNone andContext:0];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(20, 6) andStyle:LSBBCodeStyleNone andContext:1];
+
+    XCTAssertEqual(self.testRunBuilder.runCount, 2, @"Runs of different contexts are merged!");
+}
+
+- (void)testAddRunIgnoresEmptyRuns
+{
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(3, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(6, 0) andStyle:LSBBCodeStyleNone];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(13, 3) andStyle:LSBBCodeStyleUnderlined];
+
+    XCTAssertEqual(self.testRunBuilder.runCount, 1, @"Empty run splits the styled runs!");
+}
+
+- (void)testAttributedStringHasMinimalRuns
+{
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(3, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(13, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(20, 6) andStyle:LSBBCodeStyleNone];
+
+    __block NSUInteger blockCalls = 0;
+    NSAttributedString *resultString = [LSUIKitStyleAdapter attributedStringFromRunBuilder:self.testRunBuilder
+                                                                     withAttributesForStyle:^NSDictionary *(LSBBCodeStyle style, NSUInteger context, UIFont *font) {
+        blockCalls++;
+        XCTAssertEqual(style, LSBBCodeStyleUnderlined, @"Unstyled run asks for attributes!");
+        XCTAssertNotNil(font, @"Source font isn't passed!");
+        return @{NSUnderlineStyleAttributeName : @(NSUnderlineStyleSingle)};
+    }];
+
+    XCTAssertEqualObjects(resultString.string, @"onetwo three", @"Run text isn't copied correctly!");
+    XCTAssertEqual(blockCalls, 1, @"Merged run isn't styled at once!");
+
+    NSRange effectiveRange;
+    NSDictionary *attributes = [resultString attributesAtIndex:0 longestEffectiveRange:&effectiveRange
+                                                       inRange:NSMakeRange(0, resultString.length)];
+
+    XCTAssertEqualObjects(attributes[NSUnderlineStyleAttributeName], @(NSUnderlineStyleSingle), @"Run isn't styled!");
+    XCTAssert(NSEqualRanges(effectiveRange, NSMakeRange(0, 6)), @"Merged run is split!");
+    XCTAssertNil([resultString attributesAtIndex:6 effectiveRange:nil][NSUnderlineStyleAttributeName], @"Unstyled run is styled!");
+}
+
+- (void)testAttributedStringStylesEverySourceFont
+{
+    NSMutableAttributedString *sourceText = [[NSMutableAttributedString alloc] initWithString:@"onetwo"
+                                                                                   attributes:@{NSFontAttributeName : [UIFont fontWithName:@"Georgia" size:18]}];
+    [sourceText addAttribute:NSFontAttributeName value:[UIFont fontWithName:@"Georgia" size:24] range:NSMakeRange(3, 3)];
+
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceText:sourceText];
+    [runBuilder addRunWithSourceRange:NSMakeRange(0, 6) andStyle:LSBBCodeStyleBold];
+
+    NSMutableArray *fontSizes = [NSMutableArray array];
+    [LSUIKitStyleAdapter attributedStringFromRunBuilder:runBuilder
+                                withAttributesForStyle:^NSDictionary *(LSBBCodeStyle style, NSUInteger context, UIFont *font) {
+        [fontSizes addObject:@(font.pointSize)];
+        return @{};
+    }];
+
+    XCTAssertEqualObjects(fontSizes, (@[@18, @24]), @"Fonts of the source text aren't kept!");
+}
+
+- (void)testStringContainsTextOfAllRuns
+{
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(3, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(13, 3) andStyle:LSBBCodeStyleUnderlined];
+    [self.testRunBuilder addRunWithSourceRange:NSMakeRange(20, 6) andStyle:LSBBCodeStyleNone];
+
+    XCTAssertEqualObjects([self.testRunBuilder string], @"onetwo three", @"Run text isn't copied correctly!");
+}
+
+- (void)testSerializeWritesMergedRuns
+{
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:@"[b]one[/b] [b]two[/b]"];
+    [runBuilder addRunWithSourceRange:NSMakeRange(3, 3) andStyle:LSBBCodeStyleBold];
+    [runBuilder addRunWithSourceRange:NSMakeRange(10, 1) andStyle:LSBBCodeStyleNone];
+    [runBuilder addRunWithSourceRange:NSMakeRange(14, 3) andStyle:LSBBCodeStyleBold];
+
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] init];
+    [runBuilder serializeWithSerializer:serializer];
+    [serializer finishWithError:nil];
+
+    XCTAssertEqualObjects(serializer.string, @"[b]one[/b] [b]two[/b]", @"Runs aren't serialized with their styles!");
+}
+
+@end
@@ -0,0 +1,108 @@
+//
+//  LSStyleRunCollectorTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "LSStyleRunCollector.h"
+#import "LSStyleRunBuilder.h"
+#import "LSTagRegistry.h"
+#import "LSParser.h"
+
+@interface LSStyleRunCollectorTests : XCTestCase
+
+@property (nonatomic) LSTagRegistry *testTagRegistry;
+
+@end
+
+@implementation LSStyleRunCollectorTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testTagRegistry = [[LSTagRegistry alloc] init];
+}
+
+- (void)tearDown {
+    self.testTagRegistry = nil;
+    [super tearDown];
+}
+
+- (LSStyleRunCollector *)collectRunsOfString:(NSString *)string intoBuilder:(LSStyleRunBuilder *)runBuilder withStyles:(BOOL)collectsStyles
+{
+    LSParser *parser = [LSParser new];
+    parser.tagRegistry = self.testTagRegistry;
+
+    LSNodeTree *nodeTree = [parser parseNodeTreeFromString:string error:nil];
+    LSStyleRunCollector *collector = [[LSStyleRunCollector alloc] initWithNodeTree:nodeTree andTagRegistry:self.testTagRegistry];
+    collector.collectsStyles = collectsStyles;
+
+    [collector collectRunsIntoBuilder:runBuilder];
+
+    return collector;
+}
+
+- (void)testCollectRunsCombinesStylesOfTagPath
+{
+    NSString *markup = @"[b]one[i]two[/i][/b]three";
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:markup];
+    [self collectRunsOfString:markup intoBuilder:runBuilder withStyles:YES];
+
+    NSMutableArray *styles = [NSMutableArray array];
+    [runBuilder enumerateRunsUsingBlock:^(NSRange range, LSBBCodeStyle style, NSUInteger context, BOOL *stop) {
+        [styles addObject:@(style)];
+    }];
+
+    XCTAssertEqualObjects([runBuilder string], @"onetwothree", @"Content isn't collected!");
+    XCTAssertEqualObjects(styles, (@[@(LSBBCodeStyleBold), @(LSBBCodeStyleBold | LSBBCodeStyleItalic), @(LSBBCodeStyleNone)]),
+                          @"Styles of the tag paths aren't combined!");
+}
+
+- (void)testCollectRunsAddsHandlerTagsToTagContext
+{
+    LSTagHandler handler = ^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {};
+    NSUInteger colorID = [self.testTagRegistry registerTagName:@"color" withStyle:LSBBCodeStyleNone andHandler:handler];
+
+    NSString *markup = @"[color=red]one[/color] [color=red]two[/color]";
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:markup];
+    LSStyleRunCollector *collector = [self collectRunsOfString:markup intoBuilder:runBuilder withStyles:YES];
+
+    XCTAssertEqual(collector.tagContexts.count, 1, @"Equal tag contexts aren't shared!");
+    XCTAssertEqualObjects(collector.tagContexts[0][0][0], @(colorID), @"Handler tag isn't part of the tag context!");
+    XCTAssertEqualObjects(collector.tagContexts[0][0][1], @{@"color" : @"red"}, @"Tag attributes aren't kept!");
+    XCTAssertEqual(runBuilder.runCount, 3, @"Runs of the tag context aren't separated from plain text!");
+}
+
+- (void)testCollectRunsWithoutStyles
+{
+    NSString *markup = @"[b]one[/b][u]two[/u]";
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:markup];
+    LSStyleRunCollector *collector = [self collectRunsOfString:markup intoBuilder:runBuilder withStyles:NO];
+
+    XCTAssertEqual(runBuilder.runCount, 1, @"Plain text runs aren't merged!");
+    XCTAssertEqual(collector.tagContexts.count, 0, @"Plain text has tag contexts!");
+}
+
+- (void)testNormalizedMarkupMergesRunsAndDropsUnknownTags
+{
+    NSError *error;
+    NSString *markup = [LSStyleRunCollector normalizedMarkupFromString:@"[b]one[/b][b]two[/b] [x]three[/x]"
+                                                       withTagRegistry:nil
+                                                                 error:&error];
+
+    XCTAssertNil(error, @"Valid markup fails!");
+    XCTAssertEqualObjects(markup, @"[b]onetwo[/b] three", @"Markup isn't normalized!");
+}
+
+- (void)testNormalizedMarkupFailsForMalformedTags
+{
+    NSError *error;
+    NSString *markup = [LSStyleRunCollector normalizedMarkupFromString:@"one [b two" withTagRegistry:nil error:&error];
+
+    XCTAssertNil(markup, @"Malformed markup is normalized!");
+    XCTAssertNotNil(error, @"Malformed markup doesn't set an error!");
+}
+
+@end
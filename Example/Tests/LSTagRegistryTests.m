@@ -0,0 +1,97 @@
+//
+//  LSTagRegistryTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+#import "LSTagRegistry.h"
+#import "LSParser.h"
+#import "LSBBCodeSerializer.h"
+
+@interface LSTagRegistryTests : XCTestCase
+
+@property (nonatomic) LSTagRegistry *testTagRegistry;
+
+@end
+
+@implementation LSTagRegistryTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.testTagRegistry = [[LSTagRegistry alloc] init];
+}
+
+- (void)tearDown {
+    self.testTagRegistry = nil;
+    [super tearDown];
+}
+
+- (void)testInitRegistersStyleTags
+{
+    XCTAssertEqual(self.testTagRegistry.count, 4, @"Style tags aren't registered!");
+    XCTAssertEqualObjects([self.testTagRegistry tagNameForStyle:LSBBCodeStyleBold], @"b", @"Bold tag isn't registered!");
+    XCTAssertEqual([self.testTagRegistry styleForID:[self.testTagRegistry tagIDForName:@"u"]], LSBBCodeStyleUnderlined, @"Underline style isn't registered!");
+    XCTAssertNil([self.testTagRegistry handlerForID:[self.testTagRegistry tagIDForName:@"i"]], @"Style tags have a handler!");
+}
+
+- (void)testRegisterTagNameLooksUpTags
+{
+    LSTagHandler handler = ^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {};
+
+    NSUInteger colorID = [self.testTagRegistry registerTagName:@"color" withStyle:LSBBCodeStyleNone andHandler:handler];
+    NSUInteger codeID = [self.testTagRegistry registerTagName:@"code" withStyle:LSBBCodeStyleNone andHandler:handler];
+
+    XCTAssertNotEqual(colorID, codeID, @"Tags sharing the first character share an ID!");
+    XCTAssertEqual([self.testTagRegistry tagIDForName:@"color"], colorID, @"Tag ID isn't found!");
+    XCTAssertEqual([self.testTagRegistry tagIDForName:@"code"], codeID, @"Tag ID isn't found!");
+    XCTAssertEqual([self.testTagRegistry tagIDForName:@"col"], NSNotFound, @"Unknown tag is found!");
+    XCTAssertEqualObjects([self.testTagRegistry tagNameForID:codeID], @"code", @"Tag name isn't correct!");
+    XCTAssertNotNil([self.testTagRegistry handlerForID:codeID], @"Tag handler isn't registered!");
+    XCTAssertEqual([self.testTagRegistry registerTagName:@"code" withStyle:LSBBCodeStyleNone andHandler:nil], codeID, @"Registering a tag again changes its ID!");
+    XCTAssertNil([self.testTagRegistry handlerForID:codeID], @"Tag handler isn't replaced!");
+}
+
+- (void)testParserUsesTagIDsAsTagIndexes
+{
+    NSUInteger quoteID = [self.testTagRegistry registerTagName:@"quote" withStyle:LSBBCodeStyleNone andHandler:nil];
+    LSParser *parser = [[LSParser alloc] init];
+    parser.tagRegistry = self.testTagRegistry;
+
+    LSNodeTree *nodeTree = [parser parseNodeTreeFromString:@"[x]a[/x][quote]b[/quote]" error:nil];
+    LSNodeRecord rootNode = [nodeTree nodeAtIndex:nodeTree.rootIndex];
+    LSNodeRecord unknownNode = [nodeTree nodeAtIndex:rootNode.firstChild];
+    LSNodeRecord quoteNode = [nodeTree nodeAtIndex:unknownNode.nextSibling];
+
+    XCTAssertEqual(nodeTree.registeredTagCount, self.testTagRegistry.count, @"Registered tags aren't interned!");
+    XCTAssertEqual(quoteNode.tagIndex, quoteID, @"Tag index isn't the tag ID!");
+    XCTAssert(unknownNode.tagIndex >= nodeTree.registeredTagCount, @"Unknown tag has a tag ID!");
+}
+
+- (void)testParserScansTagValue
+{
+    LSParser *parser = [[LSParser alloc] init];
+
+    LSToken *token = [parser scanOpenTagValue:@"url=http://lshift.de/?a=b"];
+
+    XCTAssertEqualObjects(token.value, @"url", @"Tag name isn't correct!");
+    XCTAssertEqualObjects(token.attributes, @{@"url" : @"http://lshift.de/?a=b"}, @"Tag value isn't correct!");
+    XCTAssertEqualObjects([parser scanOpenTagValue:@"quote name=peter"].value, @"quote", @"Tag name isn't correct!");
+}
+
+- (void)testSerializerWritesRegisteredTagNames
+{
+    [self.testTagRegistry registerTagName:@"b" withStyle:LSBBCodeStyleNone andHandler:nil];
+    [self.testTagRegistry registerTagName:@"strong" withStyle:LSBBCodeStyleBold andHandler:nil];
+
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:nil andTagRegistry:self.testTagRegistry];
+    [serializer appendCharactersOfString:@"bold" inRange:NSMakeRange(0, 4) withStyle:LSBBCodeStyleBold | LSBBCodeStyleItalic];
+    [serializer finishWithError:nil];
+
+    XCTAssertEqualObjects(serializer.string, @"[i][strong]bold[/strong][/i]", @"Registered tag names aren't written!");
+}
+
+@end
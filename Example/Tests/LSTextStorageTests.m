@@ -10,6 +10,8 @@
 #import <XCTest/XCTest.h>
 #import "LSTextStorage.h"
 #import "LSRichTextView.h"
+#import "LSRopeAttributedString.h"
+#import "LSDocumentSnapshot.h"
 #import <OCMock/OCMock.h>
 
 @interface LSTextStorageTests : XCTestCase
@@ -48,6 +50,8 @@
 
     LSRichTextConfiguration *configuration = [OCMockObject mockForClass:[LSRichTextConfiguration class]];
     OCMStub([configuration configurationFeatures]).andReturn(LSRichTextFeaturesAll);
+    OCMStub([configuration fontCache]).andReturn([[LSFontTraitCache alloc] init]);
+    OCMStub([configuration tagRegistry]).andReturn([[LSTagRegistry alloc] init]);
 
     self.testTextView = [OCMockObject niceMockForClass:[LSRichTextView class]];
     OCMStub([self.testTextView font]).andReturn(self.testPreconditionFont);
@@ -130,6 +134,617 @@
     [self verifyFontNotChanged];
 }
 
+- (void)testApplyStylesToRangeRepeatedContent
+{
+    NSString *inputString = @"abc [b]abc[/b]";
+    NSString *expectedString = @"abc abc";
+    NSMutableAttributedString *inString = [[NSMutableAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    [inString addAttribute:NSForegroundColorAttributeName value:[UIColor redColor] range:NSMakeRange(7, 3)];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, expectedString, @"TextStorage backing string result string isn't correct!");
+    XCTAssertNil([self.testTextStorage attribute:NSForegroundColorAttributeName atIndex:0 effectiveRange:nil],
+                 @"Source attributes of the first occurrence aren't preserved!");
+    XCTAssertEqualObjects([self.testTextStorage attribute:NSForegroundColorAttributeName atIndex:4 effectiveRange:nil], [UIColor redColor],
+                          @"Source attributes of the second occurrence aren't preserved!");
+}
+
+- (void)testApplyStylesToRangeManyLines
+{
+    NSString *markupLine = @"Lorem [b]ipsum [i]dolor[/i] sit[/b] amet, [u]consectetur[/u] adipiscing elit.\n";
+    NSString *styledLine = @"Lorem ipsum dolor sit amet, consectetur adipiscing elit.\n";
+    NSMutableString *inputString = [NSMutableString string];
+    NSMutableString *expectedString = [NSMutableString string];
+
+    for (NSUInteger line = 0; line < 1000; line++) {
+        [inputString appendString:markupLine];
+        [expectedString appendString:styledLine];
+    }
+
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, expectedString, @"TextStorage backing string isn't correct!");
+
+    // the last line is styled like the first one
+    NSUInteger lastLineLocation = expectedString.length - styledLine.length;
+    XCTAssertEqual([self.testTextStorage styleOfAttributes:[self.testTextStorage attributesAtIndex:lastLineLocation + 12 effectiveRange:nil]],
+                   LSBBCodeStyleBold | LSBBCodeStyleItalic, @"Nested styles of the last line aren't correct!");
+    XCTAssertEqual([self.testTextStorage styleOfAttributes:[self.testTextStorage attributesAtIndex:lastLineLocation + 28 effectiveRange:nil]],
+                   LSBBCodeStyleUnderlined, @"Underline of the last line isn't correct!");
+}
+
+- (void)testApplyStylesToRangeRopeBackingStore
+{
+    NSString *inputString = @"This [b]is our[/b] [i]input string[/i]";
+    NSString *expectedString = @"This is our input string";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    self.testTextStorage = [[LSTextStorage alloc] initWithTextView:self.testTextView andBackingStore:[LSRopeAttributedString new]];
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, expectedString, @"TextStorage rope string result string isn't correct!");
+
+    UIFont *font = [self.testTextStorage attributesAtIndex:8 effectiveRange:nil][NSFontAttributeName];
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitBold, @"TextStorage rope string isn't styled!");
+}
+
+- (void)testApplyStylesToRangeMergesAdjacentRuns
+{
+    NSString *inputString = @"[b]This is[/b][b] our[/b] input";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    NSRange effectiveRange;
+    [self.testTextStorage attributesAtIndex:0 longestEffectiveRange:&effectiveRange inRange:NSMakeRange(0, self.testTextStorage.length)];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, @"This is our input", @"TextStorage backing string isn't correct!");
+    XCTAssert(NSEqualRanges(effectiveRange, NSMakeRange(0, 11)), @"Adjacent bold runs aren't merged!");
+}
+
+- (void)testApplyStylesToRangeSharesAttributesOfEqualStyles
+{
+    NSString *inputString = @"[b]one[/b] two [b]three[/b] [i]four[/i]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    NSDictionary *firstBoldAttributes = [self.testTextStorage attributesAtIndex:0 effectiveRange:nil];
+    NSDictionary *secondBoldAttributes = [self.testTextStorage attributesAtIndex:8 effectiveRange:nil];
+    NSDictionary *italicAttributes = [self.testTextStorage attributesAtIndex:14 effectiveRange:nil];
+
+    XCTAssertEqual(firstBoldAttributes, secondBoldAttributes, @"Runs of the same style don't share their attributes!");
+    XCTAssertNotEqual(firstBoldAttributes, italicAttributes, @"Runs of different styles share their attributes!");
+}
+
+- (void)testStyleOfAttributesOfStyledRuns
+{
+    NSString *inputString = @"[b]one[/b] [i][u]two[/u][/i] three";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    NSDictionary *boldAttributes = [self.testTextStorage attributesAtIndex:0 effectiveRange:nil];
+
+    XCTAssertEqual([self.testTextStorage styleOfAttributes:boldAttributes], LSBBCodeStyleBold, @"Bold style isn't found!");
+    XCTAssertEqual([self.testTextStorage styleOfAttributes:[self.testTextStorage attributesAtIndex:4 effectiveRange:nil]],
+                   LSBBCodeStyleItalic | LSBBCodeStyleUnderlined, @"Nested styles aren't found!");
+    XCTAssertEqual([self.testTextStorage styleOfAttributes:[self.testTextStorage attributesAtIndex:8 effectiveRange:nil]],
+                   LSBBCodeStyleNone, @"Plain text has a style!");
+    XCTAssertEqual([self.testTextStorage styleOfAttributes:boldAttributes], LSBBCodeStyleBold, @"Cached style isn't correct!");
+}
+
+- (void)testStyleInRangeOfMixedRuns
+{
+    NSString *inputString = @"[b]one [i]two[/i][/b] three";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    LSBBCodeStyle mixedStyle;
+    LSBBCodeStyle style = [self.testTextStorage styleInRange:NSMakeRange(0, 7) mixedStyle:&mixedStyle];
+
+    XCTAssertEqual(style, LSBBCodeStyleBold, @"Common style of the range isn't correct!");
+    XCTAssertEqual(mixedStyle, LSBBCodeStyleItalic, @"Mixed style of the range isn't correct!");
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleBold inRange:NSMakeRange(0, 7)], LSStyleStateOn, @"Bold isn't on!");
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleItalic inRange:NSMakeRange(0, 7)], LSStyleStateMixed, @"Italic isn't mixed!");
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleBold inRange:NSMakeRange(0, 13)], LSStyleStateMixed, @"Bold isn't mixed!");
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleUnderlined inRange:NSMakeRange(0, 13)], LSStyleStateOff, @"Underline isn't off!");
+}
+
+- (void)testApplyTraitChangeToMixedRangeKeepsOtherTraits
+{
+    NSString *inputString = @"[i]one[/i] [b]two[/b]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+    [self.testTextStorage applyTraitChangeToRange:NSMakeRange(0, 7) andTraitValue:UIFontDescriptorTraitBold];
+
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleBold inRange:NSMakeRange(0, 7)], LSStyleStateOn, @"Bold isn't added to all runs!");
+    XCTAssertEqual([self.testTextStorage styleInRange:NSMakeRange(0, 3) mixedStyle:NULL], LSBBCodeStyleBold | LSBBCodeStyleItalic,
+                   @"Italic of the first run isn't kept!");
+
+    [self.testTextStorage applyTraitChangeToRange:NSMakeRange(0, 7) andTraitValue:UIFontDescriptorTraitBold];
+
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleBold inRange:NSMakeRange(0, 7)], LSStyleStateOff, @"Bold isn't removed from all runs!");
+    XCTAssertEqual([self.testTextStorage styleInRange:NSMakeRange(0, 3) mixedStyle:NULL], LSBBCodeStyleItalic, @"Italic of the first run isn't kept!");
+}
+
+- (void)testApplyUnderlineChangeToRangeIsOneEdit
+{
+    NSString *inputString = @"[u]one[/u] [b]two[/b] [i]three[/i]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    __block NSUInteger editCount = 0;
+    id textStorageDelegate = OCMProtocolMock(@protocol(NSTextStorageDelegate));
+    OCMStub([textStorageDelegate textStorage:[OCMArg any] didProcessEditing:NSTextStorageEditedAttributes
+                                       range:NSMakeRange(0, self.testTextStorage.length) changeInLength:0])
+        .andDo(^(NSInvocation *invocation) { editCount++; });
+    self.testTextStorage.delegate = textStorageDelegate;
+
+    [self.testTextStorage applyUnderlineChangeToRange:NSMakeRange(0, self.testTextStorage.length)
+                                andStyleAttributeName:NSUnderlineStyleAttributeName];
+
+    XCTAssertEqual(editCount, 1, @"Runs aren't changed in one edit!");
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleUnderlined inRange:NSMakeRange(0, self.testTextStorage.length)],
+                   LSStyleStateOn, @"Underline isn't added to all runs!");
+    XCTAssertEqual([self.testTextStorage styleInRange:NSMakeRange(4, 3) mixedStyle:NULL], LSBBCodeStyleBold | LSBBCodeStyleUnderlined,
+                   @"Bold of the second run isn't kept!");
+}
+
+- (void)testFormattingTransactionCommitsMergedRangeOnce
+{
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"just another rich text" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    __block NSUInteger editCount = 0;
+    id textStorageDelegate = OCMProtocolMock(@protocol(NSTextStorageDelegate));
+    OCMStub([textStorageDelegate textStorage:[OCMArg any] didProcessEditing:NSTextStorageEditedAttributes
+                                       range:NSMakeRange(2, 15) changeInLength:0])
+        .andDo(^(NSInvocation *invocation) { editCount++; });
+    self.testTextStorage.delegate = textStorageDelegate;
+
+    NSDictionary *underlinedAttributes = @{NSFontAttributeName:self.testPreconditionFont, NSUnderlineStyleAttributeName:@(NSUnderlineStyleSingle)};
+
+    [self.testTextStorage performFormattingTransaction:^{
+        [self.testTextStorage setAttributes:underlinedAttributes range:NSMakeRange(2, 3)];
+
+        [self.testTextStorage beginFormattingTransaction];
+        [self.testTextStorage setAttributes:underlinedAttributes range:NSMakeRange(13, 4)];
+        [self.testTextStorage commitFormattingTransaction];
+
+        XCTAssertTrue(self.testTextStorage.isInFormattingTransaction, @"Nested commit closed the transaction!");
+        XCTAssertEqual(editCount, 0, @"Edits are processed before the transaction is committed!");
+    }];
+
+    XCTAssertFalse(self.testTextStorage.isInFormattingTransaction, @"Transaction isn't closed!");
+    XCTAssertEqual(editCount, 1, @"Edits of the transaction aren't processed once in the merged range!");
+    XCTAssertEqual([self.testTextStorage stateOfStyle:LSBBCodeStyleUnderlined inRange:NSMakeRange(13, 4)], LSStyleStateOn,
+                   @"Attributes of the transaction aren't set!");
+}
+
+- (void)testFormattingTransactionShiftsRangesOfReplacedCharacters
+{
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"just another rich text" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    [self.testTextStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    __block NSRange processedRange = NSMakeRange(NSNotFound, 0);
+    id textStorageDelegate = OCMProtocolMock(@protocol(NSTextStorageDelegate));
+    OCMStub([textStorageDelegate textStorage:[OCMArg any] didProcessEditing:NSTextStorageEditedAttributes | NSTextStorageEditedCharacters
+                                       range:NSMakeRange(0, 0) changeInLength:0])
+        .ignoringNonObjectArgs()
+        .andDo(^(NSInvocation *invocation) { [invocation getArgument:&processedRange atIndex:4]; });
+    self.testTextStorage.delegate = textStorageDelegate;
+
+    NSDictionary *boldAttributes = @{NSFontAttributeName:[UIFont boldSystemFontOfSize:18]};
+
+    [self.testTextStorage performFormattingTransaction:^{
+        [self.testTextStorage setAttributes:boldAttributes range:NSMakeRange(18, 4)];
+        [self.testTextStorage replaceCharactersInRange:NSMakeRange(0, 5) withString:@""];
+    }];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, @"another rich text", @"Characters aren't replaced!");
+    XCTAssertEqualObjects([self.testTextStorage attributesAtIndex:13 effectiveRange:nil][NSFontAttributeName], [UIFont boldSystemFontOfSize:18],
+                          @"Attributes aren't kept at the shifted range!");
+    XCTAssert(NSEqualRanges(processedRange, NSMakeRange(0, 17)), @"Edited range doesn't cover the shifted attribute range!");
+}
+
+- (void)testApplyStylesToRangeTagHandlers
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    [configuration.tagRegistry registerTagName:@"mark" withStyle:LSBBCodeStyleNone andHandler:^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {
+        attributes[NSBackgroundColorAttributeName] = [UIColor yellowColor];
+    }];
+
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+    NSString *inputString = @"[color=#ff0000]red [b][size=30]big[/size][/b][/color] [mark]marked[/mark] [url=http://lshift.de]link[/url]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    XCTAssertEqualObjects(textStorage.string, @"red big marked link", @"Handler tags aren't removed!");
+
+    UIColor *color = [textStorage attributesAtIndex:0 effectiveRange:nil][NSForegroundColorAttributeName];
+    CGFloat red, green, blue, alpha;
+    [color getRed:&red green:&green blue:&blue alpha:&alpha];
+    XCTAssert(red == 1.0 && green == 0.0 && blue == 0.0, @"Color tag isn't styled!");
+
+    UIFont *font = [textStorage attributesAtIndex:4 effectiveRange:nil][NSFontAttributeName];
+    XCTAssertEqual(font.pointSize, 30, @"Size tag isn't styled!");
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitBold, @"Size tag loses the bold style!");
+    XCTAssertNotNil([textStorage attributesAtIndex:5 effectiveRange:nil][NSForegroundColorAttributeName], @"Nested tag loses the color!");
+
+    XCTAssertEqualObjects([textStorage attributesAtIndex:8 effectiveRange:nil][NSBackgroundColorAttributeName], [UIColor yellowColor], @"Custom tag isn't styled!");
+    XCTAssertEqualObjects([textStorage attributesAtIndex:15 effectiveRange:nil][NSLinkAttributeName], [NSURL URLWithString:@"http://lshift.de"], @"Url tag isn't styled!");
+    XCTAssertNil([textStorage attributesAtIndex:7 effectiveRange:nil][NSForegroundColorAttributeName], @"Color tag styles text after closing!");
+}
+
+- (void)testSetSnapshotStylesRunsWithoutParsing
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+
+    NSData *data = [LSDocumentSnapshot snapshotDataFromMarkup:@"[b]one[/b] [color=#ff0000]two[/color] [i]three[/i]"
+                                              withTagRegistry:configuration.tagRegistry error:nil];
+    LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:data andTagRegistry:configuration.tagRegistry error:nil];
+
+    [textStorage setSnapshot:snapshot];
+
+    XCTAssertEqualObjects(textStorage.string, @"one two three", @"Text of the snapshot isn't set!");
+    XCTAssertEqual([textStorage styleOfAttributes:[textStorage attributesAtIndex:0 effectiveRange:nil]], LSBBCodeStyleBold, @"Bold run isn't styled!");
+    XCTAssertNotNil([textStorage attributesAtIndex:4 effectiveRange:nil][NSForegroundColorAttributeName], @"Color tag isn't styled!");
+    XCTAssertEqual([textStorage styleOfAttributes:[textStorage attributesAtIndex:8 effectiveRange:nil]], LSBBCodeStyleItalic,
+                   @"Italic run isn't styled!");
+}
+
+- (void)testSnapshotDataKeepsStyles
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+    NSString *inputString = @"[b]one[/b] [i][u]two[/u][/i] three";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+
+    LSDocumentSnapshot *snapshot = [[LSDocumentSnapshot alloc] initWithData:[textStorage snapshotData]
+                                                             andTagRegistry:configuration.tagRegistry error:nil];
+    LSTextStorage *restoredTextStorage = [self createTextStorageWithConfiguration:configuration];
+    [restoredTextStorage setSnapshot:snapshot];
+
+    XCTAssertEqualObjects([restoredTextStorage createOutputString], [textStorage createOutputString], @"Snapshot doesn't keep the styles!");
+}
+
+- (void)testProcessEditingStylesCompletedTag
+{
+    NSString *inputString = @"first line\nThis [b]is bold";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage setAttributedString:inString];
+    NSDictionary *firstLineAttributes = [self.testTextStorage attributesAtIndex:6 effectiveRange:nil];
+
+    [self.testTextStorage replaceCharactersInRange:NSMakeRange(self.testTextStorage.length, 0) withString:@"[/b]"];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, @"first line\nThis is bold", @"Completed tag isn't converted while typing!");
+
+    UIFont *font = [self.testTextStorage attributesAtIndex:self.testTextStorage.length - 1 effectiveRange:nil][NSFontAttributeName];
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitBold, @"Completed tag isn't styled while typing!");
+    XCTAssertEqualObjects([self.testTextStorage attributesAtIndex:6 effectiveRange:nil], firstLineAttributes, @"Text outside the edited tag is restyled!");
+}
+
+- (void)testProcessEditingMovesCaretBehindStyledText
+{
+    NSString *inputString = @"This [b]is bold";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage setAttributedString:inString];
+    XCTAssertEqual([self.testTextStorage takePendingSelectedRange].location, NSNotFound, @"Selection is changed without a replacement!");
+
+    [self.testTextStorage replaceCharactersInRange:NSMakeRange(self.testTextStorage.length, 0) withString:@"[/b]"];
+
+    NSRange selectedRange = [self.testTextStorage takePendingSelectedRange];
+    XCTAssertEqual(selectedRange.location, self.testTextStorage.length, @"Caret isn't moved behind the styled text!");
+    XCTAssertEqual(selectedRange.length, 0, @"Caret is turned into a selection!");
+    XCTAssertEqual([self.testTextStorage takePendingSelectedRange].location, NSNotFound, @"Pending selection isn't reset!");
+}
+
+- (void)testProcessEditingStylesTagInLineWithUnterminatedTag
+{
+    NSString *inputString = @"This [b]is bold and [ more";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage setAttributedString:inString];
+    [self.testTextStorage replaceCharactersInRange:NSMakeRange(15, 0) withString:@"[/b]"];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, @"This is bold and [ more", @"Unterminated tag stops converting completed tags!");
+
+    UIFont *font = [self.testTextStorage attributesAtIndex:9 effectiveRange:nil][NSFontAttributeName];
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitBold, @"Completed tag isn't styled while typing!");
+}
+
+- (void)testProcessEditingKeepsIncompleteTags
+{
+    NSString *inputString = @"This [b]is";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [self.testTextStorage setAttributedString:inString];
+    [self.testTextStorage replaceCharactersInRange:NSMakeRange(self.testTextStorage.length, 0) withString:@" bold"];
+
+    XCTAssertEqualObjects(self.testTextStorage.string, @"This [b]is bold", @"Incomplete tag is converted while typing!");
+}
+
+- (void)testSetAttributedTextAsynchronously
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSString *inputString = @"This [b]is our[/b] [i]input string[/i]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"text set"];
+
+    [textStorage setAttributedText:inString completion:^(BOOL finished) {
+        XCTAssert([NSThread isMainThread], @"Completion isn't called on the main thread!");
+        XCTAssertTrue(finished, @"Text set asynchronously isn't finished!");
+        XCTAssertEqualObjects(textStorage.string, @"This is our input string", @"Text set asynchronously isn't styled!");
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testSetAttributedTextAsynchronouslyKeepsUnparsableMarkup
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSString *inputString = @"[b]bold[/b] and [i";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"text set"];
+
+    [textStorage setAttributedText:inString completion:^(BOOL finished) {
+        XCTAssertEqualObjects(textStorage.string, inputString, @"Markup failing to parse is styled on the main thread!");
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testSetAttributedTextAsynchronouslySuperseded
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSAttributedString *firstString = [[NSAttributedString alloc] initWithString:@"[b]first[/b]" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    NSAttributedString *secondString = [[NSAttributedString alloc] initWithString:@"[i]second[/i]" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+    XCTestExpectation *firstExpectation = [self expectationWithDescription:@"first text cancelled"];
+    XCTestExpectation *secondExpectation = [self expectationWithDescription:@"second text set"];
+
+    [textStorage setAttributedText:firstString completion:^(BOOL finished) {
+        XCTAssertFalse(finished, @"Superseded text is still set!");
+        [firstExpectation fulfill];
+    }];
+    [textStorage setAttributedText:secondString completion:^(BOOL finished) {
+        XCTAssertTrue(finished, @"Newest text isn't set!");
+        XCTAssertEqualObjects(textStorage.string, @"second", @"Newest text isn't styled!");
+        [secondExpectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqualObjects(textStorage.string, @"second", @"Superseded text overwrote the newest text!");
+}
+
+- (void)testStyleUnstyledTextInRangeStylesVisibleLinesFirst
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSString *inputString = @"[b]first[/b]\n[i]second[/i]\n[u]third[/u]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setUnstyledAttributedText:inString];
+
+    XCTAssertTrue(textStorage.hasUnstyledText, @"Text isn't marked as unstyled!");
+    XCTAssertEqualObjects(textStorage.string, inputString, @"Unstyled text is styled right away!");
+
+    NSRange styledRange = [textStorage styleUnstyledTextInRange:NSMakeRange(15, 2)];
+
+    XCTAssertEqualObjects(textStorage.string, @"[b]first[/b]\nsecond\n[u]third[/u]", @"Only the requested lines should be styled!");
+    XCTAssert(NSEqualRanges(styledRange, NSMakeRange(13, 7)), @"Styled range isn't correct!");
+
+    UIFont *font = [textStorage attributesAtIndex:13 effectiveRange:nil][NSFontAttributeName];
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitItalic, @"Requested lines aren't styled!");
+
+    while ([textStorage styleUnstyledChunkFromLocation:styledRange.location].location != NSNotFound);
+
+    XCTAssertFalse(textStorage.hasUnstyledText, @"Text is still marked as unstyled!");
+    XCTAssertEqualObjects(textStorage.string, @"first\nsecond\nthird", @"Remaining chunks aren't styled!");
+}
+
+- (void)testStyleUnstyledTextInRangeProcessesStyledChunkOnce
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"[b]first[/b]\n[i]second[/i]" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setUnstyledAttributedText:inString];
+
+    __block NSUInteger editCount = 0;
+    __block BOOL isStyledWhenProcessed = NO;
+    id textStorageDelegate = OCMProtocolMock(@protocol(NSTextStorageDelegate));
+    OCMStub([textStorageDelegate textStorage:[OCMArg any] didProcessEditing:NSTextStorageEditedAttributes | NSTextStorageEditedCharacters
+                                       range:NSMakeRange(0, 0) changeInLength:0])
+        .ignoringNonObjectArgs()
+        .andDo(^(NSInvocation *invocation) {
+            UIFont *font = [textStorage attributesAtIndex:13 effectiveRange:nil][NSFontAttributeName];
+            isStyledWhenProcessed = (font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitItalic) != 0;
+            editCount++;
+        });
+    textStorage.delegate = textStorageDelegate;
+
+    [textStorage styleUnstyledTextInRange:NSMakeRange(15, 2)];
+
+    XCTAssertEqual(editCount, 1, @"Styled chunk isn't processed in one edit!");
+    XCTAssertTrue(isStyledWhenProcessed, @"Edit is processed before the chunk is styled!");
+    XCTAssertEqualObjects(textStorage.string, @"[b]first[/b]\nsecond", @"Other lines are styled as well!");
+}
+
+- (void)testStyleUnstyledTextInRangeKeepsTagPairsTogether
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSString *inputString = @"plain\n[b]first\nsecond[/b]\n[i]third\nfourth[/i]";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setUnstyledAttributedText:inString];
+    [textStorage styleUnstyledTextInRange:NSMakeRange(16, 1)];
+    [textStorage styleUnstyledTextInRange:NSMakeRange(23, 1)];
+
+    XCTAssertEqualObjects(textStorage.string, @"plain\nfirst\nsecond\nthird\nfourth", @"Tag pairs spanning lines aren't styled together!");
+
+    UIFont *font = [textStorage attributesAtIndex:6 effectiveRange:nil][NSFontAttributeName];
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitBold, @"Open tag in front of the range isn't styled!");
+
+    font = [textStorage attributesAtIndex:textStorage.length - 1 effectiveRange:nil][NSFontAttributeName];
+    XCTAssert(font.fontDescriptor.symbolicTraits & UIFontDescriptorTraitItalic, @"Close tag behind the range isn't styled!");
+
+    XCTAssertFalse(textStorage.hasUnstyledText, @"Text is still marked as unstyled!");
+}
+
+- (void)testReplaceCharactersShiftsUnstyledText
+{
+    LSTextStorage *textStorage = [self createTextStorageWithRealConfiguration];
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"first\n[b]second[/b]" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setUnstyledAttributedText:inString];
+    [textStorage styleUnstyledTextInRange:NSMakeRange(0, 1)];
+    [textStorage replaceCharactersInRange:NSMakeRange(0, 5) withString:@"1"];
+    [textStorage styleUnstyledTextInRange:NSMakeRange(2, 1)];
+
+    XCTAssertEqualObjects(textStorage.string, @"1\nsecond", @"Unstyled text isn't moved with the edit!");
+    XCTAssertFalse(textStorage.hasUnstyledText, @"Text is still marked as unstyled!");
+}
+
+- (void)testProcessPendingDataDetectionScansEditedLinesOnly
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    configuration.textCheckingTypes = NSTextCheckingTypeLink;
+
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"visit http://lshift.de\nplain line" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setAttributedString:inString];
+    [textStorage processDataDetection];
+
+    XCTAssertFalse(textStorage.hasPendingDataDetection, @"Detected lines are still pending!");
+    XCTAssertNotNil([textStorage attributesAtIndex:6 effectiveRange:nil][NSLinkAttributeName], @"Link isn't detected!");
+
+    // without an edit the first line isn't scanned again, so the removed link stays removed
+    [textStorage removeAttribute:NSLinkAttributeName range:NSMakeRange(0, 22)];
+    [textStorage replaceCharactersInRange:NSMakeRange(textStorage.length, 0) withString:@" www.lshift.de"];
+
+    XCTAssertTrue(textStorage.hasPendingDataDetection, @"Edited line isn't pending!");
+
+    [textStorage processPendingDataDetection];
+
+    XCTAssertNil([textStorage attributesAtIndex:6 effectiveRange:nil][NSLinkAttributeName], @"Unedited line is scanned again!");
+    XCTAssertNotNil([textStorage attributesAtIndex:textStorage.length - 1 effectiveRange:nil][NSLinkAttributeName], @"Link in the edited line isn't detected!");
+}
+
+- (void)testProcessDataDetectionInternsLinkAttributes
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    configuration.textCheckingTypes = NSTextCheckingTypeLink;
+
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"http://lshift.de\nhttp://lshift.de" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setAttributedString:inString];
+    [textStorage processDataDetection];
+
+    NSDictionary *firstLinkAttributes = [textStorage attributesAtIndex:2 effectiveRange:nil];
+    NSDictionary *secondLinkAttributes = [textStorage attributesAtIndex:textStorage.length - 2 effectiveRange:nil];
+
+    XCTAssertNotNil(firstLinkAttributes[NSLinkAttributeName], @"Link isn't detected!");
+    XCTAssertEqual(firstLinkAttributes, secondLinkAttributes, @"Equal link attributes aren't interned!");
+}
+
+- (void)testProcessDataDetectionKeepsUrlTagLinks
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    configuration.textCheckingTypes = NSTextCheckingTypeLink;
+
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+    NSString *inputString = @"[url=http://lshift.de]www.lshift.de[/url] visit http://example.com";
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:inputString attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage applyStylesToRange:NSMakeRange(0, inString.length) withAttributedText:inString];
+    [textStorage processDataDetection];
+
+    NSURL *tagLink = [NSURL URLWithString:@"http://lshift.de"];
+    XCTAssertEqualObjects([textStorage attributesAtIndex:2 effectiveRange:nil][NSLinkAttributeName], tagLink, @"Url tag link is replaced by detection!");
+    XCTAssertEqualObjects([textStorage attributesAtIndex:textStorage.length - 1 effectiveRange:nil][NSLinkAttributeName], [NSURL URLWithString:@"http://example.com"], @"Link isn't detected!");
+
+    // scanning the line again only removes the detected links
+    [textStorage replaceCharactersInRange:NSMakeRange(textStorage.length, 0) withString:@" and more"];
+    [textStorage processPendingDataDetection];
+
+    XCTAssertEqualObjects([textStorage attributesAtIndex:2 effectiveRange:nil][NSLinkAttributeName], tagLink, @"Url tag link is removed by detection!");
+    XCTAssertNotNil([textStorage attributesAtIndex:25 effectiveRange:nil][NSLinkAttributeName], @"Link isn't detected again!");
+    XCTAssertNil([textStorage attributesAtIndex:textStorage.length - 1 effectiveRange:nil][NSLinkAttributeName], @"Detected link spreads into typed text!");
+}
+
+- (void)testDataDetectorIsCachedPerConfiguration
+{
+    LSRichTextConfiguration *linkConfiguration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    linkConfiguration.textCheckingTypes = NSTextCheckingTypeLink;
+    LSRichTextConfiguration *phoneConfiguration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    phoneConfiguration.textCheckingTypes = NSTextCheckingTypePhoneNumber;
+
+    NSDataDetector *linkDetector = linkConfiguration.dataDetector;
+
+    XCTAssertEqual(linkDetector.checkingTypes, NSTextCheckingTypeLink, @"Detector has the wrong checking types!");
+    XCTAssertEqual(phoneConfiguration.dataDetector.checkingTypes, NSTextCheckingTypePhoneNumber, @"Detector of another configuration is reused!");
+    XCTAssertEqual(linkConfiguration.dataDetector, linkDetector, @"Detector isn't cached!");
+    XCTAssertEqual([linkConfiguration copy].dataDetector, linkDetector, @"Detector isn't shared with copies!");
+
+    linkConfiguration.textCheckingTypes = NSTextCheckingTypeLink | NSTextCheckingTypePhoneNumber;
+
+    XCTAssertEqual(linkConfiguration.dataDetector.checkingTypes, NSTextCheckingTypeLink | NSTextCheckingTypePhoneNumber, @"Detector isn't recreated for new checking types!");
+}
+
+- (void)testProcessDataDetectionInBackground
+{
+    LSRichTextConfiguration *configuration = [[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll];
+    configuration.textCheckingTypes = NSTextCheckingTypeLink;
+    configuration.detectsDataInBackground = YES;
+
+    LSTextStorage *textStorage = [self createTextStorageWithConfiguration:configuration];
+    NSAttributedString *inString = [[NSAttributedString alloc] initWithString:@"visit http://lshift.de" attributes:@{NSFontAttributeName:self.testPreconditionFont}];
+
+    [textStorage setAttributedString:inString];
+    [textStorage processDataDetection];
+
+    XCTAssertNil([textStorage attributesAtIndex:6 effectiveRange:nil][NSLinkAttributeName], @"Link is set before the main thread is free!");
+
+    NSPredicate *linkDetected = [NSPredicate predicateWithBlock:^BOOL(LSTextStorage *storage, NSDictionary *bindings) {
+        return [storage attributesAtIndex:6 effectiveRange:nil][NSLinkAttributeName] != nil;
+    }];
+    [self expectationForPredicate:linkDetected evaluatedWithObject:textStorage handler:nil];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (LSTextStorage *)createTextStorageWithRealConfiguration
+{
+    // the configuration is copied for background parsing, so a real object is needed
+    return [self createTextStorageWithConfiguration:[[LSRichTextConfiguration alloc] initWithTextFeatures:LSRichTextFeaturesAll]];
+}
+
+- (LSTextStorage *)createTextStorageWithConfiguration:(LSRichTextConfiguration *)configuration
+{
+    LSRichTextView *textView = [OCMockObject niceMockForClass:[LSRichTextView class]];
+    OCMStub([textView font]).andReturn(self.testPreconditionFont);
+    OCMStub([textView tintColor]).andReturn([UIColor blueColor]);
+    OCMStub([textView richTextConfiguration]).andReturn(configuration);
+    OCMStub([textView hasText]).andReturn(YES);
+
+    return [[LSTextStorage alloc] initWithTextView:textView];
+}
+
 - (void)verifyFontNotChanged
 {
     for (NSUInteger index = 0; index < self.testTextStorage.string.length; index++) {
@@ -0,0 +1,113 @@
+//
+//  LSTraceTests.m
+//  LSTextEditor
+//
+//  Copyright (c) 2015 LShift Services GmbH. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "LSTrace.h"
+
+@interface LSTraceTests : XCTestCase
+
+@end
+
+@implementation LSTraceTests
+
+- (void)setUp {
+    [super setUp];
+
+    [LSTrace setMaximumLevel:LSTraceLevelDebug];
+    [LSTrace setEnabledCategories:LSTraceCategoryAll];
+    [LSTrace reset];
+}
+
+- (void)tearDown {
+    [LSTrace setMaximumLevel:LSTraceLevelInfo];
+    [LSTrace setEnabledCategories:LSTraceCategoryAll];
+    [LSTrace reset];
+
+    [super tearDown];
+}
+
+#if LSTRACE_ENABLED
+
+- (void)testTraceWritesEntries
+{
+    LSTrace(LSTraceCategoryParse, LSTraceLevelInfo, "Parsed %d tokens", 42);
+
+    NSArray *entries = [LSTrace dumpEntries];
+
+    XCTAssertEqual(entries.count, 1, @"Trace entry isn't written!");
+    XCTAssert([entries[0] rangeOfString:@"[parse] info"].location != NSNotFound, @"Category and level aren't dumped!");
+    XCTAssert([entries[0] hasSuffix:@"Parsed 42 tokens"], @"Message isn't formatted!");
+}
+
+- (void)testTraceFiltersLevelsAndCategories
+{
+    [LSTrace setMaximumLevel:LSTraceLevelWarning];
+    [LSTrace setEnabledCategories:LSTraceCategoryStyle | LSTraceCategoryDetect];
+
+    LSTrace(LSTraceCategoryStyle, LSTraceLevelInfo, "too verbose");
+    LSTrace(LSTraceCategoryParse, LSTraceLevelError, "disabled category");
+    LSTrace(LSTraceCategoryDetect, LSTraceLevelError, "recorded");
+
+    NSArray *entries = [LSTrace dumpEntries];
+
+    XCTAssertEqual(entries.count, 1, @"Filtered entries are written!");
+    XCTAssert([entries[0] hasSuffix:@"recorded"], @"Enabled entry isn't written!");
+}
+
+- (void)testTraceKeepsLatestEntries
+{
+    for (NSUInteger index = 0; index < LSTRACE_BUFFER_SIZE + 10; index++) {
+        LSTrace(LSTraceCategoryLayout, LSTraceLevelDebug, "entry %lu", (unsigned long)index);
+    }
+
+    NSArray *entries = [LSTrace dumpEntries];
+
+    XCTAssertEqual(entries.count, LSTRACE_BUFFER_SIZE, @"Ring buffer isn't bounded!");
+    XCTAssert([entries.firstObject hasSuffix:@"entry 10"], @"Oldest entries aren't overwritten!");
+    XCTAssert([entries.lastObject hasSuffix:([NSString stringWithFormat:@"entry %d", LSTRACE_BUFFER_SIZE + 9])], @"Latest entry is missing!");
+}
+
+- (void)testTraceTruncatesLongMessages
+{
+    NSString *longMessage = [@"" stringByPaddingToLength:LSTRACE_MESSAGE_LENGTH * 2 withString:@"x" startingAtIndex:0];
+
+    LSTrace(LSTraceCategorySerialize, LSTraceLevelInfo, "%s", longMessage.UTF8String);
+
+    NSString *entry = [LSTrace dumpEntries].firstObject;
+    NSString *message = [entry substringFromIndex:[entry rangeOfString:@": "].location + 2];
+
+    XCTAssertEqual(message.length, LSTRACE_MESSAGE_LENGTH - 1, @"Message isn't truncated!");
+}
+
+- (void)testTraceFromConcurrentWriters
+{
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t writer) {
+        for (NSUInteger index = 0; index < 100; index++) {
+            LSTrace(LSTraceCategoryStyle, LSTraceLevelDebug, "writer %zu entry %lu", writer, (unsigned long)index);
+        }
+    });
+
+    NSArray *entries = [LSTrace dumpEntries];
+
+    XCTAssertEqual(entries.count, 800, @"Entries of concurrent writers are lost!");
+
+    for (NSString *entry in entries) {
+        XCTAssert([entry rangeOfString:@"[style] debug"].location != NSNotFound, @"Entry is corrupted: %@", entry);
+    }
+}
+
+#endif
+
+- (void)testResetRemovesEntries
+{
+    LSTraceWrite(LSTraceCategoryDetect, LSTraceLevelInfo, "detected");
+    [LSTrace reset];
+
+    XCTAssertEqual([LSTrace dumpEntries].count, 0, @"Entries aren't removed!");
+}
+
+@end
@@ -0,0 +1,80 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import "LSBBCodeSerializer.h"
+
+/*!
+ *  Creates the attributes of a style on top of base attributes.
+ *
+ *  @param style          the style.
+ *  @param context        the context, NSNotFound if there's none.
+ *  @param baseAttributes the attributes the style is added to.
+ *
+ *  @return the attributes including the base attributes.
+ */
+typedef NSDictionary *(^LSAttributesCacheBlock)(LSBBCodeStyle style, NSUInteger context, NSDictionary *baseAttributes);
+
+/*!
+ *  @discussion LSAttributesCache interns attribute dictionaries, so equal attributes share
+ *              one immutable instance. Runs of a text storing interned attributes are
+ *              compared by pointer and a large document keeps one dictionary per unique
+ *              style instead of one per run.
+ *
+ *              The cache isn't thread safe, it's used by one text storage or one styling pass.
+ */
+@interface LSAttributesCache : NSObject
+
+/*!
+ *  The number of interned attribute dictionaries.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/*!
+ *  Returns the interned instance of attributes.
+ *
+ *  @param attributes the attributes.
+ *
+ *  @return an immutable dictionary equal to the attributes.
+ */
+- (NSDictionary *)internedAttributes:(NSDictionary *)attributes;
+
+/*!
+ *  Returns the interned attributes of a style on top of base attributes. The block is
+ *  only called for the first lookup of a combination of style, context and base attributes.
+ *
+ *  @param style          the style.
+ *  @param context        the context, NSNotFound if there's none.
+ *  @param baseAttributes the attributes the style is added to.
+ *  @param block          creates the attributes if they aren't cached yet.
+ *
+ *  @return an immutable dictionary of the attributes.
+ */
+- (NSDictionary *)attributesForStyle:(LSBBCodeStyle)style andContext:(NSUInteger)context
+                  withBaseAttributes:(NSDictionary *)baseAttributes usingBlock:(LSAttributesCacheBlock)block;
+
+/*!
+ *  Removes all interned attributes.
+ */
+- (void)removeAllAttributes;
+
+@end
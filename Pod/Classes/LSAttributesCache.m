@@ -0,0 +1,117 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSAttributesCache.h"
+
+#define LSATTRIBUTESCACHE_MAX_COUNT 4096
+
+@implementation LSAttributesCache {
+    // candidates by attributes hash, NSDictionary hashes are just the entry count
+    NSMutableDictionary *_attributesByHash;
+
+    // styled attributes by interned base attributes and style
+    NSMapTable *_styledAttributesByBase;
+}
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _attributesByHash = [NSMutableDictionary dictionary];
+        _styledAttributesByBase = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                        valueOptions:NSPointerFunctionsStrongMemory];
+    }
+
+    return self;
+}
+
+- (NSDictionary *)internedAttributes:(NSDictionary *)attributes
+{
+    if (!attributes) {
+        return nil;
+    }
+
+    __block NSUInteger hash = attributes.count;
+    [attributes enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+        // entries are combined independent of their order
+        hash += [key hash] ^ ([obj hash] * 31);
+    }];
+
+    NSNumber *hashKey = @(hash);
+    NSMutableArray *candidates = _attributesByHash[hashKey];
+
+    for (NSDictionary *candidate in candidates) {
+        if (candidate == attributes || [candidate isEqualToDictionary:attributes]) {
+            return candidate;
+        }
+    }
+
+    if (_count >= LSATTRIBUTESCACHE_MAX_COUNT) {
+        // interned attributes stay valid, later ones just aren't shared with them
+        [self removeAllAttributes];
+        candidates = nil;
+    }
+
+    if (!candidates) {
+        candidates = [NSMutableArray arrayWithCapacity:1];
+        _attributesByHash[hashKey] = candidates;
+    }
+
+    NSDictionary *internedAttributes = [attributes copy];
+    [candidates addObject:internedAttributes];
+    _count++;
+
+    return internedAttributes;
+}
+
+- (NSDictionary *)attributesForStyle:(LSBBCodeStyle)style andContext:(NSUInteger)context
+                  withBaseAttributes:(NSDictionary *)baseAttributes usingBlock:(LSAttributesCacheBlock)block
+{
+    NSDictionary *base = [self internedAttributes:baseAttributes ?: @{}];
+    NSMutableDictionary *styledAttributes = [_styledAttributesByBase objectForKey:base];
+
+    // the context is packed above the style bits, NSNotFound wraps to zero
+    NSNumber *styleKey = @(((context + 1) << 16) | style);
+    NSDictionary *attributes = styledAttributes[styleKey];
+
+    if (attributes) {
+        return attributes;
+    }
+
+    attributes = [self internedAttributes:block(style, context, base)];
+
+    if (!styledAttributes) {
+        styledAttributes = [NSMutableDictionary dictionary];
+        [_styledAttributesByBase setObject:styledAttributes forKey:base];
+    }
+    styledAttributes[styleKey] = attributes;
+
+    return attributes;
+}
+
+- (void)removeAllAttributes
+{
+    [_attributesByHash removeAllObjects];
+    [_styledAttributesByBase removeAllObjects];
+    _count = 0;
+}
+
+@end
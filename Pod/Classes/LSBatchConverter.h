@@ -0,0 +1,95 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+@class LSTagRegistry;
+@class LSStyleRunBuilder;
+@class LSStyleRunCollector;
+
+/*!
+ *  Converts the style runs of one document into a result.
+ *
+ *  @param runBuilder the runs of the document.
+ *  @param collector  the collector providing the tag contexts of the runs.
+ *
+ *  @return the result of the document, nil is returned as NSNull.
+ */
+typedef id (^LSBatchConverterBlock)(LSStyleRunBuilder *runBuilder, LSStyleRunCollector *collector);
+
+/*!
+ *  @discussion LSBatchConverter converts many markup documents at once, spread across all
+ *              cores. Every worker owns a parser, token buffer, node tree and run builder
+ *              which are reset for the next document, so converting doesn't allocate
+ *              buffers per document. Workers take the next document when they are done,
+ *              results are returned in the order of the documents.
+ */
+@interface LSBatchConverter : NSObject
+
+/*!
+ *  The registry of known tags.
+ */
+@property (nonatomic, strong, readonly) LSTagRegistry *tagRegistry;
+
+/*!
+ *  The maximum number of workers, defaults to the number of active processors.
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrency;
+
+/*!
+ *  Initializes a converter.
+ *
+ *  @param tagRegistry the registry of known tags, nil for the default tags.
+ *
+ *  @return an instance of LSBatchConverter.
+ */
+- (instancetype)initWithTagRegistry:(LSTagRegistry *)tagRegistry;
+
+/*!
+ *  Parses documents and converts their style runs. The block is called concurrently,
+ *  run builder and collector are reused after it returned, so the result mustn't
+ *  reference them.
+ *
+ *  @param markupStrings the markup documents.
+ *  @param block         converts the style runs of a document.
+ *  @param errors        set to an array containing the parse error of every document or
+ *                       NSNull if it was parsed, can be NULL.
+ *
+ *  @return an array of results in the order of the documents, NSNull for documents
+ *          which couldn't be parsed.
+ */
+- (NSArray *)convertMarkupStrings:(NSArray *)markupStrings usingBlock:(LSBatchConverterBlock)block errors:(NSArray **)errors;
+
+/*!
+ *  Parses documents and serializes their style runs again, see
+ *  +[LSStyleRunCollector normalizedMarkupFromString:withTagRegistry:error:].
+ *
+ *  @param markupStrings the markup documents.
+ *  @param errors        set to an array containing the parse error of every document or
+ *                       NSNull if it was parsed, can be NULL.
+ *
+ *  @return an array of normalized markup strings in the order of the documents, NSNull
+ *          for documents which couldn't be parsed.
+ */
+- (NSArray *)normalizeMarkupStrings:(NSArray *)markupStrings errors:(NSArray **)errors;
+
+@end
@@ -0,0 +1,127 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSBatchConverter.h"
+#import "LSParser.h"
+#import "LSStyleRunBuilder.h"
+#import "LSStyleRunCollector.h"
+#import "LSTrace.h"
+#import <stdatomic.h>
+
+@implementation LSBatchConverter
+
+- (instancetype)initWithTagRegistry:(LSTagRegistry *)tagRegistry
+{
+    if (self = [super init]) {
+        _tagRegistry = tagRegistry ?: [[LSTagRegistry alloc] init];
+        _maximumConcurrency = [NSProcessInfo processInfo].activeProcessorCount;
+    }
+
+    return self;
+}
+
+- (instancetype)init
+{
+    return [self initWithTagRegistry:nil];
+}
+
+- (NSArray *)convertMarkupStrings:(NSArray *)markupStrings usingBlock:(LSBatchConverterBlock)block errors:(NSArray **)errors
+{
+    NSUInteger count = markupStrings.count;
+
+    // every slot is written by exactly one worker, the arrays are only created after all finished
+    __strong id *results = (__strong id *)calloc(MAX(count, 1), sizeof(id));
+    __strong id *resultErrors = (__strong id *)calloc(MAX(count, 1), sizeof(id));
+    atomic_ulong nextIndex = 0;
+    atomic_ulong *sharedNextIndex = &nextIndex;
+
+    NSUInteger workerCount = MAX(MIN(self.maximumConcurrency, count), 1);
+    LSTagRegistry *tagRegistry = self.tagRegistry;
+
+    dispatch_apply(workerCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker) {
+        LSParser *parser = [LSParser new];
+        parser.tagRegistry = tagRegistry;
+
+        LSTokenBuffer *tokenBuffer = [[LSTokenBuffer alloc] initWithString:@""];
+        LSNodeTree *nodeTree = [[LSNodeTree alloc] initWithSourceString:@"" andRootTagName:@"ROOT" andTagRegistry:tagRegistry];
+        LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:@""];
+        LSStyleRunCollector *collector = [[LSStyleRunCollector alloc] initWithNodeTree:nodeTree andTagRegistry:tagRegistry];
+
+        for (NSUInteger index = atomic_fetch_add(sharedNextIndex, 1); index < count; index = atomic_fetch_add(sharedNextIndex, 1)) {
+            @autoreleasepool {
+                NSString *markup = markupStrings[index];
+                NSError *error;
+
+                if (![parser parseNodeTreeFromString:markup withTokenBuffer:tokenBuffer andNodeTree:nodeTree error:&error]) {
+                    resultErrors[index] = error;
+                    continue;
+                }
+
+                [runBuilder resetWithSourceText:[[NSAttributedString alloc] initWithString:markup]];
+                [collector resetWithNodeTree:nodeTree];
+                [collector collectRunsIntoBuilder:runBuilder];
+
+                results[index] = block(runBuilder, collector);
+            }
+        }
+    });
+
+    NSMutableArray *resultArray = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray *errorArray = [NSMutableArray arrayWithCapacity:count];
+    NSUInteger failedCount = 0;
+
+    for (NSUInteger index = 0; index < count; index++) {
+        [resultArray addObject:results[index] ?: [NSNull null]];
+        [errorArray addObject:resultErrors[index] ?: [NSNull null]];
+        failedCount += (resultErrors[index] != nil);
+
+        results[index] = nil;
+        resultErrors[index] = nil;
+    }
+
+    free(results);
+    free(resultErrors);
+
+    LSTrace(LSTraceCategoryParse, LSTraceLevelInfo, "Converted %lu documents with %lu workers, %lu failed",
+            (unsigned long)count, (unsigned long)workerCount, (unsigned long)failedCount);
+
+    if (errors) {
+        *errors = errorArray;
+    }
+
+    return resultArray;
+}
+
+- (NSArray *)normalizeMarkupStrings:(NSArray *)markupStrings errors:(NSArray **)errors
+{
+    LSTagRegistry *tagRegistry = self.tagRegistry;
+
+    return [self convertMarkupStrings:markupStrings usingBlock:^id(LSStyleRunBuilder *runBuilder, LSStyleRunCollector *collector) {
+        LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:nil andTagRegistry:tagRegistry];
+        [runBuilder serializeWithSerializer:serializer];
+        [serializer finishWithError:nil];
+
+        return serializer.string;
+    } errors:errors];
+}
+
+@end
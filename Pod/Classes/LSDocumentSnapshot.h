@@ -0,0 +1,141 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+
+#import <Foundation/Foundation.h>
+#import "LSStyleRunBuilder.h"
+
+@class LSTagRegistry;
+
+extern NSString * const LSDocumentSnapshotErrorDomain;
+
+/*!
+ *  @typedef LSDocumentSnapshotErrorCode
+ *
+ *  @field LSDocumentSnapshotErrorMalformed          The data isn't a snapshot or is truncated.
+ *  @field LSDocumentSnapshotErrorUnsupportedVersion The snapshot was written in another format version.
+ *  @field LSDocumentSnapshotErrorChecksumMismatch   The content doesn't match the checksum of the snapshot.
+ *  @field LSDocumentSnapshotErrorUnknownTag         A tag of the snapshot isn't registered anymore.
+ */
+typedef NS_ENUM(NSInteger, LSDocumentSnapshotErrorCode) {
+    LSDocumentSnapshotErrorMalformed = 1,
+    LSDocumentSnapshotErrorUnsupportedVersion = 2,
+    LSDocumentSnapshotErrorChecksumMismatch = 3,
+    LSDocumentSnapshotErrorUnknownTag = 4
+};
+
+/*!
+ *  @discussion LSDocumentSnapshot keeps a parsed and styled document in a compact binary
+ *              format, so a document can be cached on disk and shown again without parsing
+ *              its markup. A snapshot contains a header, a style table of the unique pairs
+ *              of style and tag context, a run table of (length, style index) pairs, the
+ *              UTF-16 text and the tag contexts of handler tags.
+ *
+ *              Snapshots are loaded from memory mapped files. The header carries a format
+ *              version and a checksum of the content, a snapshot of another version or with
+ *              a wrong checksum is rejected, so the caller falls back to parsing the markup.
+ *              Tag contexts keep tag names, they are resolved against the tag registry
+ *              when the snapshot is loaded.
+ */
+@interface LSDocumentSnapshot : NSObject
+
+/*!
+ *  The snapshot data, mapped from the file the snapshot was loaded from.
+ */
+@property (nonatomic, strong, readonly) NSData *data;
+
+/*!
+ *  The plain text of the document.
+ */
+@property (nonatomic, strong, readonly) NSString *string;
+
+/*!
+ *  The number of style runs of the document.
+ */
+@property (nonatomic, assign, readonly) NSUInteger runCount;
+
+/*!
+ *  The tag contexts referenced by the runs, see -[LSStyleRunCollector tagContexts].
+ */
+@property (nonatomic, strong, readonly) NSArray *tagContexts;
+
+/*!
+ *  Initializes a snapshot from snapshot data. Header, sizes, run table and checksum are
+ *  validated first.
+ *
+ *  @param data        the snapshot data.
+ *  @param tagRegistry the registry the tag names of the tag contexts are resolved with, nil for the default tags.
+ *  @param error       set if the data isn't a valid snapshot.
+ *
+ *  @return an instance of LSDocumentSnapshot or nil if the data isn't a valid snapshot.
+ */
+- (instancetype)initWithData:(NSData *)data andTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error;
+
+/*!
+ *  Loads a snapshot from a file. The file is memory mapped, the text is copied out of it once.
+ *
+ *  @param path        the path of the snapshot file.
+ *  @param tagRegistry the registry the tag names of the tag contexts are resolved with, nil for the default tags.
+ *  @param error       set if the file can't be read or isn't a valid snapshot.
+ *
+ *  @return an instance of LSDocumentSnapshot or nil if the file isn't a valid snapshot.
+ */
++ (instancetype)snapshotWithContentsOfFile:(NSString *)path andTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error;
+
+/*!
+ *  Creates snapshot data of the runs of a run builder.
+ *
+ *  @param runBuilder  the run builder.
+ *  @param tagContexts the tag contexts referenced by the runs, can be nil if the runs have none.
+ *  @param tagRegistry the registry the tag IDs of the tag contexts belong to, nil for the default tags.
+ *
+ *  @return the snapshot data or nil if the document is too large for the format.
+ */
++ (NSData *)snapshotDataWithRunBuilder:(LSStyleRunBuilder *)runBuilder andTagContexts:(NSArray *)tagContexts
+                        andTagRegistry:(LSTagRegistry *)tagRegistry;
+
+/*!
+ *  Parses markup and creates snapshot data of the styled document.
+ *
+ *  @param markup      the markup string.
+ *  @param tagRegistry the registry of known tags, nil for the default tags.
+ *  @param error       set if the markup couldn't be parsed.
+ *
+ *  @return the snapshot data or nil if the markup couldn't be parsed.
+ */
++ (NSData *)snapshotDataFromMarkup:(NSString *)markup withTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error;
+
+/*!
+ *  Enumerates the runs of the document.
+ *
+ *  @param block the block called for every run, the context is an index of tagContexts.
+ */
+- (void)enumerateRunsUsingBlock:(LSStyleRunBlock)block;
+
+/*!
+ *  Adds the runs of the document to a run builder created for the string of the snapshot.
+ *
+ *  @param runBuilder the run builder.
+ */
+- (void)addRunsToBuilder:(LSStyleRunBuilder *)runBuilder;
+
+@end
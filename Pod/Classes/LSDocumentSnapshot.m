@@ -0,0 +1,371 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+
+#import "LSDocumentSnapshot.h"
+#import "LSStyleRunCollector.h"
+#import "LSParser.h"
+#import "LSTrace.h"
+
+#define LSDOCUMENTSNAPSHOT_MAGIC 0x5344534C
+#define LSDOCUMENTSNAPSHOT_VERSION 1
+#define LSDOCUMENTSNAPSHOT_NO_CONTEXT UINT32_MAX
+
+NSString * const LSDocumentSnapshotErrorDomain = @"LSDocumentSnapshotErrorDomain";
+
+// all fields are written in host byte order, a snapshot of a big endian host doesn't
+// match the magic number on little endian ones and the other way round
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t textLength;
+    uint32_t runCount;
+    uint32_t styleCount;
+    uint32_t contextsLength;
+    uint32_t checksum;
+    uint32_t reserved;
+} LSDocumentSnapshotHeader;
+
+typedef struct {
+    uint32_t style;
+    uint32_t context;
+} LSDocumentSnapshotStyle;
+
+typedef struct {
+    uint32_t length;
+    uint32_t styleIndex;
+} LSDocumentSnapshotRun;
+
+static inline uint64_t LSDocumentSnapshotAlign(uint64_t length)
+{
+    return (length + 3) & ~(uint64_t)3;
+}
+
+static uint32_t LSDocumentSnapshotChecksum(const uint32_t *words, NSUInteger count)
+{
+    // Fletcher like sums over whole words, so validating a snapshot costs about as much as copying it
+    uint64_t sum = 0;
+    uint64_t sumOfSums = 0;
+
+    for (NSUInteger index = 0; index < count; index++) {
+        sum += words[index];
+        sumOfSums += sum;
+    }
+
+    return (uint32_t)(sum ^ sumOfSums ^ (sumOfSums >> 32));
+}
+
+static BOOL LSDocumentSnapshotFail(NSError **error, LSDocumentSnapshotErrorCode code, NSString *description)
+{
+    LSTrace(LSTraceCategorySerialize, LSTraceLevelWarning, "Rejected snapshot: %s", description.UTF8String);
+
+    if (error) {
+        *error = [NSError errorWithDomain:LSDocumentSnapshotErrorDomain
+                                     code:code
+                                 userInfo:@{NSLocalizedDescriptionKey : description}];
+    }
+
+    return NO;
+}
+
+@implementation LSDocumentSnapshot {
+    const LSDocumentSnapshotStyle *_styles;
+    const LSDocumentSnapshotRun *_runs;
+}
+
+- (instancetype)initWithData:(NSData *)data andTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error
+{
+    if (self = [super init]) {
+        // mapped files and allocated buffers are aligned, sub ranges of other data might not be
+        _data = ((uintptr_t)data.bytes & 3) ? [NSData dataWithBytes:data.bytes length:data.length] : data;
+
+        if (![self loadWithTagRegistry:tagRegistry ?: [[LSTagRegistry alloc] init] error:error]) {
+            return nil;
+        }
+    }
+
+    return self;
+}
+
++ (instancetype)snapshotWithContentsOfFile:(NSString *)path andTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error
+{
+    // the file is mapped instead of read, pages are loaded while the snapshot is validated
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+
+    return data ? [[self alloc] initWithData:data andTagRegistry:tagRegistry error:error] : nil;
+}
+
+- (BOOL)loadWithTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error
+{
+    const uint8_t *bytes = _data.bytes;
+    NSUInteger length = _data.length;
+    LSDocumentSnapshotHeader header;
+
+    if (length < sizeof(header)) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Snapshot is shorter than its header");
+    }
+
+    memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic != LSDOCUMENTSNAPSHOT_MAGIC) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Data isn't a snapshot");
+    }
+
+    if (header.version != LSDOCUMENTSNAPSHOT_VERSION) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorUnsupportedVersion,
+                                      [NSString stringWithFormat:@"Snapshot version %u isn't supported", header.version]);
+    }
+
+    uint64_t stylesLength = (uint64_t)header.styleCount * sizeof(LSDocumentSnapshotStyle);
+    uint64_t runsLength = (uint64_t)header.runCount * sizeof(LSDocumentSnapshotRun);
+    uint64_t textLength = LSDocumentSnapshotAlign((uint64_t)header.textLength * sizeof(unichar));
+
+    if (sizeof(header) + stylesLength + runsLength + textLength + LSDocumentSnapshotAlign(header.contextsLength) != length) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Snapshot length doesn't match its header");
+    }
+
+    const uint8_t *payload = bytes + sizeof(header);
+
+    if (LSDocumentSnapshotChecksum((const uint32_t *)payload, (length - sizeof(header)) / sizeof(uint32_t)) != header.checksum) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorChecksumMismatch, @"Snapshot checksum doesn't match");
+    }
+
+    _styles = (const LSDocumentSnapshotStyle *)payload;
+    _runs = (const LSDocumentSnapshotRun *)(payload + stylesLength);
+    _runCount = header.runCount;
+
+    const unichar *text = (const unichar *)(payload + stylesLength + runsLength);
+    const uint8_t *contexts = payload + stylesLength + runsLength + textLength;
+
+    if (![self loadTagContextsFromBytes:contexts length:header.contextsLength withTagRegistry:tagRegistry error:error]) {
+        return NO;
+    }
+
+    for (NSUInteger index = 0; index < header.styleCount; index++) {
+        if (_styles[index].context != LSDOCUMENTSNAPSHOT_NO_CONTEXT && _styles[index].context >= _tagContexts.count) {
+            return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Snapshot style references a missing tag context");
+        }
+    }
+
+    uint64_t runsTextLength = 0;
+
+    for (NSUInteger index = 0; index < header.runCount; index++) {
+        if (_runs[index].styleIndex >= header.styleCount) {
+            return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Snapshot run references a missing style");
+        }
+        runsTextLength += _runs[index].length;
+    }
+
+    if (runsTextLength != header.textLength) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Snapshot runs don't cover its text");
+    }
+
+    _string = [[NSString alloc] initWithCharacters:text length:header.textLength];
+
+    LSTrace(LSTraceCategorySerialize, LSTraceLevelInfo, "Loaded snapshot of %lu characters in %lu runs",
+            (unsigned long)_string.length, (unsigned long)_runCount);
+
+    return YES;
+}
+
+- (BOOL)loadTagContextsFromBytes:(const uint8_t *)bytes length:(NSUInteger)length
+                 withTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error
+{
+    if (length == 0) {
+        _tagContexts = @[];
+        return YES;
+    }
+
+    NSData *contextsData = [NSData dataWithBytesNoCopy:(void *)bytes length:length freeWhenDone:NO];
+    NSArray *namedContexts = [NSPropertyListSerialization propertyListWithData:contextsData options:NSPropertyListImmutable
+                                                                        format:NULL error:nil];
+
+    if (![namedContexts isKindOfClass:[NSArray class]]) {
+        return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorMalformed, @"Snapshot tag contexts can't be read");
+    }
+
+    NSMutableArray *tagContexts = [NSMutableArray arrayWithCapacity:namedContexts.count];
+
+    // tags are stored by name, so a snapshot stays valid as long as its tags are registered
+    for (NSArray *namedTags in namedContexts) {
+        NSMutableArray *tags = [NSMutableArray arrayWithCapacity:namedTags.count];
+
+        for (NSArray *namedTag in namedTags) {
+            NSUInteger tagID = [tagRegistry tagIDForName:namedTag.firstObject];
+
+            if (tagID == NSNotFound) {
+                return LSDocumentSnapshotFail(error, LSDocumentSnapshotErrorUnknownTag,
+                                              [NSString stringWithFormat:@"Snapshot tag %@ isn't registered", namedTag.firstObject]);
+            }
+
+            NSDictionary *tagAttributes = namedTag.lastObject;
+            [tags addObject:@[@(tagID), tagAttributes.count > 0 ? tagAttributes : [NSNull null]]];
+        }
+
+        [tagContexts addObject:tags];
+    }
+
+    _tagContexts = tagContexts;
+
+    return YES;
+}
+
+#pragma mark - writing
+
++ (NSData *)snapshotDataWithRunBuilder:(LSStyleRunBuilder *)runBuilder andTagContexts:(NSArray *)tagContexts
+                        andTagRegistry:(LSTagRegistry *)tagRegistry
+{
+    tagRegistry = tagRegistry ?: [[LSTagRegistry alloc] init];
+
+    NSString *string = [runBuilder string];
+
+    if (string.length > UINT32_MAX || runBuilder.runCount > UINT32_MAX) {
+        return nil;
+    }
+
+    NSMutableData *styleTable = [NSMutableData data];
+    NSMutableData *runTable = [NSMutableData dataWithCapacity:runBuilder.runCount * sizeof(LSDocumentSnapshotRun)];
+    NSMutableDictionary *styleIndexes = [NSMutableDictionary dictionary];
+
+    [runBuilder enumerateRunsUsingBlock:^(NSRange range, LSBBCodeStyle style, NSUInteger context, BOOL *stop) {
+        LSDocumentSnapshotStyle snapshotStyle = {(uint32_t)style, (context != NSNotFound) ? (uint32_t)context : LSDOCUMENTSNAPSHOT_NO_CONTEXT};
+        NSNumber *styleKey = @(((uint64_t)snapshotStyle.style << 32) | snapshotStyle.context);
+        NSNumber *styleIndex = styleIndexes[styleKey];
+
+        if (!styleIndex) {
+            styleIndex = @(styleIndexes.count);
+            styleIndexes[styleKey] = styleIndex;
+            [styleTable appendBytes:&snapshotStyle length:sizeof(snapshotStyle)];
+        }
+
+        LSDocumentSnapshotRun run = {(uint32_t)range.length, styleIndex.unsignedIntValue};
+        [runTable appendBytes:&run length:sizeof(run)];
+    }];
+
+    NSData *contextsData = [self dataOfTagContexts:tagContexts withTagRegistry:tagRegistry];
+
+    if (!contextsData) {
+        return nil;
+    }
+
+    uint64_t textLength = LSDocumentSnapshotAlign(string.length * sizeof(unichar));
+    uint64_t payloadLength = styleTable.length + runTable.length + textLength + LSDocumentSnapshotAlign(contextsData.length);
+
+    // the buffer is zeroed, so the padding of text and tag contexts is part of the checksum
+    NSMutableData *data = [NSMutableData dataWithLength:sizeof(LSDocumentSnapshotHeader) + payloadLength];
+    uint8_t *payload = (uint8_t *)data.mutableBytes + sizeof(LSDocumentSnapshotHeader);
+
+    memcpy(payload, styleTable.bytes, styleTable.length);
+    memcpy(payload + styleTable.length, runTable.bytes, runTable.length);
+    [string getCharacters:(unichar *)(payload + styleTable.length + runTable.length) range:NSMakeRange(0, string.length)];
+    memcpy(payload + styleTable.length + runTable.length + textLength, contextsData.bytes, contextsData.length);
+
+    LSDocumentSnapshotHeader header = {
+        LSDOCUMENTSNAPSHOT_MAGIC,
+        LSDOCUMENTSNAPSHOT_VERSION,
+        (uint32_t)string.length,
+        (uint32_t)(runTable.length / sizeof(LSDocumentSnapshotRun)),
+        (uint32_t)styleIndexes.count,
+        (uint32_t)contextsData.length,
+        LSDocumentSnapshotChecksum((const uint32_t *)payload, payloadLength / sizeof(uint32_t)),
+        0
+    };
+    memcpy(data.mutableBytes, &header, sizeof(header));
+
+    LSTrace(LSTraceCategorySerialize, LSTraceLevelInfo, "Wrote snapshot of %lu characters in %u runs and %u styles",
+            (unsigned long)string.length, header.runCount, header.styleCount);
+
+    return data;
+}
+
++ (NSData *)dataOfTagContexts:(NSArray *)tagContexts withTagRegistry:(LSTagRegistry *)tagRegistry
+{
+    if (tagContexts.count == 0) {
+        return [NSData data];
+    }
+
+    NSMutableArray *namedContexts = [NSMutableArray arrayWithCapacity:tagContexts.count];
+
+    for (NSArray *tags in tagContexts) {
+        NSMutableArray *namedTags = [NSMutableArray arrayWithCapacity:tags.count];
+
+        for (NSArray *tag in tags) {
+            [namedTags addObject:@[[tagRegistry tagNameForID:[tag[0] unsignedIntegerValue]],
+                                   (tag[1] != [NSNull null]) ? tag[1] : @{}]];
+        }
+
+        [namedContexts addObject:namedTags];
+    }
+
+    return [NSPropertyListSerialization dataWithPropertyList:namedContexts format:NSPropertyListBinaryFormat_v1_0
+                                                     options:0 error:nil];
+}
+
++ (NSData *)snapshotDataFromMarkup:(NSString *)markup withTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error
+{
+    tagRegistry = tagRegistry ?: [[LSTagRegistry alloc] init];
+
+    LSParser *parser = [LSParser new];
+    parser.tagRegistry = tagRegistry;
+
+    NSError *parseError;
+    LSNodeTree *nodeTree = [parser parseNodeTreeFromString:markup error:&parseError];
+
+    if (parseError) {
+        if (error) {
+            *error = parseError;
+        }
+        return nil;
+    }
+
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:markup];
+    LSStyleRunCollector *collector = [[LSStyleRunCollector alloc] initWithNodeTree:nodeTree andTagRegistry:tagRegistry];
+    [collector collectRunsIntoBuilder:runBuilder];
+
+    return [self snapshotDataWithRunBuilder:runBuilder andTagContexts:collector.tagContexts andTagRegistry:tagRegistry];
+}
+
+#pragma mark - runs
+
+- (void)enumerateRunsUsingBlock:(LSStyleRunBlock)block
+{
+    NSUInteger location = 0;
+    BOOL stop = NO;
+
+    for (NSUInteger index = 0; index < _runCount && !stop; index++) {
+        LSDocumentSnapshotRun run = _runs[index];
+        LSDocumentSnapshotStyle style = _styles[run.styleIndex];
+
+        block(NSMakeRange(location, run.length), style.style,
+              (style.context != LSDOCUMENTSNAPSHOT_NO_CONTEXT) ? style.context : NSNotFound, &stop);
+        location += run.length;
+    }
+}
+
+- (void)addRunsToBuilder:(LSStyleRunBuilder *)runBuilder
+{
+    [self enumerateRunsUsingBlock:^(NSRange range, LSBBCodeStyle style, NSUInteger context, BOOL *stop) {
+        [runBuilder addRunWithSourceRange:range andStyle:style andContext:context];
+    }];
+}
+
+@end
@@ -0,0 +1,58 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <UIKit/UIKit.h>
+
+/*!
+ *  @discussion LSFontTraitCache resolves fonts for a base font descriptor with symbolic
+ *              traits added and keeps the result, so bold and italic fonts are looked up
+ *              once per base font instead of once per styled run. It can be used from
+ *              several threads at the same time.
+ */
+@interface LSFontTraitCache : NSObject
+
+/*!
+ *  The number of lookups answered from the cache.
+ */
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+
+/*!
+ *  The number of lookups resolving a new font.
+ */
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+/*!
+ *  Returns the font of a font descriptor with the given symbolic traits.
+ *
+ *  @param fontDescriptor the base font descriptor.
+ *  @param traits         the symbolic traits of the resolved font.
+ *
+ *  @return the resolved font or nil if there's no font with the traits.
+ */
+- (UIFont *)fontWithDescriptor:(UIFontDescriptor *)fontDescriptor andSymbolicTraits:(UIFontDescriptorSymbolicTraits)traits;
+
+/*!
+ *  Removes all resolved fonts, the counters are kept.
+ */
+- (void)invalidate;
+
+@end
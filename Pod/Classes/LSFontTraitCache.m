@@ -0,0 +1,101 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSFontTraitCache.h"
+
+@implementation LSFontTraitCache {
+    NSMutableDictionary *_fonts;
+    NSUInteger _hitCount;
+    NSUInteger _missCount;
+}
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _fonts = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+- (UIFont *)fontWithDescriptor:(UIFontDescriptor *)fontDescriptor andSymbolicTraits:(UIFontDescriptorSymbolicTraits)traits
+{
+    if (!fontDescriptor) {
+        return nil;
+    }
+
+    // fonts are kept by name, point size and traits, the small numbers are tagged pointers and hashing
+    // them allocates nothing, descriptors without a name are the key themselves
+    id nameKey = fontDescriptor.postscriptName ?: fontDescriptor;
+    NSNumber *sizeKey = @(fontDescriptor.pointSize);
+    NSNumber *traitsKey = @(traits);
+    id font;
+
+    @synchronized (self) {
+        font = _fonts[nameKey][sizeKey][traitsKey];
+        if (font) {
+            _hitCount++;
+        }
+    }
+
+    if (font) {
+        return (font != [NSNull null]) ? font : nil;
+    }
+
+    // resolved outside the lock, two threads missing the same key resolve the same font
+    UIFontDescriptor *descriptorWithTraits = [fontDescriptor fontDescriptorWithSymbolicTraits:traits];
+    font = descriptorWithTraits ? [UIFont fontWithDescriptor:descriptorWithTraits size:0.0] : nil;
+
+    @synchronized (self) {
+        _missCount++;
+
+        NSMutableDictionary *fontsOfName = _fonts[nameKey] ?: (_fonts[nameKey] = [NSMutableDictionary dictionary]);
+        NSMutableDictionary *fontsOfSize = fontsOfName[sizeKey] ?: (fontsOfName[sizeKey] = [NSMutableDictionary dictionary]);
+        // missing fonts are kept as well, failing lookups are as expensive as successful ones
+        fontsOfSize[traitsKey] = font ?: [NSNull null];
+    }
+
+    return font;
+}
+
+- (void)invalidate
+{
+    @synchronized (self) {
+        [_fonts removeAllObjects];
+    }
+}
+
+- (NSUInteger)hitCount
+{
+    @synchronized (self) {
+        return _hitCount;
+    }
+}
+
+- (NSUInteger)missCount
+{
+    @synchronized (self) {
+        return _missCount;
+    }
+}
+
+@end
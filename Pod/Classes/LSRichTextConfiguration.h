@@ -21,6 +21,8 @@
  */
 
 #import <UIKit/UIKit.h>
+#import "LSFontTraitCache.h"
+#import "LSTagRegistry.h"
 
 /*!
  * @typedef LSRichTextFeatures
@@ -52,6 +54,19 @@ typedef NS_ENUM(NSUInteger, LSRichTextFeatures) {
     LSRichTextFeaturesAll           = 1 << 20
 };
 
+/*!
+ * @typedef LSRichTextBackingStore
+ *
+ * @brief The type of store keeping the text of the rich text view.
+ *
+ * @field LSRichTextBackingStoreAttributedString A NSMutableAttributedString, suits short texts
+ * @field LSRichTextBackingStoreRope A LSRopeAttributedString, keeps edits fast in long documents
+ */
+typedef NS_ENUM(NSUInteger, LSRichTextBackingStore) {
+    LSRichTextBackingStoreAttributedString,
+    LSRichTextBackingStoreRope
+};
+
 /*!
  *  @brief The global configuration object for rich text component.
  *
@@ -59,24 +74,62 @@ typedef NS_ENUM(NSUInteger, LSRichTextFeatures) {
  *              LSRichTextView and is used for global setup. Several editor components
  *              using it for conditional execution.
  */
-@interface LSRichTextConfiguration : NSObject
+@interface LSRichTextConfiguration : NSObject <NSCopying>
 
 /*!
  * Keeps the enum type for configuration features.
  */
 @property (nonatomic, assign) LSRichTextFeatures configurationFeatures;
 
+/*!
+ * Keeps the type of store used by the text storage, it has to be set before the text view
+ * is initialized with the configuration.
+ */
+@property (nonatomic, assign) LSRichTextBackingStore backingStore;
+
+/*!
+ * If set, text set to the text view is shown with the initial text attributes right away.
+ * The visible text is styled first, the rest in chunks while the main thread is idle.
+ * Meant for very long documents, e.g. together with LSRichTextBackingStoreRope.
+ */
+@property (nonatomic, assign) BOOL stylesVisibleTextFirst;
+
 /*!
  * Keeps the value of activated text checking types - NSTextCheckingType
  */
 @property (nonatomic, assign) NSTextCheckingType textCheckingTypes;
 
+/*!
+ * The data detector for the text checking types, nil if there are none. It's created once
+ * and recreated only if the text checking types change, copies of the configuration share it.
+ */
+@property (nonatomic, strong, readonly) NSDataDetector *dataDetector;
+
+/*!
+ * If set, data is detected on a background queue and the found links are set on the
+ * main thread afterwards.
+ */
+@property (nonatomic, assign) BOOL detectsDataInBackground;
+
 /*!
  * A backing field for initially set text formatting attributes to save the
  * values set by interface builder.
  */
 @property (nonatomic, strong) NSMutableDictionary *initialTextAttributes;
 
+/*!
+ * Keeps the tags styled by the editor. Besides the style tags it contains [color], [size]
+ * and [url], custom tags have to be registered before text is set. It's shared with
+ * copies of the configuration.
+ */
+@property (nonatomic, strong) LSTagRegistry *tagRegistry;
+
+/*!
+ * Caches bold and italic fonts resolved while styling. It's shared with copies of the
+ * configuration and invalidated when new initial text attributes are set.
+ */
+@property (nonatomic, strong, readonly) LSFontTraitCache *fontCache;
+
 /*!
  * Sets the default text color.
  */
@@ -23,13 +23,58 @@
 #import "LSRichTextConfiguration.h"
 #import "LSRichTextView.h"
 
+static UIColor *LSColorFromString(NSString *colorString)
+{
+    static NSDictionary *namedColors;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        namedColors = @{@"black" : [UIColor blackColor], @"white" : [UIColor whiteColor],
+                        @"gray" : [UIColor grayColor], @"red" : [UIColor redColor],
+                        @"green" : [UIColor greenColor], @"blue" : [UIColor blueColor],
+                        @"yellow" : [UIColor yellowColor], @"orange" : [UIColor orangeColor],
+                        @"purple" : [UIColor purpleColor], @"brown" : [UIColor brownColor],
+                        @"cyan" : [UIColor cyanColor], @"magenta" : [UIColor magentaColor]};
+    });
+
+    if (colorString.length == 0) {
+        return nil;
+    }
+
+    if (![colorString hasPrefix:@"#"]) {
+        return namedColors[colorString.lowercaseString];
+    }
+
+    NSString *hexString = [colorString substringFromIndex:1];
+    unsigned int rgb = 0;
+
+    if ((hexString.length != 3 && hexString.length != 6) ||
+        ![[NSScanner scannerWithString:hexString] scanHexInt:&rgb]) {
+        return nil;
+    }
+
+    if (hexString.length == 3) {
+        // #rgb is short for #rrggbb
+        rgb = ((rgb & 0xF00) << 12) | ((rgb & 0xF00) << 8) | ((rgb & 0x0F0) << 8) |
+              ((rgb & 0x0F0) << 4) | ((rgb & 0x00F) << 4) | (rgb & 0x00F);
+    }
+
+    return [UIColor colorWithRed:((rgb >> 16) & 0xFF) / 255.0
+                           green:((rgb >> 8) & 0xFF) / 255.0
+                            blue:(rgb & 0xFF) / 255.0
+                           alpha:1.0];
+}
+
 @implementation LSRichTextConfiguration
 
+@synthesize dataDetector = _dataDetector;
+
 - (instancetype)initWithTextFeatures:(LSRichTextFeatures)configurationFeatures
 {
     if (self = [super init])
     {
         self.configurationFeatures = configurationFeatures;
+        _fontCache = [[LSFontTraitCache alloc] init];
+        _tagRegistry = [self createTagRegistry];
     }
     
     return self;
@@ -41,6 +86,80 @@
 }
 
 
+- (id)copyWithZone:(NSZone *)zone
+{
+    LSRichTextConfiguration *configuration = [[[self class] allocWithZone:zone] initWithTextFeatures:self.configurationFeatures];
+
+    configuration.textCheckingTypes = self.textCheckingTypes;
+    configuration.initialTextAttributes = [self.initialTextAttributes mutableCopy];
+    configuration.defaultTextColor = self.defaultTextColor;
+    configuration.highlightColor = self.highlightColor;
+    configuration.backingStore = self.backingStore;
+    configuration.stylesVisibleTextFirst = self.stylesVisibleTextFirst;
+    configuration.detectsDataInBackground = self.detectsDataInBackground;
+    configuration->_dataDetector = self.dataDetector;
+    configuration->_fontCache = self.fontCache;
+    configuration.tagRegistry = self.tagRegistry;
+
+    return configuration;
+}
+
+- (void)setTextCheckingTypes:(NSTextCheckingType)textCheckingTypes
+{
+    @synchronized (self) {
+        if (_textCheckingTypes != textCheckingTypes) {
+            _textCheckingTypes = textCheckingTypes;
+            _dataDetector = nil;
+        }
+    }
+}
+
+- (NSDataDetector *)dataDetector
+{
+    @synchronized (self) {
+        if (!_dataDetector && _textCheckingTypes != 0) {
+            _dataDetector = [[NSDataDetector alloc] initWithTypes:_textCheckingTypes error:NULL];
+        }
+
+        return _dataDetector;
+    }
+}
+
+- (LSTagRegistry *)createTagRegistry
+{
+    LSTagRegistry *tagRegistry = [[LSTagRegistry alloc] init];
+
+    [tagRegistry registerTagName:@"color" withStyle:LSBBCodeStyleNone andHandler:^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {
+        UIColor *color = LSColorFromString(tagAttributes[@"color"]);
+        if (color) {
+            attributes[NSForegroundColorAttributeName] = color;
+        }
+    }];
+
+    [tagRegistry registerTagName:@"size" withStyle:LSBBCodeStyleNone andHandler:^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {
+        UIFont *font = attributes[NSFontAttributeName] ?: baseAttributes[NSFontAttributeName];
+        CGFloat pointSize = [tagAttributes[@"size"] doubleValue];
+        if (font && pointSize >= 1.0) {
+            attributes[NSFontAttributeName] = [font fontWithSize:MIN(pointSize, 200.0)];
+        }
+    }];
+
+    [tagRegistry registerTagName:@"url" withStyle:LSBBCodeStyleNone andHandler:^(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes) {
+        NSURL *url = [NSURL URLWithString:tagAttributes[@"url"] ?: @""];
+        if (url.scheme) {
+            attributes[NSLinkAttributeName] = url;
+        }
+    }];
+
+    return tagRegistry;
+}
+
+- (void)setInitialTextAttributes:(NSMutableDictionary *)initialTextAttributes
+{
+    _initialTextAttributes = initialTextAttributes;
+    [self.fontCache invalidate];
+}
+
 - (void)setInitialAttributesFromTextView:(UITextView *)textView
 {
     NSMutableDictionary *mutableAttributes = [NSMutableDictionary dictionary];
@@ -67,7 +186,7 @@
 
 - (void)setTextCheckingType:(UIDataDetectorTypes)dataDetectorTypes;
 {
-    _textCheckingTypes = NSTextCheckingTypesFromUIDataDetectorTypes(dataDetectorTypes);
+    self.textCheckingTypes = NSTextCheckingTypesFromUIDataDetectorTypes(dataDetectorTypes);
 }
 
 static inline NSTextCheckingType NSTextCheckingTypesFromUIDataDetectorTypes(UIDataDetectorTypes dataDetectorType) {
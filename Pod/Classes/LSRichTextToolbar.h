@@ -22,6 +22,7 @@
 
 #import <UIKit/UIKit.h>
 #import "LSRichTextConfiguration.h"
+#import "LSBBCodeSerializer.h"
 
 /*!
  *  The LSRichTextToolbarDelegate protocol
@@ -78,4 +79,11 @@
  */
 - (void)updateStateWithAttributes:(NSDictionary *)attributes;
 
+/*!
+ *  Updates the toolbar state from a style. Only buttons of styles differing from the
+ *  previous state are updated.
+ *  @param style LSBBCodeStyle the style of the new state.
+ */
+- (void)updateStateWithStyle:(LSBBCodeStyle)style;
+
 @end
@@ -22,6 +22,7 @@
 
 #import "LSRichTextToolbar.h"
 #import "LSToggleButton.h"
+#import "LSUIKitStyleAdapter.h"
 
 #define BUTTON_WITH 40
 #define BUTTON_TOP_AND_BOTTOM_BORDER 5
@@ -140,14 +141,33 @@
 
 - (void)updateStateWithAttributes:(NSDictionary *)attributes
 {
-    UIFontDescriptor *fontDescriptor = [[attributes objectForKey:NSFontAttributeName] fontDescriptor];
-    UIFontDescriptorSymbolicTraits fontDescriptorSymbolicTraits = fontDescriptor.symbolicTraits;
+    [self updateStateWithStyle:[LSUIKitStyleAdapter styleFromAttributes:attributes]];
+}
 
-    self.buttonBold.isActive = (fontDescriptorSymbolicTraits & UIFontDescriptorTraitBold);
-    self.buttonItalic.isActive = (fontDescriptorSymbolicTraits & UIFontDescriptorTraitItalic);
-    
-    self.buttonUnderlined.isActive = [[attributes objectForKey:NSUnderlineStyleAttributeName] intValue] == 1;
-    self.buttonStrikeThrough.isActive = [[attributes objectForKey:NSStrikethroughStyleAttributeName] intValue] == 1;
+- (void)updateStateWithStyle:(LSBBCodeStyle)style
+{
+    // buttons toggle themselves when tapped, so their state is compared and not the previous style
+    LSBBCodeStyle buttonStyle = (self.buttonBold.isActive ? LSBBCodeStyleBold : 0) |
+                                (self.buttonItalic.isActive ? LSBBCodeStyleItalic : 0) |
+                                (self.buttonUnderlined.isActive ? LSBBCodeStyleUnderlined : 0) |
+                                (self.buttonStrikeThrough.isActive ? LSBBCodeStyleStrikeThrough : 0);
+    LSBBCodeStyle changedStyle = style ^ buttonStyle;
+
+    if (changedStyle & LSBBCodeStyleBold) {
+        self.buttonBold.isActive = (style & LSBBCodeStyleBold) != 0;
+    }
+
+    if (changedStyle & LSBBCodeStyleItalic) {
+        self.buttonItalic.isActive = (style & LSBBCodeStyleItalic) != 0;
+    }
+
+    if (changedStyle & LSBBCodeStyleUnderlined) {
+        self.buttonUnderlined.isActive = (style & LSBBCodeStyleUnderlined) != 0;
+    }
+
+    if (changedStyle & LSBBCodeStyleStrikeThrough) {
+        self.buttonStrikeThrough.isActive = (style & LSBBCodeStyleStrikeThrough) != 0;
+    }
 }
 
 #pragma selectors
@@ -71,6 +71,16 @@
  */
 - (void)setText:(NSString *)text;
 
+/*!
+ *  Sets the text asynchronously, markup is parsed on a background queue. Large texts
+ *  don't block the main thread this way.
+ *
+ *  @param text       NSString the new text to be set in the editor, raw or encoded text.
+ *  @param completion called on the main thread when the text is set, finished is NO if
+ *                    the text was superseded by a newer one.
+ */
+- (void)setText:(NSString *)text completion:(void (^)(BOOL finished))completion;
+
 /*!
  *  Resetsall text attributes.
  *
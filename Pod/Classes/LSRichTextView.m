@@ -23,10 +23,12 @@
 
 #import "LSRichTextView.h"
 #import "LSTextStorage.h"
+#import "LSRopeAttributedString.h"
 #import "LSRichTextToolbar.h"
 #import "LSRichTextConfiguration.h"
 
 #define LSTEXTVIEW_TOOLBAR_HEIGHT 40
+#define LSTEXTVIEW_UNSTYLED_TEXT_TIME_BUDGET 0.008
 
 @interface LSRichTextView () <LSRichTextToolbarDelegate, NSLayoutManagerDelegate, NSTextStorageDelegate>
 
@@ -38,6 +40,7 @@
 {
     LSTextStorage *_textStorage;
     BOOL _scrollEnabledSave;
+    BOOL _isStylingUnstyledText;
 }
 
 #pragma mark - view lifecycle
@@ -118,7 +121,11 @@
 
 - (LSTextStorage *)createTextStorage
 {
-    return [[LSTextStorage alloc] initWithTextView:self];
+    NSMutableAttributedString *backingStore = (self.richTextConfiguration.backingStore == LSRichTextBackingStoreRope)
+        ? [LSRopeAttributedString new]
+        : [NSMutableAttributedString new];
+
+    return [[LSTextStorage alloc] initWithTextView:self andBackingStore:backingStore];
 }
 
 #pragma mark - override methods
@@ -133,6 +140,14 @@
     return _textStorage;
 }
 
+- (void)setContentOffset:(CGPoint)contentOffset
+{
+    [super setContentOffset:contentOffset];
+
+    // text scrolled into view is styled before it's laid out and drawn, not during the layout
+    [self styleVisibleText];
+}
+
 - (void)setSelectedTextRange:(UITextRange *)selectedTextRange
 {
     [super setSelectedTextRange:selectedTextRange];
@@ -257,6 +272,12 @@
         [self setSelectedRange:NSMakeRange(newLocation, 0)];
     }
 
+    if (self.richTextConfiguration.stylesVisibleTextFirst) {
+        NSDictionary *attributes = self.richTextConfiguration.initialTextAttributes ?: self.typingAttributes;
+        [self setUnstyledAttributedText:[[NSAttributedString alloc] initWithString:text ?: @"" attributes:attributes]];
+        return;
+    }
+
     [super setText:text];
 
     if (self.richTextConfiguration.textCheckingTypes != 0) {
@@ -264,8 +285,35 @@
     }
 }
 
+- (void)setText:(NSString *)text completion:(void (^)(BOOL finished))completion
+{
+    if (NSMaxRange(self.selectedRange) >= text.length) {
+        NSUInteger newLocation = (text.length > 0) ? text.length - 1 : 0;
+        [self setSelectedRange:NSMakeRange(newLocation, 0)];
+    }
+
+    NSAttributedString *attributedText = [[NSAttributedString alloc] initWithString:text ?: @""
+                                                                         attributes:self.typingAttributes];
+    __weak LSRichTextView *weakSelf = self;
+
+    [self.customTextStorage setAttributedText:attributedText completion:^(BOOL finished) {
+        if (finished && weakSelf.richTextConfiguration.textCheckingTypes != 0) {
+            [weakSelf.customTextStorage processDataDetection];
+        }
+
+        if (completion) {
+            completion(finished);
+        }
+    }];
+}
+
 - (void)setAttributedText:(NSAttributedString *)attributedText
 {
+    if (self.richTextConfiguration.stylesVisibleTextFirst) {
+        [self setUnstyledAttributedText:attributedText];
+        return;
+    }
+
     // use a custom handling of setting text instead of
     // the one from NSTextStorage
     [self.customTextStorage setAttributedText:[attributedText mutableCopy]];
@@ -292,6 +340,114 @@
     self.richTextConfiguration.highlightColor = color;
 }
 
+#pragma mark - lazy styling
+
+- (void)setUnstyledAttributedText:(NSAttributedString *)attributedText
+{
+    // the layout manager only lays out the text up to the visible part
+    self.layoutManager.allowsNonContiguousLayout = YES;
+
+    [self.customTextStorage setUnstyledAttributedText:attributedText];
+    [self styleVisibleText];
+    [self scheduleUnstyledTextStyling];
+}
+
+- (NSRange)visibleCharacterRange
+{
+    CGRect visibleRect = CGRectOffset(self.bounds, -self.textContainerInset.left, -self.textContainerInset.top);
+    NSRange glyphRange = [self.layoutManager glyphRangeForBoundingRect:visibleRect inTextContainer:self.textContainer];
+
+    return [self.layoutManager characterRangeForGlyphRange:glyphRange actualGlyphRange:NULL];
+}
+
+- (void)styleVisibleText
+{
+    if (_isStylingUnstyledText || !self.customTextStorage.hasUnstyledText) {
+        return;
+    }
+
+    NSRange visibleRange = [self visibleCharacterRange];
+
+    [self styleUnstyledTextKeepingVisibleLocation:visibleRange.location usingBlock:^NSRange{
+        return [self.customTextStorage styleUnstyledTextInRange:visibleRange];
+    }];
+}
+
+- (void)styleUnstyledTextChunks
+{
+    CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + LSTEXTVIEW_UNSTYLED_TEXT_TIME_BUDGET;
+
+    [self styleVisibleText];
+
+    while (self.customTextStorage.hasUnstyledText && CFAbsoluteTimeGetCurrent() < deadline) {
+        NSUInteger visibleLocation = [self visibleCharacterRange].location;
+
+        [self styleUnstyledTextKeepingVisibleLocation:visibleLocation usingBlock:^NSRange{
+            return [self.customTextStorage styleUnstyledChunkFromLocation:visibleLocation];
+        }];
+    }
+
+    [self scheduleUnstyledTextStyling];
+}
+
+- (void)scheduleUnstyledTextStyling
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(styleUnstyledTextChunks) object:nil];
+
+    if (!self.customTextStorage.hasUnstyledText) {
+        return;
+    }
+
+    // chunks are styled in the default mode only, not while the user is scrolling
+    [self performSelector:@selector(styleUnstyledTextChunks) withObject:nil afterDelay:0 inModes:@[NSDefaultRunLoopMode]];
+}
+
+- (void)styleUnstyledTextKeepingVisibleLocation:(NSUInteger)visibleLocation usingBlock:(NSRange (^)(void))block
+{
+    NSUInteger length = self.customTextStorage.length;
+    NSRange selectedRange = self.selectedRange;
+    CGFloat visibleOffset = [self verticalOffsetOfCharacterAtIndex:visibleLocation];
+
+    _isStylingUnstyledText = YES;
+    NSRange styledRange = block();
+    _isStylingUnstyledText = NO;
+
+    if (styledRange.location == NSNotFound) {
+        return;
+    }
+
+    NSInteger delta = (NSInteger)self.customTextStorage.length - (NSInteger)length;
+    NSUInteger previousEnd = NSMaxRange(styledRange) - delta;
+
+    if (delta == 0) {
+        return;
+    }
+
+    if (selectedRange.location >= previousEnd) {
+        self.selectedRange = NSMakeRange(selectedRange.location + delta, selectedRange.length);
+    }
+
+    // the removed tags change the height of the text in front of the visible text, it's
+    // scrolled by the difference so the visible text stays in place
+    if (visibleLocation >= previousEnd) {
+        CGFloat offset = [self verticalOffsetOfCharacterAtIndex:visibleLocation + delta] - visibleOffset;
+        _isStylingUnstyledText = YES;
+        self.contentOffset = CGPointMake(self.contentOffset.x, self.contentOffset.y + offset);
+        _isStylingUnstyledText = NO;
+    }
+}
+
+- (CGFloat)verticalOffsetOfCharacterAtIndex:(NSUInteger)index
+{
+    if (index >= self.customTextStorage.length) {
+        return 0;
+    }
+
+    NSUInteger glyphIndex = [self.layoutManager glyphIndexForCharacterAtIndex:index];
+
+    return CGRectGetMinY([self.layoutManager lineFragmentRectForGlyphAtIndex:glyphIndex effectiveRange:NULL]);
+}
+
 #pragma LSRichTextToolbarDelegate methods
 
 - (void)richTextToolbarDidSelectBold:(BOOL)isActive
@@ -318,17 +474,46 @@
 
 - (void)textStorage:(NSTextStorage *)textStorage didProcessEditing:(NSTextStorageEditActions)editedMask range:(NSRange)editedRange changeInLength:(NSInteger)delta
 {
+    NSRange pendingSelectedRange = [self.customTextStorage takePendingSelectedRange];
+
+    if (pendingSelectedRange.location != NSNotFound) {
+        self.selectedRange = pendingSelectedRange;
+    }
+
     [self updateToolbarStatus];
+
+    if ((editedMask & NSTextStorageEditedCharacters) && self.richTextConfiguration.textCheckingTypes != 0) {
+        [self scheduleDataDetection];
+    }
 }
 
 #pragma mark - NSLayoutManagerDelegate methods
 
 #pragma helpers
 
+- (void)scheduleDataDetection
+{
+    // edits of one run loop pass are detected together, attributes can't be changed while editing anyway
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(processPendingDataDetection) object:nil];
+    [self performSelector:@selector(processPendingDataDetection) withObject:nil afterDelay:0];
+}
+
+- (void)processPendingDataDetection
+{
+    [self.customTextStorage processPendingDataDetection];
+}
+
 - (void)updateToolbarStatus
 {
-    NSUInteger location = self.selectedRange.location;
-    [self.toolBar updateStateWithAttributes:[self attributesDictAtIndex:location]];
+    NSRange selectedRange = self.selectedRange;
+
+    // a button is only shown active if its style is set for the whole selection
+    if (selectedRange.length > 0) {
+        [self.toolBar updateStateWithStyle:[self.customTextStorage styleInRange:selectedRange mixedStyle:NULL]];
+        return;
+    }
+
+    [self.toolBar updateStateWithStyle:[self.customTextStorage styleOfAttributes:[self attributesDictAtIndex:selectedRange.location]]];
 }
 
 - (NSDictionary *)attributesDictAtIndex:(NSInteger)index
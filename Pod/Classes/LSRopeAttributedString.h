@@ -0,0 +1,42 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+/*!
+ *  @discussion LSRopeAttributedString is a mutable attributed string keeping its text in a
+ *              balanced tree of small chunks. Every chunk owns the attribute runs of its
+ *              characters, so replacing characters or attributes only touches the chunks in
+ *              the range and their path to the root, instead of moving the tail of the whole
+ *              document. It's meant as backing store of LSTextStorage for long documents.
+ *
+ *              The string returned by -string is a live view onto the chunks, copy it to get
+ *              a snapshot.
+ */
+@interface LSRopeAttributedString : NSMutableAttributedString
+
+/*!
+ *  The number of chunks the text is split into.
+ */
+@property (nonatomic, assign, readonly) NSUInteger chunkCount;
+
+@end
@@ -0,0 +1,705 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSRopeAttributedString.h"
+
+#define LSROPE_CHUNK_SIZE 1024
+#define LSROPE_MAX_CHUNK_SIZE 2048
+#define LSROPE_RUN_CAPACITY 4
+
+static inline BOOL LSRopeAttributesEqual(NSDictionary *attributes, NSDictionary *otherAttributes)
+{
+    return attributes == otherAttributes || [attributes isEqualToDictionary:otherAttributes];
+}
+
+#pragma mark - chunks
+
+/*!
+ *  A node of the treap holding a chunk of text and the attribute runs of its characters.
+ *  The tree is ordered by position, the subtree length is used to find a character index.
+ */
+@interface LSRopeChunk : NSObject {
+@public
+    LSRopeChunk *_left;
+    LSRopeChunk *_right;
+    __unsafe_unretained LSRopeChunk *_parent;
+    uint32_t _priority;
+    NSUInteger _subtreeLength;
+
+    NSMutableString *_text;
+    NSMutableArray *_runAttributes;
+    NSUInteger *_runLengths;
+    NSUInteger _runCount;
+    NSUInteger _runCapacity;
+}
+
+@end
+
+@implementation LSRopeChunk
+
+- (instancetype)initWithString:(NSString *)string attributes:(NSDictionary *)attributes
+{
+    if (self = [super init]) {
+        _priority = arc4random();
+        _text = [string mutableCopy];
+        _subtreeLength = _text.length;
+        _runAttributes = [NSMutableArray arrayWithCapacity:LSROPE_RUN_CAPACITY];
+
+        if (_text.length > 0 && attributes) {
+            [self insertRunWithLength:_text.length attributes:attributes atIndex:0];
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_runLengths);
+}
+
+#pragma mark - runs
+
+- (void)insertRunWithLength:(NSUInteger)length attributes:(NSDictionary *)attributes atIndex:(NSUInteger)index
+{
+    if (_runCount == _runCapacity) {
+        NSUInteger runCapacity = _runCapacity ? _runCapacity * 2 : LSROPE_RUN_CAPACITY;
+        NSUInteger *runLengths = realloc(_runLengths, runCapacity * sizeof(NSUInteger));
+
+        if (!runLengths) {
+            [NSException raise:NSMallocException format:@"Can't grow the rope to %lu runs", (unsigned long)runCapacity];
+        }
+
+        _runLengths = runLengths;
+        _runCapacity = runCapacity;
+    }
+
+    memmove(&_runLengths[index + 1], &_runLengths[index], (_runCount - index) * sizeof(NSUInteger));
+    _runLengths[index] = length;
+    [_runAttributes insertObject:attributes atIndex:index];
+    _runCount++;
+}
+
+- (void)removeRunsInRange:(NSRange)range
+{
+    memmove(&_runLengths[range.location], &_runLengths[NSMaxRange(range)], (_runCount - NSMaxRange(range)) * sizeof(NSUInteger));
+    [_runAttributes removeObjectsInRange:range];
+    _runCount -= range.length;
+}
+
+- (NSUInteger)splitRunAtOffset:(NSUInteger)offset
+{
+    NSUInteger runStart = 0;
+
+    for (NSUInteger index = 0; index < _runCount; index++) {
+        if (offset == runStart) {
+            return index;
+        }
+
+        if (offset < runStart + _runLengths[index]) {
+            NSUInteger headLength = offset - runStart;
+            [self insertRunWithLength:headLength attributes:_runAttributes[index] atIndex:index];
+            _runLengths[index + 1] -= headLength;
+            return index + 1;
+        }
+
+        runStart += _runLengths[index];
+    }
+
+    return _runCount;
+}
+
+- (void)coalesceRunAtIndex:(NSUInteger)index
+{
+    if (index + 1 < _runCount && LSRopeAttributesEqual(_runAttributes[index], _runAttributes[index + 1])) {
+        _runLengths[index] += _runLengths[index + 1];
+        [self removeRunsInRange:NSMakeRange(index + 1, 1)];
+    }
+
+    if (index > 0 && index < _runCount && LSRopeAttributesEqual(_runAttributes[index - 1], _runAttributes[index])) {
+        _runLengths[index - 1] += _runLengths[index];
+        [self removeRunsInRange:NSMakeRange(index, 1)];
+    }
+}
+
+- (NSDictionary *)attributesAtOffset:(NSUInteger)offset effectiveRange:(NSRangePointer)range
+{
+    NSUInteger runStart = 0;
+
+    for (NSUInteger index = 0; index < _runCount; index++) {
+        if (offset < runStart + _runLengths[index]) {
+            if (range) {
+                *range = NSMakeRange(runStart, _runLengths[index]);
+            }
+            return _runAttributes[index];
+        }
+
+        runStart += _runLengths[index];
+    }
+
+    return nil;
+}
+
+#pragma mark - editing
+
+- (void)insertString:(NSString *)string atOffset:(NSUInteger)offset attributes:(NSDictionary *)attributes
+{
+    NSUInteger index = [self splitRunAtOffset:offset];
+
+    [_text insertString:string atIndex:offset];
+    [self insertRunWithLength:string.length attributes:attributes atIndex:index];
+    [self coalesceRunAtIndex:index];
+}
+
+- (void)deleteCharactersInRange:(NSRange)range
+{
+    NSUInteger start = [self splitRunAtOffset:range.location];
+    NSUInteger end = [self splitRunAtOffset:NSMaxRange(range)];
+
+    [_text deleteCharactersInRange:range];
+    [self removeRunsInRange:NSMakeRange(start, end - start)];
+
+    if (start > 0) {
+        [self coalesceRunAtIndex:start - 1];
+    }
+}
+
+- (void)setAttributes:(NSDictionary *)attributes range:(NSRange)range
+{
+    NSUInteger start = [self splitRunAtOffset:range.location];
+    NSUInteger end = [self splitRunAtOffset:NSMaxRange(range)];
+
+    [self removeRunsInRange:NSMakeRange(start, end - start)];
+    [self insertRunWithLength:range.length attributes:attributes atIndex:start];
+    [self coalesceRunAtIndex:start];
+}
+
+- (LSRopeChunk *)splitAtOffset:(NSUInteger)offset
+{
+    NSUInteger index = [self splitRunAtOffset:offset];
+    LSRopeChunk *tail = [[LSRopeChunk alloc] initWithString:[_text substringFromIndex:offset] attributes:nil];
+
+    for (NSUInteger runIndex = index; runIndex < _runCount; runIndex++) {
+        [tail insertRunWithLength:_runLengths[runIndex] attributes:_runAttributes[runIndex] atIndex:tail->_runCount];
+    }
+
+    [self removeRunsInRange:NSMakeRange(index, _runCount - index)];
+    [_text deleteCharactersInRange:NSMakeRange(offset, _text.length - offset)];
+
+    return tail;
+}
+
+- (void)appendChunk:(LSRopeChunk *)chunk
+{
+    NSUInteger index = _runCount;
+
+    [_text appendString:chunk->_text];
+
+    for (NSUInteger runIndex = 0; runIndex < chunk->_runCount; runIndex++) {
+        [self insertRunWithLength:chunk->_runLengths[runIndex] attributes:chunk->_runAttributes[runIndex] atIndex:_runCount];
+    }
+
+    if (index > 0) {
+        [self coalesceRunAtIndex:index - 1];
+    }
+}
+
+@end
+
+#pragma mark - treap
+
+static inline NSUInteger LSRopeLength(LSRopeChunk *chunk)
+{
+    return chunk ? chunk->_subtreeLength : 0;
+}
+
+static void LSRopeUpdate(LSRopeChunk *chunk)
+{
+    chunk->_subtreeLength = LSRopeLength(chunk->_left) + chunk->_text.length + LSRopeLength(chunk->_right);
+
+    if (chunk->_left) {
+        chunk->_left->_parent = chunk;
+    }
+
+    if (chunk->_right) {
+        chunk->_right->_parent = chunk;
+    }
+}
+
+static LSRopeChunk *LSRopeMerge(LSRopeChunk *left, LSRopeChunk *right)
+{
+    if (!left || !right) {
+        return left ?: right;
+    }
+
+    if (left->_priority > right->_priority) {
+        left->_right = LSRopeMerge(left->_right, right);
+        LSRopeUpdate(left);
+        return left;
+    }
+
+    right->_left = LSRopeMerge(left, right->_left);
+    LSRopeUpdate(right);
+    return right;
+}
+
+// splits the tree at a chunk boundary, the first length characters end up in the left tree
+static void LSRopeSplit(LSRopeChunk *chunk, NSUInteger length, LSRopeChunk * __strong *left, LSRopeChunk * __strong *right)
+{
+    if (!chunk) {
+        *left = nil;
+        *right = nil;
+        return;
+    }
+
+    LSRopeChunk *innerLeft;
+    LSRopeChunk *innerRight;
+    NSUInteger leftLength = LSRopeLength(chunk->_left);
+
+    if (length <= leftLength) {
+        LSRopeSplit(chunk->_left, length, &innerLeft, &innerRight);
+        chunk->_left = innerRight;
+        LSRopeUpdate(chunk);
+        *left = innerLeft;
+        *right = chunk;
+    } else {
+        LSRopeSplit(chunk->_right, length - leftLength - chunk->_text.length, &innerLeft, &innerRight);
+        chunk->_right = innerLeft;
+        LSRopeUpdate(chunk);
+        *left = chunk;
+        *right = innerRight;
+    }
+}
+
+static LSRopeChunk *LSRopeNext(LSRopeChunk *chunk)
+{
+    if (chunk->_right) {
+        for (chunk = chunk->_right; chunk->_left; chunk = chunk->_left);
+        return chunk;
+    }
+
+    while (chunk->_parent && chunk->_parent->_right == chunk) {
+        chunk = chunk->_parent;
+    }
+
+    return chunk->_parent;
+}
+
+static NSUInteger LSRopeChunkLocation(LSRopeChunk *chunk)
+{
+    NSUInteger location = LSRopeLength(chunk->_left);
+
+    for (; chunk->_parent; chunk = chunk->_parent) {
+        if (chunk->_parent->_right == chunk) {
+            location += LSRopeLength(chunk->_parent->_left) + chunk->_parent->_text.length;
+        }
+    }
+
+    return location;
+}
+
+static void LSRopeAdjustLength(LSRopeChunk *chunk, NSInteger delta)
+{
+    for (; chunk; chunk = chunk->_parent) {
+        chunk->_subtreeLength += delta;
+    }
+}
+
+#pragma mark - string view
+
+@interface LSRopeString : NSString
+
+- (instancetype)initWithRope:(LSRopeAttributedString *)rope;
+
+@end
+
+@interface LSRopeAttributedString ()
+
+- (LSRopeChunk *)chunkAtIndex:(NSUInteger)index offset:(NSUInteger *)offset;
+- (void)getCharacters:(unichar *)buffer range:(NSRange)range;
+
+@end
+
+@implementation LSRopeString {
+    LSRopeAttributedString *_rope;
+}
+
+- (instancetype)initWithRope:(LSRopeAttributedString *)rope
+{
+    if (self = [super init]) {
+        _rope = rope;
+    }
+
+    return self;
+}
+
+- (NSUInteger)length
+{
+    return _rope.length;
+}
+
+- (unichar)characterAtIndex:(NSUInteger)index
+{
+    NSUInteger offset;
+    LSRopeChunk *chunk = [_rope chunkAtIndex:index offset:&offset];
+
+    if (!chunk) {
+        [NSException raise:NSRangeException format:@"Index %lu out of bounds", (unsigned long)index];
+    }
+
+    return [chunk->_text characterAtIndex:offset];
+}
+
+- (void)getCharacters:(unichar *)buffer range:(NSRange)range
+{
+    [_rope getCharacters:buffer range:range];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return [[NSString allocWithZone:zone] initWithString:self];
+}
+
+@end
+
+#pragma mark - attributed string
+
+@implementation LSRopeAttributedString {
+    LSRopeChunk *_root;
+
+    // the last found chunk, sequential reads are mostly hitting it or its successor
+    LSRopeChunk *_fingerChunk;
+    NSUInteger _fingerLocation;
+
+    __weak LSRopeString *_stringView;
+}
+
+- (instancetype)initWithString:(NSString *)string
+{
+    return [self initWithString:string attributes:nil];
+}
+
+- (instancetype)initWithString:(NSString *)string attributes:(NSDictionary *)attributes
+{
+    if (self = [super init]) {
+        _root = [self chunksWithString:string attributes:[attributes copy] ?: @{}];
+    }
+
+    return self;
+}
+
+- (instancetype)initWithAttributedString:(NSAttributedString *)attributedString
+{
+    if (self = [super init]) {
+        [self setAttributedString:attributedString];
+    }
+
+    return self;
+}
+
+#pragma mark - primitives
+
+- (NSString *)string
+{
+    LSRopeString *stringView = _stringView;
+
+    if (!stringView) {
+        stringView = [[LSRopeString alloc] initWithRope:self];
+        _stringView = stringView;
+    }
+
+    return stringView;
+}
+
+- (NSUInteger)length
+{
+    return LSRopeLength(_root);
+}
+
+- (NSDictionary *)attributesAtIndex:(NSUInteger)location effectiveRange:(NSRangePointer)range
+{
+    NSUInteger offset;
+    LSRopeChunk *chunk = [self chunkAtIndex:location offset:&offset];
+
+    if (!chunk) {
+        [NSException raise:NSRangeException format:@"Index %lu out of bounds", (unsigned long)location];
+    }
+
+    NSDictionary *attributes = [chunk attributesAtOffset:offset effectiveRange:range];
+
+    if (range) {
+        range->location += location - offset;
+    }
+
+    return attributes;
+}
+
+- (void)replaceCharactersInRange:(NSRange)range withString:(NSString *)string
+{
+    [self checkRange:range];
+
+    // same as NSMutableAttributedString, the new characters get the attributes of the first
+    // replaced character, or of the character in front of them
+    NSDictionary *attributes = @{};
+
+    if (range.length > 0 || range.location > 0) {
+        attributes = [self attributesAtIndex:(range.length > 0) ? range.location : range.location - 1 effectiveRange:NULL];
+    } else if (self.length > 0) {
+        attributes = [self attributesAtIndex:0 effectiveRange:NULL];
+    }
+
+    [self removeCharactersInRange:range];
+    [self insertString:string atIndex:range.location attributes:attributes];
+}
+
+- (void)setAttributes:(NSDictionary *)attributes range:(NSRange)range
+{
+    [self checkRange:range];
+
+    attributes = [attributes copy] ?: @{};
+
+    for (NSUInteger location = range.location; location < NSMaxRange(range); ) {
+        NSUInteger offset;
+        LSRopeChunk *chunk = [self chunkAtIndex:location offset:&offset];
+        NSUInteger length = MIN(NSMaxRange(range) - location, chunk->_text.length - offset);
+
+        [chunk setAttributes:attributes range:NSMakeRange(offset, length)];
+        location += length;
+    }
+}
+
+#pragma mark - chunk access
+
+- (void)checkRange:(NSRange)range
+{
+    if (NSMaxRange(range) > self.length) {
+        [NSException raise:NSRangeException format:@"Range %@ out of bounds, length %lu",
+                                                  NSStringFromRange(range), (unsigned long)self.length];
+    }
+}
+
+- (LSRopeChunk *)chunkAtIndex:(NSUInteger)index offset:(NSUInteger *)offset
+{
+    if (_fingerChunk && index >= _fingerLocation) {
+        NSUInteger fingerOffset = index - _fingerLocation;
+
+        if (fingerOffset < _fingerChunk->_text.length) {
+            *offset = fingerOffset;
+            return _fingerChunk;
+        }
+
+        LSRopeChunk *nextChunk = LSRopeNext(_fingerChunk);
+        fingerOffset -= _fingerChunk->_text.length;
+
+        if (nextChunk && fingerOffset < nextChunk->_text.length) {
+            _fingerLocation += _fingerChunk->_text.length;
+            _fingerChunk = nextChunk;
+            *offset = fingerOffset;
+            return nextChunk;
+        }
+    }
+
+    NSUInteger location = index;
+    LSRopeChunk *chunk = _root;
+
+    while (chunk) {
+        NSUInteger leftLength = LSRopeLength(chunk->_left);
+
+        if (location < leftLength) {
+            chunk = chunk->_left;
+            continue;
+        }
+
+        location -= leftLength;
+
+        if (location < chunk->_text.length) {
+            _fingerChunk = chunk;
+            _fingerLocation = index - location;
+            *offset = location;
+            return chunk;
+        }
+
+        location -= chunk->_text.length;
+        chunk = chunk->_right;
+    }
+
+    return nil;
+}
+
+- (void)getCharacters:(unichar *)buffer range:(NSRange)range
+{
+    [self checkRange:range];
+
+    if (range.length == 0) {
+        return;
+    }
+
+    NSUInteger offset;
+    LSRopeChunk *chunk = [self chunkAtIndex:range.location offset:&offset];
+
+    for (NSUInteger copied = 0; copied < range.length; chunk = LSRopeNext(chunk), offset = 0) {
+        NSUInteger length = MIN(range.length - copied, chunk->_text.length - offset);
+        [chunk->_text getCharacters:buffer + copied range:NSMakeRange(offset, length)];
+        copied += length;
+    }
+}
+
+#pragma mark - tree editing
+
+- (LSRopeChunk *)chunksWithString:(NSString *)string attributes:(NSDictionary *)attributes
+{
+    LSRopeChunk *chunks = nil;
+
+    for (NSUInteger location = 0; location < string.length; location += LSROPE_CHUNK_SIZE) {
+        NSRange range = NSMakeRange(location, MIN(LSROPE_CHUNK_SIZE, string.length - location));
+        chunks = LSRopeMerge(chunks, [[LSRopeChunk alloc] initWithString:[string substringWithRange:range]
+                                                               attributes:attributes]);
+        _chunkCount++;
+    }
+
+    return chunks;
+}
+
+- (void)insertChunks:(LSRopeChunk *)chunks atIndex:(NSUInteger)index
+{
+    LSRopeChunk *left;
+    LSRopeChunk *right;
+
+    LSRopeSplit(_root, index, &left, &right);
+    _root = LSRopeMerge(LSRopeMerge(left, chunks), right);
+    _root->_parent = nil;
+}
+
+- (void)removeChunk:(LSRopeChunk *)chunk
+{
+    LSRopeChunk *parent = chunk->_parent;
+    LSRopeChunk *replacement = LSRopeMerge(chunk->_left, chunk->_right);
+
+    if (replacement) {
+        replacement->_parent = parent;
+    }
+
+    if (!parent) {
+        _root = replacement;
+    } else if (parent->_left == chunk) {
+        parent->_left = replacement;
+    } else {
+        parent->_right = replacement;
+    }
+
+    for (; parent; parent = parent->_parent) {
+        LSRopeUpdate(parent);
+    }
+
+    chunk->_left = nil;
+    chunk->_right = nil;
+    chunk->_parent = nil;
+    _chunkCount--;
+}
+
+- (void)splitChunk:(LSRopeChunk *)chunk atOffset:(NSUInteger)offset
+{
+    NSUInteger location = LSRopeChunkLocation(chunk);
+    LSRopeChunk *tail = [chunk splitAtOffset:offset];
+
+    LSRopeAdjustLength(chunk, -(NSInteger)tail->_text.length);
+    [self insertChunks:tail atIndex:location + offset];
+    _chunkCount++;
+}
+
+- (void)insertString:(NSString *)string atIndex:(NSUInteger)index attributes:(NSDictionary *)attributes
+{
+    _fingerChunk = nil;
+
+    if (string.length == 0) {
+        return;
+    }
+
+    if (!_root) {
+        _root = [self chunksWithString:string attributes:attributes];
+        return;
+    }
+
+    // text is appended to the chunk in front of the index, so typing stays within one chunk
+    NSUInteger offset;
+    LSRopeChunk *chunk = [self chunkAtIndex:(index > 0) ? index - 1 : 0 offset:&offset];
+    offset = (index > 0) ? offset + 1 : 0;
+    _fingerChunk = nil;
+
+    if (string.length <= LSROPE_MAX_CHUNK_SIZE) {
+        [chunk insertString:string atOffset:offset attributes:attributes];
+        LSRopeAdjustLength(chunk, string.length);
+
+        if (chunk->_text.length > LSROPE_MAX_CHUNK_SIZE) {
+            [self splitChunk:chunk atOffset:chunk->_text.length / 2];
+        }
+        return;
+    }
+
+    if (offset > 0 && offset < chunk->_text.length) {
+        [self splitChunk:chunk atOffset:offset];
+    }
+
+    [self insertChunks:[self chunksWithString:string attributes:attributes] atIndex:index];
+}
+
+- (void)removeCharactersInRange:(NSRange)range
+{
+    for (NSUInteger remaining = range.length; remaining > 0; ) {
+        NSUInteger offset;
+        LSRopeChunk *chunk = [self chunkAtIndex:range.location offset:&offset];
+        NSUInteger length = MIN(remaining, chunk->_text.length - offset);
+        _fingerChunk = nil;
+
+        if (length == chunk->_text.length) {
+            [self removeChunk:chunk];
+        } else {
+            [chunk deleteCharactersInRange:NSMakeRange(offset, length)];
+            LSRopeAdjustLength(chunk, -(NSInteger)length);
+            [self mergeChunkIfNeeded:chunk];
+        }
+
+        remaining -= length;
+    }
+
+    _fingerChunk = nil;
+}
+
+- (void)mergeChunkIfNeeded:(LSRopeChunk *)chunk
+{
+    // keeps deletes from leaving lots of tiny chunks behind
+    if (chunk->_text.length >= LSROPE_CHUNK_SIZE / 4) {
+        return;
+    }
+
+    LSRopeChunk *nextChunk = LSRopeNext(chunk);
+
+    if (nextChunk && chunk->_text.length + nextChunk->_text.length <= LSROPE_MAX_CHUNK_SIZE) {
+        NSUInteger length = nextChunk->_text.length;
+
+        [self removeChunk:nextChunk];
+        [chunk appendChunk:nextChunk];
+        LSRopeAdjustLength(chunk, length);
+    }
+}
+
+@end
@@ -0,0 +1,132 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import "LSBBCodeSerializer.h"
+
+/*!
+ *  Called for a run of the built text.
+ *
+ *  @param range   the range of the run in the built text.
+ *  @param style   the style of the run.
+ *  @param context the context of the run, NSNotFound if it has none.
+ *  @param stop    set to YES to stop the enumeration.
+ */
+typedef void (^LSStyleRunBlock)(NSRange range, LSBBCodeStyle style, NSUInteger context, BOOL *stop);
+
+/*!
+ *  @discussion LSStyleRunBuilder collects styled runs of a source text and creates the
+ *              styled text at once. Adjacent runs of the same style are merged, so the
+ *              result has as few attribute runs as possible and every character of the
+ *              source is copied only once.
+ *
+ *              Besides the style a run can have a context, an index chosen by the caller
+ *              for attributes the style can't express. Runs are only merged if both match.
+ *
+ *              The builder only depends on Foundation, the styles are mapped to UIKit
+ *              attributes by LSUIKitStyleAdapter.
+ */
+@interface LSStyleRunBuilder : NSObject
+
+/*!
+ *  The source text the run ranges are pointing to.
+ */
+@property (nonatomic, strong, readonly) NSAttributedString *sourceText;
+
+/*!
+ *  The number of runs after merging adjacent runs of the same style.
+ */
+@property (nonatomic, assign, readonly) NSUInteger runCount;
+
+/*!
+ *  Initializes an empty builder for runs of the given source text.
+ *
+ *  @param sourceText the source text.
+ *
+ *  @return an instance of LSStyleRunBuilder.
+ */
+- (instancetype)initWithSourceText:(NSAttributedString *)sourceText;
+
+/*!
+ *  Initializes an empty builder for runs of a source string without attributes.
+ *
+ *  @param sourceString the source string.
+ *
+ *  @return an instance of LSStyleRunBuilder.
+ */
+- (instancetype)initWithSourceString:(NSString *)sourceString;
+
+/*!
+ *  Removes all runs, keeping the allocated storage for the runs of another source text.
+ *
+ *  @param sourceText the new source text.
+ */
+- (void)resetWithSourceText:(NSAttributedString *)sourceText;
+
+/*!
+ *  Appends a run of the source text, it's merged with the previous run if the styles match.
+ *
+ *  @param sourceRange the range of the run in the source text.
+ *  @param style       the style of the run.
+ */
+- (void)addRunWithSourceRange:(NSRange)sourceRange andStyle:(LSBBCodeStyle)style;
+
+/*!
+ *  Appends a run of the source text, it's merged with the previous run if style and context
+ *  match.
+ *
+ *  @param sourceRange the range of the run in the source text.
+ *  @param style       the style of the run.
+ *  @param context     the context of the run, NSNotFound if it has none.
+ */
+- (void)addRunWithSourceRange:(NSRange)sourceRange andStyle:(LSBBCodeStyle)style andContext:(NSUInteger)context;
+
+/*!
+ *  Creates the plain text of all runs.
+ *
+ *  @return the text of all runs.
+ */
+- (NSString *)string;
+
+/*!
+ *  Creates the text of all runs keeping the source attributes, without style attributes.
+ *
+ *  @return the unstyled text of all runs.
+ */
+- (NSMutableAttributedString *)attributedString;
+
+/*!
+ *  Enumerates the merged runs in the order they were added.
+ *
+ *  @param block the block called for every run.
+ */
+- (void)enumerateRunsUsingBlock:(LSStyleRunBlock)block;
+
+/*!
+ *  Appends the text of all runs with their styles to a serializer. The serializer isn't
+ *  finished, so further runs can be appended.
+ *
+ *  @param serializer the serializer the runs are written to.
+ */
+- (void)serializeWithSerializer:(LSBBCodeSerializer *)serializer;
+
+@end
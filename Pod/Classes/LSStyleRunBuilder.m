@@ -0,0 +1,204 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSStyleRunBuilder.h"
+
+#define LSSTYLERUNBUILDER_INITIAL_CAPACITY 64
+
+typedef struct {
+    NSUInteger length;
+    LSBBCodeStyle style;
+    NSUInteger context;
+} LSStyleRun;
+
+@implementation LSStyleRunBuilder {
+    LSStyleRun *_runs;
+    NSUInteger _runCapacity;
+
+    // source ranges copied into the result, contiguous ranges are merged
+    NSRange *_segments;
+    NSUInteger _segmentCount;
+    NSUInteger _segmentCapacity;
+}
+
+- (instancetype)initWithSourceText:(NSAttributedString *)sourceText
+{
+    if (self = [super init]) {
+        _sourceText = sourceText;
+    }
+
+    return self;
+}
+
+- (instancetype)initWithSourceString:(NSString *)sourceString
+{
+    return [self initWithSourceText:[[NSAttributedString alloc] initWithString:sourceString ?: @""]];
+}
+
+- (void)dealloc
+{
+    free(_runs);
+    free(_segments);
+}
+
+- (void)resetWithSourceText:(NSAttributedString *)sourceText
+{
+    _sourceText = sourceText;
+    _runCount = 0;
+    _segmentCount = 0;
+}
+
+- (void)addRunWithSourceRange:(NSRange)sourceRange andStyle:(LSBBCodeStyle)style
+{
+    [self addRunWithSourceRange:sourceRange andStyle:style andContext:NSNotFound];
+}
+
+- (void)addRunWithSourceRange:(NSRange)sourceRange andStyle:(LSBBCodeStyle)style andContext:(NSUInteger)context
+{
+    if (sourceRange.length == 0) {
+        return;
+    }
+
+    [self addSegmentWithSourceRange:sourceRange];
+
+    if (_runCount > 0 && _runs[_runCount - 1].style == style && _runs[_runCount - 1].context == context) {
+        _runs[_runCount - 1].length += sourceRange.length;
+        return;
+    }
+
+    if (_runCount == _runCapacity) {
+        NSUInteger runCapacity = _runCapacity ? _runCapacity * 2 : LSSTYLERUNBUILDER_INITIAL_CAPACITY;
+        LSStyleRun *runs = realloc(_runs, runCapacity * sizeof(LSStyleRun));
+
+        if (!runs) {
+            [NSException raise:NSMallocException format:@"Can't grow the style runs to %lu runs", (unsigned long)runCapacity];
+        }
+
+        _runs = runs;
+        _runCapacity = runCapacity;
+    }
+
+    _runs[_runCount].length = sourceRange.length;
+    _runs[_runCount].style = style;
+    _runs[_runCount].context = context;
+    _runCount++;
+}
+
+- (void)addSegmentWithSourceRange:(NSRange)sourceRange
+{
+    if (_segmentCount > 0 && NSMaxRange(_segments[_segmentCount - 1]) == sourceRange.location) {
+        _segments[_segmentCount - 1].length += sourceRange.length;
+        return;
+    }
+
+    if (_segmentCount == _segmentCapacity) {
+        NSUInteger segmentCapacity = _segmentCapacity ? _segmentCapacity * 2 : LSSTYLERUNBUILDER_INITIAL_CAPACITY;
+        NSRange *segments = realloc(_segments, segmentCapacity * sizeof(NSRange));
+
+        if (!segments) {
+            [NSException raise:NSMallocException format:@"Can't grow the text segments to %lu segments", (unsigned long)segmentCapacity];
+        }
+
+        _segments = segments;
+        _segmentCapacity = segmentCapacity;
+    }
+
+    _segments[_segmentCount++] = sourceRange;
+}
+
+- (NSString *)string
+{
+    NSString *sourceString = self.sourceText.string;
+    NSUInteger length = 0;
+
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        length += _segments[index].length;
+    }
+
+    unichar *characters = malloc(MAX(length, 1) * sizeof(unichar));
+    NSUInteger location = 0;
+
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        [sourceString getCharacters:characters + location range:_segments[index]];
+        location += _segments[index].length;
+    }
+
+    return [[NSString alloc] initWithCharactersNoCopy:characters length:length freeWhenDone:YES];
+}
+
+- (NSMutableAttributedString *)attributedString
+{
+    NSMutableAttributedString *resultString = [[NSMutableAttributedString alloc] init];
+
+    [resultString beginEditing];
+
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        [resultString appendAttributedString:[self.sourceText attributedSubstringFromRange:_segments[index]]];
+    }
+
+    [resultString endEditing];
+
+    return resultString;
+}
+
+- (void)enumerateRunsUsingBlock:(LSStyleRunBlock)block
+{
+    NSUInteger location = 0;
+    BOOL stop = NO;
+
+    for (NSUInteger index = 0; index < _runCount && !stop; index++) {
+        LSStyleRun run = _runs[index];
+        block(NSMakeRange(location, run.length), run.style, run.context, &stop);
+        location += run.length;
+    }
+}
+
+- (void)serializeWithSerializer:(LSBBCodeSerializer *)serializer
+{
+    NSString *sourceString = self.sourceText.string;
+    NSUInteger segmentIndex = 0;
+    NSUInteger segmentOffset = 0;
+
+    // runs and segments are merged independently, so a run can span several segments and vice versa
+    for (NSUInteger index = 0; index < _runCount; index++) {
+        NSUInteger remainingLength = _runs[index].length;
+
+        while (remainingLength > 0) {
+            NSRange segment = _segments[segmentIndex];
+            NSUInteger length = MIN(remainingLength, segment.length - segmentOffset);
+
+            [serializer appendCharactersOfString:sourceString
+                                         inRange:NSMakeRange(segment.location + segmentOffset, length)
+                                       withStyle:_runs[index].style];
+
+            remainingLength -= length;
+            segmentOffset += length;
+
+            if (segmentOffset == segment.length) {
+                segmentIndex++;
+                segmentOffset = 0;
+            }
+        }
+    }
+}
+
+@end
@@ -0,0 +1,100 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+@class LSNodeTree;
+@class LSTagRegistry;
+@class LSStyleRunBuilder;
+
+/*!
+ *  @discussion LSStyleRunCollector walks a parsed node tree and adds a run for every content
+ *              node to a run builder. The style of a run is combined from the registered
+ *              styles of its tag path, tags with a handler add themselves to the tag context
+ *              of the run instead.
+ *
+ *              The collector only depends on Foundation, so markup can be parsed, validated
+ *              and serialized without UIKit, e.g. on a server.
+ */
+@interface LSStyleRunCollector : NSObject
+
+/*!
+ *  The parsed node tree.
+ */
+@property (nonatomic, strong, readonly) LSNodeTree *nodeTree;
+
+/*!
+ *  The registry the styles and handlers of the tags are taken from, can be nil.
+ */
+@property (nonatomic, strong, readonly) LSTagRegistry *tagRegistry;
+
+/*!
+ *  If NO, all runs are collected without style and tag context. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL collectsStyles;
+
+/*!
+ *  The tag contexts referenced by the collected runs. A tag context is an array of tags
+ *  from the outermost inwards, a tag is an array of the tag ID and the tag attributes or
+ *  NSNull if the tag has none.
+ */
+@property (nonatomic, strong, readonly) NSArray *tagContexts;
+
+/*!
+ *  Initializes a collector for a node tree.
+ *
+ *  @param nodeTree    the node tree, created with the same tag registry.
+ *  @param tagRegistry the registry of known tags, can be nil.
+ *
+ *  @return an instance of LSStyleRunCollector.
+ */
+- (instancetype)initWithNodeTree:(LSNodeTree *)nodeTree andTagRegistry:(LSTagRegistry *)tagRegistry;
+
+/*!
+ *  Removes the collected tag contexts for runs of another node tree, keeping the allocated
+ *  storage.
+ *
+ *  @param nodeTree the node tree, created with the same tag registry.
+ */
+- (void)resetWithNodeTree:(LSNodeTree *)nodeTree;
+
+/*!
+ *  Adds the runs of all content nodes to a run builder created for the source string of
+ *  the node tree.
+ *
+ *  @param runBuilder the run builder.
+ */
+- (void)collectRunsIntoBuilder:(LSStyleRunBuilder *)runBuilder;
+
+/*!
+ *  Parses markup and serializes it again, so unknown and unbalanced tags are resolved the
+ *  same way the editor resolves them.
+ *
+ *  @param markup      the markup string.
+ *  @param tagRegistry the registry of known tags, nil for the default tags.
+ *  @param error       set if the markup couldn't be parsed.
+ *
+ *  @return the normalized markup or nil if the markup couldn't be parsed.
+ */
++ (NSString *)normalizedMarkupFromString:(NSString *)markup withTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error;
+
+@end
@@ -0,0 +1,164 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSStyleRunCollector.h"
+#import "LSStyleRunBuilder.h"
+#import "LSParser.h"
+
+@implementation LSStyleRunCollector {
+    NSMutableDictionary *_stylesByTagPath;
+    NSMutableArray *_tagContexts;
+    NSMutableDictionary *_tagContextIndexes;
+}
+
+- (instancetype)initWithNodeTree:(LSNodeTree *)nodeTree andTagRegistry:(LSTagRegistry *)tagRegistry
+{
+    if (self = [super init]) {
+        _nodeTree = nodeTree;
+        _tagRegistry = tagRegistry;
+        _collectsStyles = YES;
+        _stylesByTagPath = [NSMutableDictionary dictionary];
+        _tagContexts = [NSMutableArray array];
+        _tagContextIndexes = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+- (void)resetWithNodeTree:(LSNodeTree *)nodeTree
+{
+    _nodeTree = nodeTree;
+
+    [_stylesByTagPath removeAllObjects];
+    [_tagContexts removeAllObjects];
+    [_tagContextIndexes removeAllObjects];
+}
+
+- (NSArray *)tagContexts
+{
+    return _tagContexts;
+}
+
+- (void)collectRunsIntoBuilder:(LSStyleRunBuilder *)runBuilder
+{
+    [self collectRunsOfNode:self.nodeTree.rootIndex withTagContext:NSNotFound intoBuilder:runBuilder];
+}
+
+- (void)collectRunsOfNode:(NSUInteger)nodeIndex withTagContext:(NSUInteger)tagContext intoBuilder:(LSStyleRunBuilder *)runBuilder
+{
+    LSNodeTree *nodeTree = self.nodeTree;
+    LSNodeRecord currentNode = [nodeTree nodeAtIndex:nodeIndex];
+
+    if (currentNode.tagIndex != NSNotFound) {
+        // tags with a handler add themselves to the tag context of their content
+        if (self.collectsStyles && currentNode.tagIndex < nodeTree.registeredTagCount &&
+            [self.tagRegistry handlerForID:currentNode.tagIndex]) {
+            tagContext = [self tagContextByAppendingNode:nodeIndex toTagContext:tagContext];
+        }
+
+        for (NSUInteger childIndex = currentNode.firstChild; childIndex != NSNotFound; childIndex = [nodeTree nodeAtIndex:childIndex].nextSibling) {
+            [self collectRunsOfNode:childIndex withTagContext:tagContext intoBuilder:runBuilder];
+        }
+        return;
+    }
+
+    LSBBCodeStyle style = LSBBCodeStyleNone;
+
+    if (self.collectsStyles) {
+        // tag paths are interned, so most content nodes share the style of a previous one
+        NSNumber *tagPathKey = @(currentNode.tagPath);
+        NSNumber *cachedStyle = _stylesByTagPath[tagPathKey];
+
+        if (cachedStyle) {
+            style = cachedStyle.unsignedIntegerValue;
+        } else {
+            style = [self styleOfTagPath:currentNode.tagPath];
+            _stylesByTagPath[tagPathKey] = @(style);
+        }
+    }
+
+    [runBuilder addRunWithSourceRange:currentNode.contentRange andStyle:style andContext:tagContext];
+}
+
+- (NSUInteger)tagContextByAppendingNode:(NSUInteger)nodeIndex toTagContext:(NSUInteger)tagContext
+{
+    NSDictionary *tagAttributes = [self.nodeTree attributesOfNodeAtIndex:nodeIndex];
+    NSArray *tag = @[@([self.nodeTree nodeAtIndex:nodeIndex].tagIndex), tagAttributes ?: [NSNull null]];
+    NSArray *tags = (tagContext != NSNotFound) ? [_tagContexts[tagContext] arrayByAddingObject:tag] : @[tag];
+
+    // equal tag contexts share one index, so runs of repeated tags can be merged
+    NSNumber *existingContext = _tagContextIndexes[tags];
+
+    if (existingContext) {
+        return existingContext.unsignedIntegerValue;
+    }
+
+    [_tagContexts addObject:tags];
+    _tagContextIndexes[tags] = @(_tagContexts.count - 1);
+
+    return _tagContexts.count - 1;
+}
+
+- (LSBBCodeStyle)styleOfTagPath:(NSUInteger)tagPath
+{
+    __block LSBBCodeStyle style = LSBBCodeStyleNone;
+    NSUInteger registeredTagCount = self.nodeTree.registeredTagCount;
+    LSTagRegistry *tagRegistry = self.tagRegistry;
+
+    // tag indexes of registered tags are their tag IDs, unknown tags don't have a style
+    [self.nodeTree enumerateTagsOfTagPath:tagPath usingBlock:^(NSUInteger tagIndex, BOOL *stop) {
+        if (tagIndex < registeredTagCount) {
+            style |= [tagRegistry styleForID:tagIndex];
+        }
+    }];
+
+    return style;
+}
+
++ (NSString *)normalizedMarkupFromString:(NSString *)markup withTagRegistry:(LSTagRegistry *)tagRegistry error:(NSError **)error
+{
+    tagRegistry = tagRegistry ?: [[LSTagRegistry alloc] init];
+
+    LSParser *parser = [LSParser new];
+    parser.tagRegistry = tagRegistry;
+
+    NSError *parseError;
+    LSNodeTree *nodeTree = [parser parseNodeTreeFromString:markup error:&parseError];
+
+    if (parseError) {
+        if (error) {
+            *error = parseError;
+        }
+        return nil;
+    }
+
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:markup];
+    [[[LSStyleRunCollector alloc] initWithNodeTree:nodeTree andTagRegistry:tagRegistry] collectRunsIntoBuilder:runBuilder];
+
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:nil andTagRegistry:tagRegistry];
+    [runBuilder serializeWithSerializer:serializer];
+    [serializer finishWithError:nil];
+
+    return serializer.string;
+}
+
+@end
@@ -21,8 +21,10 @@
  */
 
 #import <UIKit/UIKit.h>
+#import "LSBBCodeSerializer.h"
 
 @class LSRichTextView;
+@class LSDocumentSnapshot;
 
 typedef NS_ENUM(NSInteger, LSFontStyleType) {
     LSFontStyleTypeBold,
@@ -31,6 +33,21 @@ typedef NS_ENUM(NSInteger, LSFontStyleType) {
     LSFontStyleTypeStrokeThrough
 };
 
+/*!
+ *  @typedef LSStyleState
+ *
+ *  @brief The state of a style across a range of text.
+ *
+ *  @field LSStyleStateOff   no run of the range has the style.
+ *  @field LSStyleStateOn    every run of the range has the style.
+ *  @field LSStyleStateMixed some runs of the range have the style.
+ */
+typedef NS_ENUM(NSInteger, LSStyleState) {
+    LSStyleStateOff,
+    LSStyleStateOn,
+    LSStyleStateMixed
+};
+
 
 /*!
  *  LSTextStorage is a custom text storage implementation responsible for text modification and
@@ -49,6 +66,16 @@ typedef NS_ENUM(NSInteger, LSFontStyleType) {
  */
 - (instancetype)initWithTextView:(LSRichTextView *)textView;
 
+/*!
+ *  An initializer passing in the text view it's owned by and the store keeping the text.
+ *
+ *  @param textView     the related text view owning the storage instance
+ *  @param backingStore an empty mutable attributed string, e.g. LSRopeAttributedString for long texts
+ *
+ *  @return an instance of LSTextStorage
+ */
+- (instancetype)initWithTextView:(LSRichTextView *)textView andBackingStore:(NSMutableAttributedString *)backingStore;
+
 /*!
  *  The string as raw text.
  *
@@ -64,11 +91,20 @@ typedef NS_ENUM(NSInteger, LSFontStyleType) {
  */
 - (NSString *)createOutputString;
 
-- (NSString *)createOutputString2;
+/*!
+ *  Writes the text in markup format to an output stream, UTF-8 encoded.
+ *
+ *  @param outputStream an opened output stream.
+ *  @param error        set if writing to the stream failed.
+ *
+ *  @return NO if writing to the stream failed.
+ */
+- (BOOL)writeOutputToStream:(NSOutputStream *)outputStream error:(NSError **)error;
 
 /*!
- *  Accessor to modify font trait in the defined range. This method negates the value
- *  which is set actually.
+ *  Accessor to modify font trait in the defined range. The trait is removed if every run
+ *  of the range has it, otherwise it's added. Only the trait of each run is changed, the
+ *  other traits of the run are kept, and all runs are changed in one edit.
  *
  *  @param range      the range to modify the text in.
  *  @param traitValue the trait value to be set.
@@ -77,19 +113,96 @@ typedef NS_ENUM(NSInteger, LSFontStyleType) {
 
 /*!
  *  Accessor to appy the underline or strike through format of text in the specified range.
- *  This method negates the value which is set actually.
+ *  The format is removed if every run of the range has it, otherwise it's added. All runs
+ *  are changed in one edit.
  *
  *  @param range              the range to be modified.
  *  @param styleAttributeName the style attribute name to be changed.
  */
 - (void)applyUnderlineChangeToRange:(NSRange)range andStyleAttributeName:(NSString *)styleAttributeName;
 
+/*!
+ *  Returns the style of text attributes. Styles are cached per attribute dictionary, the
+ *  text storage shares one dictionary per style, so looking up the style of a run only
+ *  costs a pointer compare once it's known.
+ *
+ *  @param attributes the text attributes.
+ *
+ *  @return the style of the attributes.
+ */
+- (LSBBCodeStyle)styleOfAttributes:(NSDictionary *)attributes;
+
+/*!
+ *  Returns the styles of a range of text. Runs are enumerated once without merging, so it
+ *  takes O(log n + runs) time.
+ *
+ *  @param range      the range, for an empty range the style of the character before is returned.
+ *  @param mixedStyle set to the styles only some runs of the range have, can be NULL.
+ *
+ *  @return the styles every run of the range has.
+ */
+- (LSBBCodeStyle)styleInRange:(NSRange)range mixedStyle:(LSBBCodeStyle *)mixedStyle;
+
+/*!
+ *  Returns the state of a style across a range of text.
+ *
+ *  @param style the style.
+ *  @param range the range.
+ *
+ *  @return on if every run has the style, off if none has it, mixed otherwise.
+ */
+- (LSStyleState)stateOfStyle:(LSBBCodeStyle)style inRange:(NSRange)range;
+
+/*!
+ *  YES while a formatting transaction is open.
+ */
+@property (nonatomic, assign, readonly) BOOL isInFormattingTransaction;
+
+/*!
+ *  Opens a formatting transaction. The ranges of attribute changes made until the transaction
+ *  is committed are collected instead of being reported one by one. Transactions can be nested,
+ *  only the outermost commit reports the changes.
+ */
+- (void)beginFormattingTransaction;
+
+/*!
+ *  Commits a formatting transaction. The collected ranges are merged into the smallest range
+ *  covering all of them, so the text is processed, the delegate is called and the text is
+ *  laid out once for all changes of the transaction.
+ */
+- (void)commitFormattingTransaction;
+
+/*!
+ *  Performs a block in a formatting transaction.
+ *
+ *  @param block the block applying styles, links or replacements to the text storage.
+ */
+- (void)performFormattingTransaction:(void (^)(void))block;
+
+/*!
+ *  Returns the selection to set after markup typed by the user was replaced by styled text and
+ *  resets it. The location is NSNotFound if no replacement happened since the last call.
+ */
+- (NSRange)takePendingSelectedRange;
+
+/*!
+ *  YES if lines were edited since data was detected in them the last time.
+ */
+@property (nonatomic, assign, readonly) BOOL hasPendingDataDetection;
+
 /*!
  *  Starts the data detection process. The process tries to find data of the specified typ set in the
  *  configuration object. Therefore, the full text range is checked.
  */
 - (void)processDataDetection;
 
+/*!
+ *  Detects data in the lines edited since the last detection only. The detection runs on a
+ *  background queue if the configuration says so, the links are set on the main thread.
+ *  Results are dropped and the lines are detected again if the text changes in the meantime.
+ */
+- (void)processPendingDataDetection;
+
 /*!
  *  An accessor for setting the attributed text from the outside.
  *
@@ -97,4 +210,63 @@ typedef NS_ENUM(NSInteger, LSFontStyleType) {
  */
 - (void)setAttributedText:(NSAttributedString *)attributedText;
 
+/*!
+ *  Sets the attributed text asynchronously. The markup is parsed and styled on a background
+ *  queue with a copy of the configuration, the result is set on the main thread in one
+ *  editing transaction. Setting a text again cancels the pending one.
+ *
+ *  @param attributedText an attributed text string.
+ *  @param completion     called on the main thread, finished is NO if the text was superseded.
+ */
+- (void)setAttributedText:(NSAttributedString *)attributedText completion:(void (^)(BOOL finished))completion;
+
+/*!
+ *  Sets the styled text of a snapshot without scanning or parsing markup. The runs of the
+ *  snapshot are styled with the initial text attributes and the tag handlers of the configuration.
+ *
+ *  @param snapshot a snapshot loaded with the tag registry of the configuration.
+ */
+- (void)setSnapshot:(LSDocumentSnapshot *)snapshot;
+
+/*!
+ *  Creates a snapshot of the styled text. Like the output string it keeps the styles of the
+ *  text only, attributes added by tag handlers aren't part of it.
+ *
+ *  @return the snapshot data or nil if the text is too large for the snapshot format.
+ */
+- (NSData *)snapshotData;
+
+/*!
+ *  YES while parts of a text set by setUnstyledAttributedText: aren't styled yet.
+ */
+@property (nonatomic, assign, readonly) BOOL hasUnstyledText;
+
+/*!
+ *  Sets the attributed text without parsing it. The text is shown with its markup and the
+ *  given attributes until it's styled chunk by chunk with the methods below.
+ *
+ *  @param attributedText an attributed text string, usually with the initial text attributes.
+ */
+- (void)setUnstyledAttributedText:(NSAttributedString *)attributedText;
+
+/*!
+ *  Styles the unstyled text in a range, e.g. the visible one. The range is extended to whole
+ *  lines and until the tags in it are balanced.
+ *
+ *  @param range the range to be styled.
+ *
+ *  @return the range of the styled text after styling, the location is NSNotFound if nothing was styled.
+ */
+- (NSRange)styleUnstyledTextInRange:(NSRange)range;
+
+/*!
+ *  Styles the next chunk of unstyled text. The text following the location is styled first,
+ *  the text in front of it afterwards.
+ *
+ *  @param location the location to start at, e.g. the first visible character.
+ *
+ *  @return the range of the styled text after styling, the location is NSNotFound if all text is styled.
+ */
+- (NSRange)styleUnstyledChunkFromLocation:(NSUInteger)location;
+
 @end
@@ -23,24 +23,232 @@
 #import "LSTextStorage.h"
 #import "LSRichTextView.h"
 #import "LSParser.h"
+#import "LSBBCodeSerializer.h"
+#import "LSStyleRunBuilder.h"
+#import "LSStyleRunCollector.h"
+#import "LSUIKitStyleAdapter.h"
+#import "LSAttributesCache.h"
+#import "LSDocumentSnapshot.h"
+#import "LSTrace.h"
+
+#define LSTEXTSTORAGE_MAX_MARKUP_LINES 16
+#define LSTEXTSTORAGE_MAX_MARKUP_DISTANCE 4096
+#define LSTEXTSTORAGE_MAX_TAG_LENGTH 256
+#define LSTEXTSTORAGE_MAX_SCANNED_TAG_DEPTH 64
+#define LSTEXTSTORAGE_UNSTYLED_CHUNK_LENGTH 8192
+#define LSTEXTSTORAGE_MAX_UNSTYLED_CHUNK_LENGTH 65536
+#define LSTEXTSTORAGE_MAX_CACHED_STYLES 1024
+
+// marks the links set by data detection, so links from the markup survive a new detection pass
+static NSString * const LSTextStorageDetectedLinkAttributeName = @"LSTextStorageDetectedLink";
 
 @interface LSTextStorage ()
 
 @property (nonatomic, strong, readonly) LSRichTextView *textView;
-@property (nonatomic, strong, readonly) NSArray *allowedTags;
+@property (atomic, assign) NSUInteger styleGeneration;
 
 @end
 
+typedef struct {
+    // from the start of the scanned markup to the end of the last matched close tag
+    NSRange matchedRange;
+    NSUInteger unmatchedCloseTags;
+    NSUInteger unclosedOpenTags;
+    BOOL hasUnterminatedTag;
+} LSTextStorageMarkupScan;
+
+static inline unichar LSTextStorageCharacterAtIndex(CFStringInlineBuffer *buffer, NSUInteger index)
+{
+    return CFStringGetCharacterFromInlineBuffer(buffer, (CFIndex)index);
+}
+
+static inline BOOL LSTextStorageIsLineBreak(unichar character)
+{
+    return character == '\n' || character == '\r' || character == 0x2028 || character == 0x2029;
+}
+
+static NSUInteger LSTextStorageTagNameLength(CFStringInlineBuffer *buffer, NSRange valueRange)
+{
+    for (NSUInteger index = valueRange.location; index < NSMaxRange(valueRange); index++) {
+        unichar character = LSTextStorageCharacterAtIndex(buffer, index);
+        if (character == ' ' || character == '=') {
+            return index - valueRange.location;
+        }
+    }
+
+    return valueRange.length;
+}
+
+static BOOL LSTextStorageTagNamesAreEqual(CFStringInlineBuffer *buffer, NSRange firstName, NSRange secondName)
+{
+    if (firstName.length != secondName.length) {
+        return NO;
+    }
+
+    for (NSUInteger index = 0; index < firstName.length; index++) {
+        if (LSTextStorageCharacterAtIndex(buffer, firstName.location + index) != LSTextStorageCharacterAtIndex(buffer, secondName.location + index)) {
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+// matches tags like the parser does, the tag names are compared in place without creating strings
+static LSTextStorageMarkupScan LSTextStorageScanMarkup(CFStringInlineBuffer *buffer, NSRange range)
+{
+    NSRange openTagNames[LSTEXTSTORAGE_MAX_SCANNED_TAG_DEPTH];
+    NSUInteger openTagCount = 0;
+    NSUInteger end = NSMaxRange(range);
+    LSTextStorageMarkupScan scan = {NSMakeRange(range.location, 0), 0, 0, NO};
+
+    for (NSUInteger location = range.location; location < end; location++) {
+        if (LSTextStorageCharacterAtIndex(buffer, location) != '[') {
+            continue;
+        }
+
+        BOOL isCloseTag = (location + 1 < end && LSTextStorageCharacterAtIndex(buffer, location + 1) == '/');
+        NSUInteger valueLocation = location + (isCloseTag ? 2 : 1);
+        NSUInteger tagEnd = valueLocation;
+
+        while (tagEnd < end && LSTextStorageCharacterAtIndex(buffer, tagEnd) != ']') {
+            tagEnd++;
+        }
+
+        if (tagEnd >= end) {
+            // no tag follows an unterminated one, it's content like any other text
+            scan.hasUnterminatedTag = YES;
+            break;
+        }
+
+        location = tagEnd;
+
+        if (tagEnd == valueLocation) {
+            // the parser fails on empty tags, so the markup starts behind them
+            scan.matchedRange = NSMakeRange(tagEnd + 1, 0);
+            scan.unmatchedCloseTags = 0;
+            openTagCount = 0;
+            continue;
+        }
+
+        NSRange tagName = NSMakeRange(valueLocation, LSTextStorageTagNameLength(buffer, NSMakeRange(valueLocation, tagEnd - valueLocation)));
+
+        if (!isCloseTag) {
+            if (openTagCount < LSTEXTSTORAGE_MAX_SCANNED_TAG_DEPTH) {
+                openTagNames[openTagCount++] = tagName;
+            }
+            continue;
+        }
+
+        NSUInteger openTagIndex = openTagCount;
+        while (openTagIndex > 0 && !LSTextStorageTagNamesAreEqual(buffer, openTagNames[openTagIndex - 1], tagName)) {
+            openTagIndex--;
+        }
+
+        if (openTagIndex == 0) {
+            scan.unmatchedCloseTags++;
+        } else {
+            // the parser closes all tags opened after the matching one as well
+            openTagCount = openTagIndex - 1;
+            scan.matchedRange.length = tagEnd + 1 - scan.matchedRange.location;
+        }
+    }
+
+    scan.unclosedOpenTags = openTagCount;
+
+    return scan;
+}
+
+// YES if the edit changed the brackets of a tag or the text between them
+static BOOL LSTextStorageEditTouchesTag(CFStringInlineBuffer *buffer, NSUInteger length, NSRange editedRange)
+{
+    for (NSUInteger index = editedRange.location; index < NSMaxRange(editedRange); index++) {
+        unichar character = LSTextStorageCharacterAtIndex(buffer, index);
+        if (character == '[' || character == ']') {
+            return YES;
+        }
+    }
+
+    unichar bracketInFront = 0;
+
+    for (NSUInteger index = editedRange.location; index > 0 && editedRange.location - index < LSTEXTSTORAGE_MAX_TAG_LENGTH; index--) {
+        unichar character = LSTextStorageCharacterAtIndex(buffer, index - 1);
+        if (character == '[' || character == ']') {
+            bracketInFront = character;
+            break;
+        }
+    }
+
+    if (bracketInFront != '[') {
+        return NO;
+    }
+
+    for (NSUInteger index = NSMaxRange(editedRange); index < length && index - NSMaxRange(editedRange) < LSTEXTSTORAGE_MAX_TAG_LENGTH; index++) {
+        unichar character = LSTextStorageCharacterAtIndex(buffer, index);
+        if (character == '[' || character == ']') {
+            return character == ']';
+        }
+    }
+
+    return NO;
+}
+
+// the start of the line containing the location, not searched in front of the limit
+static NSUInteger LSTextStorageLineStart(CFStringInlineBuffer *buffer, NSUInteger location, NSUInteger limit)
+{
+    while (location > limit && !LSTextStorageIsLineBreak(LSTextStorageCharacterAtIndex(buffer, location - 1))) {
+        location--;
+    }
+
+    return location;
+}
+
+// the end of the line containing the location including its line break, not searched behind the limit
+static NSUInteger LSTextStorageLineEnd(CFStringInlineBuffer *buffer, NSUInteger location, NSUInteger limit)
+{
+    while (location < limit && !LSTextStorageIsLineBreak(LSTextStorageCharacterAtIndex(buffer, location))) {
+        location++;
+    }
+
+    return MIN(location + 1, limit);
+}
+
 @implementation LSTextStorage {
     NSMutableAttributedString *_backingStore;
+    NSMutableIndexSet *_unstyledIndexes;
+    NSMutableIndexSet *_dirtyDataIndexes;
+    NSMutableIndexSet *_detectingDataIndexes;
+    NSUInteger _characterEditCount;
+    BOOL _isApplyingStyles;
+    BOOL _isDetectingData;
+
+    NSUInteger _transactionDepth;
+    NSMutableIndexSet *_transactionEditedIndexes;
+
+    LSAttributesCache *_attributesCache;
+    NSMapTable *_stylesByAttributes;
+
+    NSRange _pendingSelectedRange;
 }
 
 - (instancetype)initWithTextView:(LSRichTextView *)textView
+{
+    return [self initWithTextView:textView andBackingStore:[NSMutableAttributedString new]];
+}
+
+- (instancetype)initWithTextView:(LSRichTextView *)textView andBackingStore:(NSMutableAttributedString *)backingStore
 {
     if (self = [super init]) {
-        _backingStore = [NSMutableAttributedString new];
+        _backingStore = backingStore;
+        _unstyledIndexes = [NSMutableIndexSet indexSet];
+        _dirtyDataIndexes = [NSMutableIndexSet indexSet];
+        _detectingDataIndexes = [NSMutableIndexSet indexSet];
+        _transactionEditedIndexes = [NSMutableIndexSet indexSet];
+        _pendingSelectedRange = NSMakeRange(NSNotFound, 0);
+        _attributesCache = [[LSAttributesCache alloc] init];
+        _stylesByAttributes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                    valueOptions:NSPointerFunctionsStrongMemory];
         _textView = textView;
-        _allowedTags = @[@"b", @"i", @"u", @"s"];
     }
     return self;
 }
@@ -65,51 +273,132 @@
 
 - (void)replaceCharactersInRange:(NSRange)range withString:(NSString *)str
 {
-    NSLog(@"replaceCharactersInRange:%@ withString:%@", NSStringFromRange(range), str);
+    LSTrace(LSTraceCategoryLayout, LSTraceLevelDebug, "replaceCharactersInRange {%lu, %lu} with %lu characters",
+            (unsigned long)range.location, (unsigned long)range.length, (unsigned long)str.length);
 
     [self beginEditing];
+    [self replaceBackingCharactersInRange:range withString:str];
+    [self endEditing];
+}
+
+- (void)replaceBackingCharactersInRange:(NSRange)range withString:(NSString *)str
+{
     [_backingStore replaceCharactersInRange:range withString:str];
+
+    NSInteger delta = (NSInteger)str.length - (NSInteger)range.length;
+
+    for (NSMutableIndexSet *indexes in @[_unstyledIndexes, _dirtyDataIndexes, _detectingDataIndexes, _transactionEditedIndexes]) {
+        if (indexes.count > 0) {
+            [indexes removeIndexesInRange:range];
+            [indexes shiftIndexesStartingAtIndex:NSMaxRange(range) by:delta];
+        }
+    }
+
+    // data is detected again in the edited lines only
+    [_dirtyDataIndexes addIndexesInRange:[_backingStore.string lineRangeForRange:NSMakeRange(range.location, str.length)]];
+    _characterEditCount++;
+
     [self edited:NSTextStorageEditedCharacters | NSTextStorageEditedAttributes
            range:range
   changeInLength:str.length - range.length];
-    [self endEditing];
 }
 
 - (void)setAttributes:(NSDictionary *)attrs range:(NSRange)range
 {
-    NSLog(@"setAttributes:%@ range:%@", attrs, NSStringFromRange(range));
-    
-    NSMutableDictionary *attributes = [NSMutableDictionary dictionaryWithDictionary:attrs];
-    
-    UIFont *font = [attrs objectForKey:NSFontAttributeName];
-    
-    if (!font) {
-        attributes = [NSMutableDictionary dictionaryWithDictionary:
-                      self.textView.richTextConfiguration.initialTextAttributes];
-    }
+    LSTrace(LSTraceCategoryLayout, LSTraceLevelDebug, "setAttributes of %lu keys in range {%lu, %lu}",
+            (unsigned long)attrs.count, (unsigned long)range.location, (unsigned long)range.length);
+
+    // equal attributes share one instance, so the backing store keeps one dictionary per style
+    NSDictionary *attributes = [attrs objectForKey:NSFontAttributeName]
+        ? [_attributesCache internedAttributes:attrs]
+        : [_attributesCache internedAttributes:self.textView.richTextConfiguration.initialTextAttributes ?: @{}];
 
     [self beginEditing];
     [_backingStore setAttributes:attributes range:range];
-    [self edited:NSTextStorageEditedAttributes range:range changeInLength:0];
+    [self editedAttributesInRange:range];
+    [self endEditing];
+}
+
+#pragma mark - formatting transactions
+
+- (BOOL)isInFormattingTransaction
+{
+    return _transactionDepth > 0;
+}
+
+- (void)beginFormattingTransaction
+{
+    if (_transactionDepth++ == 0) {
+        [self beginEditing];
+    }
+}
+
+- (void)commitFormattingTransaction
+{
+    if (_transactionDepth == 0 || --_transactionDepth > 0) {
+        return;
+    }
+
+    if (_transactionEditedIndexes.count > 0) {
+        NSRange editedRange = NSMakeRange(_transactionEditedIndexes.firstIndex,
+                                          _transactionEditedIndexes.lastIndex - _transactionEditedIndexes.firstIndex + 1);
+
+        LSTrace(LSTraceCategoryLayout, LSTraceLevelInfo, "Committing %lu edited characters as {%lu, %lu}",
+                (unsigned long)_transactionEditedIndexes.count, (unsigned long)editedRange.location, (unsigned long)editedRange.length);
+
+        [_transactionEditedIndexes removeAllIndexes];
+        [self edited:NSTextStorageEditedAttributes range:editedRange changeInLength:0];
+    }
+
     [self endEditing];
 }
 
+- (void)performFormattingTransaction:(void (^)(void))block
+{
+    [self beginFormattingTransaction];
+    block();
+    [self commitFormattingTransaction];
+}
+
+- (void)editedAttributesInRange:(NSRange)range
+{
+    // attribute changes of a transaction are reported once on commit
+    if (_transactionDepth > 0) {
+        [_transactionEditedIndexes addIndexesInRange:range];
+        return;
+    }
+
+    [self edited:NSTextStorageEditedAttributes range:range changeInLength:0];
+}
+
 #pragma mark - input formatting
 
 - (void)processEditing
 {
-    // TODO: needs to be adapted for real time checking of tags
-    /*
     LSRichTextFeatures features = self.textView.richTextConfiguration.configurationFeatures;
-    if (features & ~LSRichTextFeaturesNone) {
+
+    if (!_isApplyingStyles && (self.editedMask & NSTextStorageEditedCharacters) &&
+        (features & ~LSRichTextFeaturesNone) && (features & ~LSRichTextFeaturesPlainText)) {
         [self performReplacementsForRange:[self editedRange]];
     }
-     */
+
     [super processEditing];
 }
 
+- (NSRange)takePendingSelectedRange
+{
+    NSRange selectedRange = _pendingSelectedRange;
+    _pendingSelectedRange = NSMakeRange(NSNotFound, 0);
+
+    return selectedRange;
+}
+
 - (void)setAttributedText:(NSAttributedString *)attributedText
 {
+    // cancels styling of text set asynchronously before
+    ++self.styleGeneration;
+    [_unstyledIndexes removeAllIndexes];
+
     NSRange extendedRange = [self calculateMultilineRange:NSMakeRange(0, attributedText.length) andTextString:attributedText.string];
     LSRichTextFeatures features = self.textView.richTextConfiguration.configurationFeatures;
 
@@ -122,87 +411,538 @@
 
 - (void)performReplacementsForRange:(NSRange)changedRange
 {
-    // TODO: needs to be adapted for real time checking of tags
-    /*
-    NSRange extendedRange = [self calculateMultilineRange:changedRange];
-    [self applyStylesToRange:extendedRange];
-     */
+    NSRange markupRange = [self calculateMarkupRange:changedRange];
+
+    if (markupRange.location == NSNotFound) {
+        return;
+    }
+
+    NSAttributedString *styledText = [self replaceMarkupRangeWithStyledText:markupRange];
+
+    if (!styledText) {
+        return;
+    }
+
+    NSUInteger caretLocation = NSMaxRange(changedRange);
+
+    if (caretLocation >= NSMaxRange(markupRange)) {
+        caretLocation = caretLocation - markupRange.length + styledText.length;
+    } else if (caretLocation > markupRange.location) {
+        caretLocation = MIN(caretLocation, markupRange.location + styledText.length);
+    }
+
+    // the tags removed in front of the caret are accounted for by the text view once editing ended
+    _pendingSelectedRange = NSMakeRange(MIN(caretLocation, self.length), 0);
+}
+
+- (NSAttributedString *)replaceMarkupRangeWithStyledText:(NSRange)markupRange
+{
+    NSAttributedString *markupText = [_backingStore attributedSubstringFromRange:markupRange];
+    NSAttributedString *styledText = [self styledStringFromAttributedText:markupText
+                                                        withConfiguration:self.textView.richTextConfiguration];
+
+    if (!styledText) {
+        return nil;
+    }
+
+    // only the markup region is replaced, the text and attributes around it are kept as they are
+    // the replacement joins the current edit, callers outside of processEditing begin and end it
+    BOOL wasApplyingStyles = _isApplyingStyles;
+    _isApplyingStyles = YES;
+    [self replaceBackingCharactersInRange:markupRange withString:styledText.string];
+    [styledText enumerateAttributesInRange:NSMakeRange(0, styledText.length) options:0 usingBlock:^(NSDictionary *attrs, NSRange range, BOOL *stop) {
+        [_backingStore setAttributes:[_attributesCache internedAttributes:attrs]
+                               range:NSMakeRange(markupRange.location + range.location, range.length)];
+    }];
+    _isApplyingStyles = wasApplyingStyles;
+
+    return styledText;
+}
+
+- (NSRange)calculateMarkupRange:(NSRange)changedRange
+{
+    NSString *string = _backingStore.string;
+    NSUInteger length = string.length;
+    CFStringInlineBuffer buffer;
+    CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+    // typing text outside of tags never completes a tag, so most keystrokes stop here
+    if (!LSTextStorageEditTouchesTag(&buffer, length, changedRange)) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+
+    // only the text around the edit is scanned, long paragraphs aren't scanned completely on every keystroke
+    NSUInteger scanStart = (changedRange.location > LSTEXTSTORAGE_MAX_MARKUP_DISTANCE) ? changedRange.location - LSTEXTSTORAGE_MAX_MARKUP_DISTANCE : 0;
+    NSUInteger scanEnd = MIN(length, NSMaxRange(changedRange) + LSTEXTSTORAGE_MAX_MARKUP_DISTANCE);
+    NSUInteger markupStart = LSTextStorageLineStart(&buffer, changedRange.location, scanStart);
+    NSUInteger markupEnd = LSTextStorageLineEnd(&buffer, NSMaxRange(changedRange), scanEnd);
+    LSTextStorageMarkupScan scan;
+
+    for (NSUInteger lineCount = 1; ; lineCount++) {
+        scan = LSTextStorageScanMarkup(&buffer, NSMakeRange(markupStart, markupEnd - markupStart));
+
+        if (scan.unmatchedCloseTags == 0 || markupStart == scanStart || lineCount == LSTEXTSTORAGE_MAX_MARKUP_LINES) {
+            break;
+        }
+
+        // a close tag without its open tag, the tag starts in one of the previous lines
+        markupStart = LSTextStorageLineStart(&buffer, markupStart - 1, scanStart);
+    }
+
+    if (scan.matchedRange.length == 0) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+
+    return scan.matchedRange;
+}
+
+- (void)setAttributedText:(NSAttributedString *)attributedText completion:(void (^)(BOOL finished))completion
+{
+    LSRichTextFeatures features = self.textView.richTextConfiguration.configurationFeatures;
+
+    if (!(features & ~LSRichTextFeaturesNone)) {
+        [self setAttributedText:attributedText];
+        if (completion) {
+            completion(YES);
+        }
+        return;
+    }
+
+    // the configuration can be changed on the main thread while parsing, so a copy is used
+    LSRichTextConfiguration *configuration = [self.textView.richTextConfiguration copy];
+    NSAttributedString *sourceText = [attributedText copy];
+    NSUInteger generation = ++self.styleGeneration;
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSAttributedString *styledText = nil;
+
+        if (generation == self.styleGeneration) {
+            styledText = [[self styledStringFromAttributedText:sourceText withConfiguration:configuration] copy];
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // a newer text was set in the meantime
+            if (generation != self.styleGeneration) {
+                if (completion) {
+                    completion(NO);
+                }
+                return;
+            }
+
+            [self commitStyledText:styledText ?: sourceText];
+
+            if (completion) {
+                completion(YES);
+            }
+        });
+    });
+}
+
+#pragma mark - lazy styling
+
+- (void)setUnstyledAttributedText:(NSAttributedString *)attributedText
+{
+    ++self.styleGeneration;
+
+    [self commitStyledText:attributedText];
+
+    // the markup isn't searched for data, the chunks are searched once they are styled
+    [_dirtyDataIndexes removeAllIndexes];
+
+    LSRichTextFeatures features = self.textView.richTextConfiguration.configurationFeatures;
+
+    if ((features & ~LSRichTextFeaturesNone) && (features & ~LSRichTextFeaturesPlainText)) {
+        [_unstyledIndexes addIndexesInRange:NSMakeRange(0, _backingStore.length)];
+    }
+}
+
+- (BOOL)hasUnstyledText
+{
+    return _unstyledIndexes.count > 0;
+}
+
+- (NSRange)styleUnstyledTextInRange:(NSRange)range
+{
+    NSRange styledRange = NSMakeRange(NSNotFound, 0);
+    NSInteger end = NSMaxRange(range);
+    NSUInteger location = range.location;
+
+    while ((NSInteger)location < end) {
+        NSUInteger index = [_unstyledIndexes indexGreaterThanOrEqualToIndex:location];
+
+        if (index == NSNotFound || (NSInteger)index >= end) {
+            break;
+        }
+
+        NSUInteger length = _backingStore.length;
+        NSRange chunkRange = [self styleUnstyledRange:NSMakeRange(index, end - index)];
+
+        end += (NSInteger)_backingStore.length - (NSInteger)length;
+        location = NSMaxRange(chunkRange);
+        styledRange = (styledRange.location == NSNotFound) ? chunkRange : NSUnionRange(styledRange, chunkRange);
+    }
+
+    return styledRange;
+}
+
+- (NSRange)styleUnstyledChunkFromLocation:(NSUInteger)location
+{
+    // the text following the location is styled first, the text in front of it afterwards
+    NSUInteger index = [_unstyledIndexes indexGreaterThanOrEqualToIndex:location];
+
+    if (index != NSNotFound) {
+        return [self styleUnstyledRange:NSMakeRange(index, MIN(LSTEXTSTORAGE_UNSTYLED_CHUNK_LENGTH, _backingStore.length - index))];
+    }
+
+    index = [_unstyledIndexes indexLessThanIndex:location];
+
+    if (index == NSNotFound) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+
+    NSUInteger chunkStart = (index + 1 > LSTEXTSTORAGE_UNSTYLED_CHUNK_LENGTH) ? index + 1 - LSTEXTSTORAGE_UNSTYLED_CHUNK_LENGTH : 0;
+    chunkStart = MAX(chunkStart, [self unstyledRegionContainingIndex:index].location);
+
+    return [self styleUnstyledRange:NSMakeRange(chunkStart, index + 1 - chunkStart)];
+}
+
+- (NSRange)styleUnstyledRange:(NSRange)range
+{
+    NSString *string = _backingStore.string;
+    NSRange region = [self unstyledRegionContainingIndex:range.location];
+    NSRange chunkRange = NSIntersectionRange([string lineRangeForRange:range], region);
+    CFStringInlineBuffer buffer;
+    CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, string.length));
+
+    // the chunk grows until its tags are balanced, so no tag pair is split between two chunks
+    while (chunkRange.length < LSTEXTSTORAGE_MAX_UNSTYLED_CHUNK_LENGTH) {
+        LSTextStorageMarkupScan scan = LSTextStorageScanMarkup(&buffer, chunkRange);
+        NSUInteger unmatchedCloseTags = scan.unmatchedCloseTags;
+        // a tag can be cut off at the end of the chunk
+        NSUInteger unclosedOpenTags = scan.unclosedOpenTags + (scan.hasUnterminatedTag ? 1 : 0);
+
+        NSRange grownRange = chunkRange;
+
+        if (unmatchedCloseTags > 0 && chunkRange.location > region.location) {
+            NSUInteger growth = MIN(chunkRange.length, chunkRange.location - region.location);
+            grownRange = NSUnionRange(grownRange, [string lineRangeForRange:NSMakeRange(chunkRange.location - growth, 0)]);
+        }
+
+        if (unclosedOpenTags > 0 && NSMaxRange(chunkRange) < NSMaxRange(region)) {
+            NSUInteger growth = MIN(chunkRange.length, NSMaxRange(region) - NSMaxRange(chunkRange));
+            grownRange = NSUnionRange(grownRange, [string lineRangeForRange:NSMakeRange(NSMaxRange(chunkRange), growth)]);
+        }
+
+        grownRange = NSIntersectionRange(grownRange, region);
+
+        if (NSEqualRanges(grownRange, chunkRange)) {
+            break;
+        }
+
+        chunkRange = grownRange;
+    }
+
+    LSTrace(LSTraceCategoryStyle, LSTraceLevelDebug, "Styling unstyled chunk {%lu, %lu}",
+            (unsigned long)chunkRange.location, (unsigned long)chunkRange.length);
+
+    // the view is told about the chunk once its attributes are set, the flag is held until then
+    _isApplyingStyles = YES;
+    [self beginEditing];
+    NSAttributedString *styledText = [self replaceMarkupRangeWithStyledText:chunkRange];
+    [self endEditing];
+    _isApplyingStyles = NO;
+
+    if (!styledText) {
+        // the markup can't be parsed, the chunk keeps its plain text
+        [_unstyledIndexes removeIndexesInRange:chunkRange];
+        return chunkRange;
+    }
+
+    return NSMakeRange(chunkRange.location, styledText.length);
+}
+
+- (NSRange)unstyledRegionContainingIndex:(NSUInteger)index
+{
+    __block NSRange region = NSMakeRange(index, 0);
+
+    [_unstyledIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        if (NSLocationInRange(index, range)) {
+            region = range;
+            *stop = YES;
+        }
+    }];
+
+    return region;
 }
 
 - (void)applyStylesToRange:(NSRange)searchRange withAttributedText:(NSAttributedString *)attributedText
+{
+    NSAttributedString *resultString = [self styledStringFromAttributedText:attributedText
+                                                          withConfiguration:self.textView.richTextConfiguration];
+
+    [self commitStyledText:resultString ?: attributedText];
+}
+
+- (void)commitStyledText:(NSAttributedString *)styledText
+{
+    [_unstyledIndexes removeAllIndexes];
+
+    // one edit for all runs, the flag is held until the edit was processed, so the committed text
+    // isn't searched for markup again
+    _isApplyingStyles = YES;
+    [self beginEditing];
+    [self setAttributedString:styledText];
+    [self endEditing];
+    _isApplyingStyles = NO;
+}
+
+- (NSAttributedString *)styledStringFromAttributedText:(NSAttributedString *)attributedText
+                                     withConfiguration:(LSRichTextConfiguration *)configuration
 {
     LSParser *parser = [LSParser new];
-    LSNode *rootNode = [parser parseString:attributedText.string error:nil];
+    parser.tagRegistry = configuration.tagRegistry;
+
+    NSError *error;
+    LSNodeTree *nodeTree = [parser parseNodeTreeFromString:attributedText.string error:&error];
+
+    if (error) {
+        return nil;
+    }
 
-    NSMutableAttributedString *resultString = [[NSMutableAttributedString alloc] init];
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceText:attributedText];
+    LSStyleRunCollector *collector = [[LSStyleRunCollector alloc] initWithNodeTree:nodeTree andTagRegistry:configuration.tagRegistry];
+    collector.collectsStyles = (configuration.configurationFeatures & ~LSRichTextFeaturesPlainText) != 0;
 
-    [self processParsedString:rootNode resultString:&resultString fromSourceText:attributedText];
+    [collector collectRunsIntoBuilder:runBuilder];
 
-    [self setAttributedString:resultString];
+    LSTrace(LSTraceCategoryStyle, LSTraceLevelInfo, "Styling %lu characters in %lu runs",
+            (unsigned long)attributedText.length, (unsigned long)runBuilder.runCount);
+
+    return [self styledStringFromRunBuilder:runBuilder withTagContexts:collector.tagContexts andConfiguration:configuration];
 }
 
-- (void)processParsedString:(LSNode *)currentNode resultString:(NSMutableAttributedString **)outString
-             fromSourceText:(NSAttributedString *)attributedText
+- (NSAttributedString *)styledStringFromRunBuilder:(LSStyleRunBuilder *)runBuilder withTagContexts:(NSArray *)tagContexts
+                                  andConfiguration:(LSRichTextConfiguration *)configuration
 {
-    __block NSMutableAttributedString *resultString = [[NSMutableAttributedString alloc] init];
-    
-    if (currentNode.tagName) {
-        [currentNode.children enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-            [self processParsedString:(LSNode *)obj resultString:&resultString fromSourceText:attributedText];
-        }];
-    } else {
-        NSRange originRange = [attributedText.string rangeOfString:currentNode.content];
-        NSAttributedString *preservedAttributedString = [attributedText attributedSubstringFromRange:originRange];
-        
-        [resultString appendAttributedString:preservedAttributedString];
-
-        if (self.textView.richTextConfiguration.configurationFeatures & ~LSRichTextFeaturesPlainText) {
-            [currentNode.tagNames enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-                if ([self.allowedTags containsObject:obj]) {
-                    NSRange currentRange = NSMakeRange(0, resultString.length);
-                    NSDictionary *newAttributes = [self createActualAttributeStyle:currentRange
-                                                                    forTagName:obj
-                                                                      withText:resultString];
-                    [resultString addAttributes:newAttributes range:currentRange];
-                }
-            }];
+    LSTagRegistry *tagRegistry = configuration.tagRegistry;
+    // handlers only see Foundation types, the copy keeps them stable while styling in the background
+    NSDictionary *baseAttributes = [configuration.initialTextAttributes copy];
+
+    return [LSUIKitStyleAdapter attributedStringFromRunBuilder:runBuilder
+                                        withAttributesForStyle:^NSDictionary *(LSBBCodeStyle style, NSUInteger tagContext, UIFont *font) {
+        NSMutableDictionary *attributes = [LSUIKitStyleAdapter attributesForStyle:style withFont:font andConfiguration:configuration];
+
+        if (tagContext != NSNotFound) {
+            if (!attributes[NSFontAttributeName] && font) {
+                attributes[NSFontAttributeName] = font;
+            }
+
+            // handlers are called from the outermost tag inwards
+            for (NSArray *tag in tagContexts[tagContext]) {
+                LSTagHandler handler = [tagRegistry handlerForID:[tag[0] unsignedIntegerValue]];
+                handler(attributes, (tag[1] != [NSNull null]) ? tag[1] : nil, baseAttributes);
+            }
         }
+
+        return attributes;
+    }];
+}
+
+#pragma mark - snapshots
+
+- (void)setSnapshot:(LSDocumentSnapshot *)snapshot
+{
+    // cancels styling of text set asynchronously before
+    ++self.styleGeneration;
+
+    LSRichTextConfiguration *configuration = self.textView.richTextConfiguration;
+    NSAttributedString *sourceText = [[NSAttributedString alloc] initWithString:snapshot.string
+                                                                     attributes:configuration.initialTextAttributes ?: @{}];
+    LSRichTextFeatures features = configuration.configurationFeatures;
+
+    if (!(features & ~LSRichTextFeaturesNone) || !(features & ~LSRichTextFeaturesPlainText)) {
+        [self commitStyledText:sourceText];
+        return;
     }
-    
-    [*outString appendAttributedString:resultString];
+
+    // the runs of the snapshot are styled directly, the text isn't scanned or parsed
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceText:sourceText];
+    [snapshot addRunsToBuilder:runBuilder];
+
+    LSTrace(LSTraceCategoryStyle, LSTraceLevelInfo, "Styling %lu characters in %lu runs of a snapshot",
+            (unsigned long)sourceText.length, (unsigned long)runBuilder.runCount);
+
+    [self commitStyledText:[self styledStringFromRunBuilder:runBuilder withTagContexts:snapshot.tagContexts
+                                          andConfiguration:configuration]];
+}
+
+- (NSData *)snapshotData
+{
+    LSStyleRunBuilder *runBuilder = [[LSStyleRunBuilder alloc] initWithSourceString:_backingStore.string];
+
+    [_backingStore enumerateAttributesInRange:NSMakeRange(0, _backingStore.length)
+                                      options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
+                                   usingBlock:^(NSDictionary *attributes, NSRange range, BOOL *stop) {
+        [runBuilder addRunWithSourceRange:range andStyle:[self styleOfAttributes:attributes]];
+    }];
+
+    return [LSDocumentSnapshot snapshotDataWithRunBuilder:runBuilder andTagContexts:nil
+                                           andTagRegistry:self.textView.richTextConfiguration.tagRegistry];
 }
 
 #pragma mark - data detection
 
 - (void)processDataDetection
 {
-    static NSDataDetector *linkDetector;
-    linkDetector = linkDetector ?: [[NSDataDetector alloc] initWithTypes:self.textView.richTextConfiguration.textCheckingTypes
-                                                                   error:NULL];
-
-    NSRange extendedRange = [self calculateMultilineRange:NSMakeRange(0, self.length) andTextString:self.string];
-
-    // remove existing data link attributes
-    [self removeAttribute:NSLinkAttributeName range:extendedRange];
-
-    __weak LSTextStorage *weakSelf = self;
-    
-    // Find all data types in range
-    [linkDetector enumerateMatchesInString:self.string options:0 range:extendedRange usingBlock:^(NSTextCheckingResult *result, NSMatchingFlags flags, BOOL *stop) {
-        if ([result resultType] == NSTextCheckingTypeLink) {
-            [self removeAttribute:NSUnderlineStyleAttributeName range:result.range];
-            [_backingStore addAttributes:@{NSLinkAttributeName : result.URL,
-                                           NSForegroundColorAttributeName : weakSelf.textView.tintColor,
-                                           NSFontAttributeName : weakSelf.textView.font}
-                                   range:result.range];
-        }
+    [_dirtyDataIndexes addIndexesInRange:NSMakeRange(0, self.length)];
+    [self processPendingDataDetection];
+}
+
+- (BOOL)hasPendingDataDetection
+{
+    return _dirtyDataIndexes.count > 0;
+}
+
+- (void)processPendingDataDetection
+{
+    if (_isDetectingData || _dirtyDataIndexes.count == 0) {
+        return;
+    }
+
+    LSRichTextConfiguration *configuration = self.textView.richTextConfiguration;
+    NSDataDetector *dataDetector = configuration.dataDetector;
+    NSString *string = _backingStore.string;
+    NSMutableIndexSet *lineIndexes = [NSMutableIndexSet indexSet];
+
+    [_dirtyDataIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        NSUInteger location = MIN(range.location, string.length);
+        [lineIndexes addIndexesInRange:[string lineRangeForRange:NSMakeRange(location, MIN(range.length, string.length - location))]];
     }];
+    [_dirtyDataIndexes removeAllIndexes];
+
+    if (!dataDetector || lineIndexes.count == 0) {
+        return;
+    }
+
+    // only the dirty lines are copied, so the detector doesn't need the storage
+    NSMutableArray *lines = [NSMutableArray array];
+    [lineIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        [lines addObject:@[[NSValue valueWithRange:range], [string substringWithRange:range]]];
+    }];
+
+    LSTrace(LSTraceCategoryDetect, LSTraceLevelInfo, "Detecting data in %lu characters of %lu lines",
+            (unsigned long)lineIndexes.count, (unsigned long)lines.count);
+
+    if (!configuration.detectsDataInBackground) {
+        [self applyDataDetectionResults:[self detectDataInLines:lines withDataDetector:dataDetector] toRanges:lineIndexes];
+        return;
+    }
+
+    NSUInteger editCount = _characterEditCount;
+    _isDetectingData = YES;
+    [_detectingDataIndexes addIndexes:lineIndexes];
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSArray *results = [self detectDataInLines:lines withDataDetector:dataDetector];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (editCount == _characterEditCount) {
+                [self applyDataDetectionResults:results toRanges:lineIndexes];
+            } else {
+                // the text changed in the meantime, the ranges of the results aren't valid anymore
+                [_dirtyDataIndexes addIndexes:_detectingDataIndexes];
+            }
+
+            [_detectingDataIndexes removeAllIndexes];
+            _isDetectingData = NO;
+
+            [self processPendingDataDetection];
+        });
+    });
+}
+
+- (NSArray *)detectDataInLines:(NSArray *)lines withDataDetector:(NSDataDetector *)dataDetector
+{
+    NSMutableArray *results = [NSMutableArray array];
+
+    for (NSArray *line in lines) {
+        NSUInteger location = [line[0] rangeValue].location;
+        NSString *lineString = line[1];
+
+        [dataDetector enumerateMatchesInString:lineString options:0 range:NSMakeRange(0, lineString.length) usingBlock:^(NSTextCheckingResult *result, NSMatchingFlags flags, BOOL *stop) {
+            if ([result resultType] == NSTextCheckingTypeLink) {
+                [results addObject:[result resultByAdjustingRangesWithOffset:location]];
+            }
+        }];
+    }
+
+    return results;
+}
+
+- (void)applyDataDetectionResults:(NSArray *)results toRanges:(NSIndexSet *)ranges
+{
+    // all links are set in one transaction, so the text is laid out once
+    [self beginFormattingTransaction];
+
+    // remove the links of the previous detection, links set by tags are kept
+    NSMutableIndexSet *detectedLinkIndexes = [NSMutableIndexSet indexSet];
+    [ranges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        [_backingStore enumerateAttribute:LSTextStorageDetectedLinkAttributeName inRange:range options:0 usingBlock:^(id value, NSRange linkRange, BOOL *stopLinks) {
+            if (value) { [detectedLinkIndexes addIndexesInRange:linkRange]; }
+        }];
+    }];
+    [detectedLinkIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        [self removeAttribute:NSLinkAttributeName range:range];
+        [self removeAttribute:LSTextStorageDetectedLinkAttributeName range:range];
+    }];
+
+    NSDictionary *linkAttributes = @{NSForegroundColorAttributeName : self.textView.tintColor,
+                                     NSFontAttributeName : self.textView.font};
+
+    for (NSTextCheckingResult *result in results) {
+        // the links are set per run through setAttributes:range:, so they are interned like other styles
+        [_backingStore enumerateAttributesInRange:result.range options:0 usingBlock:^(NSDictionary *attrs, NSRange range, BOOL *stop) {
+            // a link set by a tag wins over the detected one
+            if (attrs[NSLinkAttributeName]) { return; }
+
+            NSMutableDictionary *attributes = [attrs mutableCopy];
+            [attributes removeObjectForKey:NSUnderlineStyleAttributeName];
+            [attributes addEntriesFromDictionary:linkAttributes];
+            attributes[NSLinkAttributeName] = result.URL;
+            attributes[LSTextStorageDetectedLinkAttributeName] = @YES;
+
+            [self setAttributes:attributes range:range];
+        }];
+    }
+
+    [self commitFormattingTransaction];
 }
 
 #pragma mark - interactive formatters
 
 - (void)applyTraitChangeToRange:(NSRange)range andTraitValue:(uint32_t)traitValue
 {
+    if (range.length > 0) {
+        LSBBCodeStyle style = ((traitValue & UIFontDescriptorTraitBold) ? LSBBCodeStyleBold : 0) |
+                              ((traitValue & UIFontDescriptorTraitItalic) ? LSBBCodeStyleItalic : 0);
+        BOOL isEnabled = [self stateOfStyle:style inRange:range] == LSStyleStateOn;
+        LSRichTextConfiguration *configuration = self.textView.richTextConfiguration;
+
+        [self changeAttributesOfRunsInRange:range usingBlock:^(NSMutableDictionary *attributes) {
+            // every run keeps its own font and other traits, only the trait is changed
+            UIFont *font = attributes[NSFontAttributeName] ?: configuration.initialTextAttributes[NSFontAttributeName];
+            UIFontDescriptor *fontDescriptor = [font fontDescriptor];
+            UIFontDescriptorSymbolicTraits changedTraits = isEnabled ? fontDescriptor.symbolicTraits & ~traitValue
+                                                                     : fontDescriptor.symbolicTraits | traitValue;
+            UIFont *changedFont = [configuration.fontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:changedTraits];
+
+            if (changedFont) {
+                attributes[NSFontAttributeName] = changedFont;
+            }
+        }];
+        return;
+    }
+
     UIFont *currentFont = [self fontAtIndex:range.location];
     UIFontDescriptor *fontDescriptor = [currentFont fontDescriptor];
 
@@ -213,98 +953,147 @@
     UIFontDescriptorSymbolicTraits fontDescriptorSymbolicTraits = fontDescriptor.symbolicTraits;
     BOOL isEnabled = (fontDescriptorSymbolicTraits & traitValue) != 0;
 
-    UIFontDescriptor *changedFontDescriptor;
+    UIFontDescriptorSymbolicTraits changedTraits = isEnabled ? fontDescriptorSymbolicTraits & ~traitValue
+                                                             : fontDescriptorSymbolicTraits | traitValue;
 
-    if (!isEnabled) {
-        UIFontDescriptorSymbolicTraits existingTraitsWithNewTrait = [fontDescriptor symbolicTraits] | traitValue;
-        changedFontDescriptor = [fontDescriptor fontDescriptorWithSymbolicTraits:existingTraitsWithNewTrait];
-    } else {
-        UIFontDescriptorSymbolicTraits existingTraitsWithoutTrait = [fontDescriptor symbolicTraits] & ~traitValue;
-        changedFontDescriptor = [fontDescriptor fontDescriptorWithSymbolicTraits:existingTraitsWithoutTrait];
-    }
+    UIFont *changedFont = [self.textView.richTextConfiguration.fontCache fontWithDescriptor:fontDescriptor
+                                                                          andSymbolicTraits:changedTraits];
+
+    if (!changedFont) return;
 
-    if (!changedFontDescriptor) return;
+    NSMutableDictionary *dictionary = [[self.textView typingAttributes] mutableCopy];
+    [dictionary setObject:changedFont forKey:NSFontAttributeName];
+    [self.textView setTypingAttributes:dictionary];
+}
 
-    NSDictionary *changedAttributes = @{NSFontAttributeName:[UIFont fontWithDescriptor:changedFontDescriptor size:0.0]};
-    
+- (void)applyUnderlineChangeToRange:(NSRange)range andStyleAttributeName:(NSString *)styleAttributeName
+{
     if (range.length > 0) {
-        [self addAttributes:changedAttributes range:range];
-    } else {
-        NSMutableDictionary *dictionary = [[self.textView typingAttributes] mutableCopy];
-        [dictionary setObject:[changedAttributes valueForKey:NSFontAttributeName] forKey:NSFontAttributeName];
-        [self.textView setTypingAttributes:dictionary];
+        LSBBCodeStyle style = [styleAttributeName isEqualToString:NSStrikethroughStyleAttributeName] ? LSBBCodeStyleStrikeThrough
+                                                                                                     : LSBBCodeStyleUnderlined;
+        NSNumber *styleValue = ([self stateOfStyle:style inRange:range] == LSStyleStateOn) ? @(NSUnderlineStyleNone)
+                                                                                           : @(NSUnderlineStyleSingle);
+
+        [self changeAttributesOfRunsInRange:range usingBlock:^(NSMutableDictionary *attributes) {
+            attributes[styleAttributeName] = styleValue;
+        }];
+        return;
     }
+
+    NSDictionary *currentAttributesDict = self.textView.typingAttributes;
+    NSNumber *styleValue = ([currentAttributesDict[styleAttributeName] intValue] == 0) ? @(NSUnderlineStyleSingle)
+                                                                                      : @(NSUnderlineStyleNone);
+
+    NSMutableDictionary *dictionary = [[self.textView typingAttributes] mutableCopy];
+    [dictionary setObject:styleValue forKey:styleAttributeName];
+    [self.textView setTypingAttributes:dictionary];
 }
 
-- (void)applyUnderlineChangeToRange:(NSRange)range andStyleAttributeName:(NSString *)styleAttributeName
+- (void)changeAttributesOfRunsInRange:(NSRange)range usingBlock:(void (^)(NSMutableDictionary *attributes))block
 {
-    NSDictionary *currentAttributesDict = (range.length > 0) ? [_backingStore attributesAtIndex:range.location effectiveRange:nil]
-                                                             :  self.textView.typingAttributes;
+    NSMutableArray *runRanges = [NSMutableArray array];
+    NSMutableArray *runAttributes = [NSMutableArray array];
 
-    NSDictionary *newAttributes;
+    // runs sharing a dictionary share the changed one, the store isn't changed while enumerating
+    NSMapTable *changedAttributes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                          valueOptions:NSPointerFunctionsStrongMemory];
 
-    if ([currentAttributesDict objectForKey:styleAttributeName] == nil ||
-        [[currentAttributesDict objectForKey:styleAttributeName] intValue] == 0) {
-        newAttributes = @{styleAttributeName: [NSNumber numberWithInt:1]};
-    }
-    else{
-        newAttributes = @{styleAttributeName: [NSNumber numberWithInt:0]};
+    [_backingStore enumerateAttributesInRange:range
+                                      options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
+                                   usingBlock:^(NSDictionary *attributes, NSRange runRange, BOOL *stop) {
+        NSDictionary *changed = [changedAttributes objectForKey:attributes];
+
+        if (!changed) {
+            NSMutableDictionary *mutableAttributes = [attributes mutableCopy];
+            block(mutableAttributes);
+            changed = mutableAttributes;
+            [changedAttributes setObject:changed forKey:attributes];
+        }
+
+        [runRanges addObject:[NSValue valueWithRange:runRange]];
+        [runAttributes addObject:changed];
+    }];
+
+    LSTrace(LSTraceCategoryStyle, LSTraceLevelInfo, "Changing %lu runs in range {%lu, %lu}",
+            (unsigned long)runRanges.count, (unsigned long)range.location, (unsigned long)range.length);
+
+    // one transaction for all runs, so the text is processed and laid out once
+    [self performFormattingTransaction:^{
+        for (NSUInteger index = 0; index < runRanges.count; index++) {
+            [self setAttributes:runAttributes[index] range:[runRanges[index] rangeValue]];
+        }
+    }];
+}
+
+- (LSBBCodeStyle)styleInRange:(NSRange)range mixedStyle:(LSBBCodeStyle *)mixedStyle
+{
+    if (_backingStore.length == 0) {
+        if (mixedStyle) {
+            *mixedStyle = LSBBCodeStyleNone;
+        }
+        return LSBBCodeStyleNone;
     }
 
-    if (range.length > 0) {
-        [self addAttributes:newAttributes range:range];
-    } else {
-        NSMutableDictionary *dictionary = [[self.textView typingAttributes] mutableCopy];
-        [dictionary setObject:[newAttributes valueForKey:styleAttributeName] forKey:styleAttributeName];
-        [self.textView setTypingAttributes:dictionary];
+    if (range.length == 0) {
+        range = NSMakeRange(MIN(range.location > 0 ? range.location - 1 : 0, _backingStore.length - 1), 1);
     }
-}
 
-#pragma mark - formatter helpers
+    range = NSIntersectionRange(range, NSMakeRange(0, _backingStore.length));
 
-- (NSDictionary *)createActualAttributeStyle:(NSRange)inRange forTagName:(NSString *)tagName withText:(NSAttributedString *)attributedText
-{
-    UIFont *currentFont = [self fontAtIndex:inRange.location withinText:attributedText];
-    NSDictionary* currentAttributes = @{};
+    __block LSBBCodeStyle commonStyle = ~(LSBBCodeStyle)0;
+    __block LSBBCodeStyle anyStyle = LSBBCodeStyleNone;
+
+    [_backingStore enumerateAttributesInRange:range
+                                      options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
+                                   usingBlock:^(NSDictionary *attributes, NSRange runRange, BOOL *stop) {
+        LSBBCodeStyle style = [self styleOfAttributes:attributes];
+        commonStyle &= style;
+        anyStyle |= style;
+    }];
+
+    if (commonStyle == ~(LSBBCodeStyle)0) {
+        commonStyle = LSBBCodeStyleNone;
+    }
 
-    if ([tagName isEqualToString:@"b"]) {
-        currentAttributes = [self createAttributesForFontStyle:currentFont
-                                                     withTrait:UIFontDescriptorTraitBold];
-    } else if ([tagName isEqualToString:@"i"]) {
-        currentAttributes = [self createAttributesForFontStyle:currentFont
-                                                     withTrait:UIFontDescriptorTraitItalic];
-    } else if ([tagName isEqualToString:@"u"]) {
-        currentAttributes = [NSDictionary dictionaryWithObject:[NSNumber numberWithInteger:NSUnderlineStyleSingle]
-                                                        forKey:NSUnderlineStyleAttributeName];
-    } else if ([tagName isEqualToString:@"s"]) {
-        currentAttributes = @{ NSStrikethroughStyleAttributeName : [NSNumber numberWithInteger:NSUnderlineStyleSingle]};
+    if (mixedStyle) {
+        *mixedStyle = anyStyle & ~commonStyle;
     }
 
-    return currentAttributes;
+    return commonStyle;
 }
 
-- (NSDictionary*)createAttributesForFontStyle:(UIFont*)currentFont
-                                    withTrait:(uint32_t)traitValue
+- (LSStyleState)stateOfStyle:(LSBBCodeStyle)style inRange:(NSRange)range
 {
-    UIFontDescriptor *fontDescriptor = [currentFont fontDescriptor];
+    LSBBCodeStyle mixedStyle;
+    LSBBCodeStyle commonStyle = [self styleInRange:range mixedStyle:&mixedStyle];
 
-    if (!fontDescriptor) {
-        fontDescriptor = [self.textView.richTextConfiguration.initialTextAttributes[NSFontAttributeName] fontDescriptor];
+    if ((commonStyle & style) == style) {
+        return LSStyleStateOn;
     }
 
-    UIFontDescriptorSymbolicTraits existingTraitsWithNewTrait = [fontDescriptor symbolicTraits] | traitValue;
+    return ((commonStyle | mixedStyle) & style) ? LSStyleStateMixed : LSStyleStateOff;
+}
+
+#pragma mark - formatter helpers
+
+- (LSBBCodeStyle)styleOfAttributes:(NSDictionary *)attributes
+{
+    if (!attributes) {
+        return LSBBCodeStyleNone;
+    }
 
-    UIFontDescriptor *descriptorWithTrait = [fontDescriptor fontDescriptorWithSymbolicTraits:existingTraitsWithNewTrait];
+    NSNumber *style = [_stylesByAttributes objectForKey:attributes];
 
-    UIFont* font =  [UIFont fontWithDescriptor:descriptorWithTrait size: 0.0];
+    if (!style) {
+        if (_stylesByAttributes.count >= LSTEXTSTORAGE_MAX_CACHED_STYLES) {
+            [_stylesByAttributes removeAllObjects];
+        }
 
-    if (!font) {
-        // in this case the default system font is found and can't set new
-        // descriptors, so we use the textview initial one.
-        font = self.textView.richTextConfiguration.initialTextAttributes[NSFontAttributeName];
+        style = @([LSUIKitStyleAdapter styleFromAttributes:attributes]);
+        [_stylesByAttributes setObject:style forKey:attributes];
     }
 
-    return @{ NSFontAttributeName : font };
+    return style.unsignedIntegerValue;
 }
 
 - (UIFont *)fontAtIndex:(NSInteger)index
@@ -322,26 +1111,6 @@
     return [dictionary objectForKey:NSFontAttributeName];
 }
 
-- (UIFont *)fontAtIndex:(NSInteger)index withinText:(NSAttributedString *)attributedText
-{
-    // If no text exists get font from typing attributes
-    NSDictionary *dictionary = ([self.textView hasText])
-    ? [attributedText attributesAtIndex:index effectiveRange:nil]
-    : self.textView.typingAttributes;
-
-    if ([dictionary count] == 0) {
-      dictionary = self.textView.richTextConfiguration.initialTextAttributes;
-    }
-
-    UIFont *font = [dictionary objectForKey:NSFontAttributeName];
-    if (!font) {
-      // failover solution if no font is defined before
-      font = [UIFont systemFontOfSize:[UIFont smallSystemFontSize]];
-    }
-
-    return font;
-}
-
 - (NSDictionary *)fontAttributesAtIndex:(NSInteger)index
 {
     // If index at end of string, get attributes starting from previous character
@@ -361,112 +1130,31 @@
     return [self createOutputStringFromStore:_backingStore];
 }
 
-- (NSString *)createOutputStringFromStore:(NSMutableAttributedString *)backingStore
+- (NSString *)createOutputStringFromStore:(NSAttributedString *)backingStore
 {
-    NSMutableString *returnString = [NSMutableString string];
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:nil andTagRegistry:[self outputTagRegistry]];
 
-    [backingStore enumerateAttributesInRange:NSMakeRange(0, [backingStore.string length])
-                            options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
-                         usingBlock:
-        ^(NSDictionary *attributes, NSRange range, BOOL *stop)
-    {
-        NSMutableDictionary *mutableAttributes = [NSMutableDictionary dictionaryWithDictionary:attributes];
-        UIFontDescriptor *fontDescriptor = [[mutableAttributes objectForKey:NSFontAttributeName] fontDescriptor];
-        UIFontDescriptorSymbolicTraits fontDescriptorSymbolicTraits = fontDescriptor.symbolicTraits;
+    [LSUIKitStyleAdapter serializeAttributedString:backingStore withSerializer:serializer];
+    [serializer finishWithError:nil];
 
-        NSString *returnFontString = [backingStore.string substringWithRange:range];
+    LSTrace(LSTraceCategorySerialize, LSTraceLevelInfo, "Serialized %lu characters into %lu characters of markup",
+            (unsigned long)backingStore.length, (unsigned long)serializer.string.length);
 
-        if (fontDescriptorSymbolicTraits & UIFontDescriptorTraitBold) {
-            returnFontString = [NSString stringWithFormat:@"[b]%@[/b]", returnFontString];
-        }
+    return serializer.string;
+}
 
-        if (fontDescriptorSymbolicTraits & UIFontDescriptorTraitItalic) {
-            returnFontString = [NSString stringWithFormat:@"[i]%@[/i]", returnFontString];
-        }
+- (BOOL)writeOutputToStream:(NSOutputStream *)outputStream error:(NSError **)error
+{
+    LSBBCodeSerializer *serializer = [[LSBBCodeSerializer alloc] initWithOutputStream:outputStream andTagRegistry:[self outputTagRegistry]];
 
-        if ([[attributes objectForKey:NSUnderlineStyleAttributeName] intValue] == 1) {
-            returnFontString = [NSString stringWithFormat:@"[u]%@[/u]", returnFontString];
-        }
-        
-        if ([[attributes objectForKey:NSStrikethroughStyleAttributeName] intValue] == 1) {
-            returnFontString = [NSString stringWithFormat:@"[s]%@[/s]", returnFontString];
-        }
+    [LSUIKitStyleAdapter serializeAttributedString:_backingStore withSerializer:serializer];
 
-        [returnString appendString:returnFontString];
-    }];
-    
-    return returnString;
+    return [serializer finishWithError:error];
 }
 
-- (NSString *)createOutputString2
+- (LSTagRegistry *)outputTagRegistry
 {
-    NSMutableString *returnString = [NSMutableString string];
-    __block NSDictionary *previousAttributes;
-    
-    [_backingStore enumerateAttributesInRange:NSMakeRange(0, [_backingStore.string length])
-                                      options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
-                                   usingBlock:
-     ^(NSDictionary *attributes, NSRange range, BOOL *stop)
-     {
-         NSMutableDictionary *mutableAttributes = [NSMutableDictionary dictionaryWithDictionary:attributes];
-         UIFontDescriptor *fontDescriptor = [[mutableAttributes objectForKey:NSFontAttributeName] fontDescriptor];
-         UIFontDescriptorSymbolicTraits fontDescriptorSymbolicTraits = fontDescriptor.symbolicTraits;
-
-         NSString *returnFontString = [_backingStore.string substringWithRange:range];
-
-         UIFontDescriptorSymbolicTraits previousFontDescriptorSymbolicTraits = UIFontDescriptorClassUnknown;
-         
-         if (previousAttributes) {
-             NSMutableDictionary *previousMutableAttributes = [NSMutableDictionary dictionaryWithDictionary:previousAttributes];
-             UIFontDescriptor *previousFontDescriptor = [[previousMutableAttributes objectForKey:NSFontAttributeName] fontDescriptor];
-             previousFontDescriptorSymbolicTraits = previousFontDescriptor.symbolicTraits;
-             
-             if (([[previousAttributes objectForKey:NSStrikethroughStyleAttributeName] intValue] == 1) &&
-                 [[attributes objectForKey:NSStrikethroughStyleAttributeName] intValue] == 0) {
-                 returnFontString = [NSString stringWithFormat:@"[/s]%@", returnFontString];
-             }
-
-             if (([[previousAttributes objectForKey:NSUnderlineStyleAttributeName] intValue] == 1) &&
-                 [[attributes objectForKey:NSUnderlineStyleAttributeName] intValue] == 0) {
-                 returnFontString = [NSString stringWithFormat:@"[/u]%@", returnFontString];
-             }
-
-             if ((previousFontDescriptorSymbolicTraits & UIFontDescriptorTraitItalic) &&
-                 !(fontDescriptorSymbolicTraits & UIFontDescriptorTraitItalic)) {
-                 returnFontString = [NSString stringWithFormat:@"[/i]%@", returnFontString];
-             }
-             
-             if ((previousFontDescriptorSymbolicTraits & UIFontDescriptorTraitBold) &&
-                 !(fontDescriptorSymbolicTraits & UIFontDescriptorTraitBold)) {
-                 returnFontString = [NSString stringWithFormat:@"[/b]%@", returnFontString];
-             }
-         }
-         
-         if ((fontDescriptorSymbolicTraits & UIFontDescriptorTraitBold) &&
-             !(previousFontDescriptorSymbolicTraits & UIFontDescriptorTraitBold)) {
-             returnFontString = [NSString stringWithFormat:@"[b]%@", returnFontString];
-         }
-         
-         if ((fontDescriptorSymbolicTraits & UIFontDescriptorTraitItalic) &&
-             !(previousFontDescriptorSymbolicTraits & UIFontDescriptorTraitItalic)) {
-             returnFontString = [NSString stringWithFormat:@"[i]%@", returnFontString];
-         }
-         
-         if (([[attributes objectForKey:NSUnderlineStyleAttributeName] intValue] == 1) &&
-             ([[previousAttributes objectForKey:NSUnderlineStyleAttributeName] intValue] == 0)) {
-             returnFontString = [NSString stringWithFormat:@"[u]%@", returnFontString];
-         }
-         
-         if (([[attributes objectForKey:NSStrikethroughStyleAttributeName] intValue] == 1) &&
-             ([[previousAttributes objectForKey:NSStrikethroughStyleAttributeName] intValue] == 0)) {
-             returnFontString = [NSString stringWithFormat:@"[s]%@", returnFontString];
-         }
-
-         previousAttributes = attributes;
-         [returnString appendString:returnFontString];
-     }];
-    
-    return returnString;
+    return self.textView.richTextConfiguration.tagRegistry ?: [[LSTagRegistry alloc] init];
 }
 
 #pragma mark - common helper methods
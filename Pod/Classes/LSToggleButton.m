@@ -74,11 +74,15 @@
 - (void)buttonTapped:(id)sender
 {
     self.isActive = !self.isActive;
-    [self updateButtonStyle];
 }
 
 - (void)setIsActive:(BOOL)isActive
 {
+    // the style animates, so it's only updated on changes
+    if (_isActive == isActive) {
+        return;
+    }
+
     _isActive = isActive;
     [self updateButtonStyle];
 }
@@ -0,0 +1,162 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+/*!
+ *  Traces are compiled in for debug builds only. Define LSTRACE_ENABLED as 1 or 0 to
+ *  override it, disabled traces don't evaluate their arguments.
+ */
+#ifndef LSTRACE_ENABLED
+#if defined(DEBUG) && DEBUG
+#define LSTRACE_ENABLED 1
+#else
+#define LSTRACE_ENABLED 0
+#endif
+#endif
+
+/*!
+ *  The number of entries kept in the ring buffer, older entries are overwritten.
+ */
+#define LSTRACE_BUFFER_SIZE 1024
+
+/*!
+ *  The maximum length of a trace message in bytes, longer messages are truncated.
+ */
+#define LSTRACE_MESSAGE_LENGTH 112
+
+/*!
+ * @typedef LSTraceLevel
+ *
+ * @brief The severity of a trace entry.
+ *
+ * @field LSTraceLevelError   a failure, e.g. markup that couldn't be parsed
+ * @field LSTraceLevelWarning an unexpected state the editor recovers from
+ * @field LSTraceLevelInfo    a finished task, e.g. a styled text
+ * @field LSTraceLevelDebug   a single edit of the text storage
+ */
+typedef NS_ENUM(NSUInteger, LSTraceLevel) {
+    LSTraceLevelError,
+    LSTraceLevelWarning,
+    LSTraceLevelInfo,
+    LSTraceLevelDebug
+};
+
+/*!
+ * @typedef LSTraceCategory
+ *
+ * @brief The editor component a trace entry is written by, categories can be combined
+ *        bitwise to filter traces.
+ *
+ * @field LSTraceCategoryParse     scanning and parsing of markup
+ * @field LSTraceCategoryStyle     styling of parsed text and interactive formatting
+ * @field LSTraceCategorySerialize creating markup from styled text
+ * @field LSTraceCategoryLayout    edits of the text storage passed on to the layout
+ * @field LSTraceCategoryDetect    data detection
+ * @field LSTraceCategoryAll       all categories
+ */
+typedef NS_OPTIONS(NSUInteger, LSTraceCategory) {
+    LSTraceCategoryParse     = 1 << 0,
+    LSTraceCategoryStyle     = 1 << 1,
+    LSTraceCategorySerialize = 1 << 2,
+    LSTraceCategoryLayout    = 1 << 3,
+    LSTraceCategoryDetect    = 1 << 4,
+    LSTraceCategoryAll       = 0x1F
+};
+
+/*!
+ *  Writes a trace entry to the ring buffer if its level and category are enabled.
+ *
+ *  @param category the category of the entry.
+ *  @param level    the level of the entry.
+ *  @param format   a printf format string, objects aren't supported.
+ */
+#if LSTRACE_ENABLED
+#define LSTrace(category, level, format, ...) \
+    do { \
+        if (LSTraceIsEnabled(category, level)) { \
+            LSTraceWrite(category, level, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+#else
+#define LSTrace(category, level, format, ...) do {} while (0)
+#endif
+
+/*!
+ *  Checks if entries of a category and level are recorded.
+ *
+ *  @param category the trace category.
+ *  @param level    the trace level.
+ *
+ *  @return YES if the entries are recorded.
+ */
+BOOL LSTraceIsEnabled(LSTraceCategory category, LSTraceLevel level);
+
+/*!
+ *  Writes a trace entry to the ring buffer, use the LSTrace macro instead.
+ *
+ *  @param category the category of the entry.
+ *  @param level    the level of the entry.
+ *  @param format   a printf format string, objects aren't supported.
+ */
+void LSTraceWrite(LSTraceCategory category, LSTraceLevel level, const char *format, ...) __printflike(3, 4);
+
+/*!
+ *  @discussion LSTrace keeps the latest trace entries of the editor in a ring buffer.
+ *              Writers reserve their slot with an atomic counter and don't block each
+ *              other, nothing is logged until the buffer is dumped.
+ */
+@interface LSTrace : NSObject
+
+/*!
+ *  Sets the most verbose level recorded, LSTraceLevelInfo by default.
+ *
+ *  @param level the trace level.
+ */
++ (void)setMaximumLevel:(LSTraceLevel)level;
+
+/*!
+ *  Sets the recorded categories, all categories by default.
+ *
+ *  @param categories the trace categories combined bitwise.
+ */
++ (void)setEnabledCategories:(LSTraceCategory)categories;
+
+/*!
+ *  Returns the entries in the ring buffer, oldest first. Entries overwritten while dumping
+ *  are left out.
+ *
+ *  @return an array of formatted trace entries.
+ */
++ (NSArray *)dumpEntries;
+
+/*!
+ *  Writes the entries in the ring buffer to the system log.
+ */
++ (void)dumpToLog;
+
+/*!
+ *  Removes all entries from the ring buffer.
+ */
++ (void)reset;
+
+@end
@@ -0,0 +1,154 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSTrace.h"
+#import <stdatomic.h>
+#import <pthread.h>
+
+#if !defined(__APPLE__)
+#import <unistd.h>
+#import <sys/syscall.h>
+#endif
+
+typedef struct {
+    // the index of the entry plus one, zero while the entry is written
+    _Atomic(uint64_t) sequence;
+    CFAbsoluteTime time;
+    uint64_t thread;
+    LSTraceCategory category;
+    LSTraceLevel level;
+    char message[LSTRACE_MESSAGE_LENGTH];
+} LSTraceEntry;
+
+static LSTraceEntry LSTraceEntries[LSTRACE_BUFFER_SIZE];
+static _Atomic(uint64_t) LSTraceNextIndex;
+static _Atomic(uint64_t) LSTraceFirstIndex;
+static _Atomic(NSUInteger) LSTraceMaximumLevel = LSTraceLevelInfo;
+static _Atomic(NSUInteger) LSTraceEnabledCategories = LSTraceCategoryAll;
+
+static const char *LSTraceLevelNames[] = {"error", "warning", "info", "debug"};
+static const char *LSTraceCategoryNames[] = {"parse", "style", "serialize", "layout", "detect"};
+
+static uint64_t LSTraceCurrentThreadID(void)
+{
+#if defined(__APPLE__)
+    uint64_t threadID = 0;
+    pthread_threadid_np(NULL, &threadID);
+    return threadID;
+#else
+    return (uint64_t)syscall(SYS_gettid);
+#endif
+}
+
+BOOL LSTraceIsEnabled(LSTraceCategory category, LSTraceLevel level)
+{
+    return (atomic_load_explicit(&LSTraceEnabledCategories, memory_order_relaxed) & category) != 0 &&
+        level <= atomic_load_explicit(&LSTraceMaximumLevel, memory_order_relaxed);
+}
+
+void LSTraceWrite(LSTraceCategory category, LSTraceLevel level, const char *format, ...)
+{
+    uint64_t index = atomic_fetch_add_explicit(&LSTraceNextIndex, 1, memory_order_relaxed);
+    LSTraceEntry *entry = &LSTraceEntries[index % LSTRACE_BUFFER_SIZE];
+
+    atomic_store_explicit(&entry->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    entry->time = CFAbsoluteTimeGetCurrent();
+    entry->thread = LSTraceCurrentThreadID();
+    entry->category = category;
+    entry->level = level;
+
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(entry->message, LSTRACE_MESSAGE_LENGTH, format, arguments);
+    va_end(arguments);
+
+    atomic_store_explicit(&entry->sequence, index + 1, memory_order_release);
+}
+
+@implementation LSTrace
+
++ (void)setMaximumLevel:(LSTraceLevel)level
+{
+    atomic_store_explicit(&LSTraceMaximumLevel, level, memory_order_relaxed);
+}
+
++ (void)setEnabledCategories:(LSTraceCategory)categories
+{
+    atomic_store_explicit(&LSTraceEnabledCategories, categories, memory_order_relaxed);
+}
+
++ (NSArray *)dumpEntries
+{
+    uint64_t endIndex = atomic_load_explicit(&LSTraceNextIndex, memory_order_acquire);
+    uint64_t startIndex = atomic_load_explicit(&LSTraceFirstIndex, memory_order_relaxed);
+
+    if (endIndex - MIN(startIndex, endIndex) > LSTRACE_BUFFER_SIZE) {
+        startIndex = endIndex - LSTRACE_BUFFER_SIZE;
+    }
+
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:(NSUInteger)(endIndex - MIN(startIndex, endIndex))];
+
+    for (uint64_t index = startIndex; index < endIndex; index++) {
+        LSTraceEntry *entry = &LSTraceEntries[index % LSTRACE_BUFFER_SIZE];
+
+        if (atomic_load_explicit(&entry->sequence, memory_order_acquire) != index + 1) {
+            continue;
+        }
+
+        LSTraceEntry copy;
+        copy.time = entry->time;
+        copy.thread = entry->thread;
+        copy.category = entry->category;
+        copy.level = entry->level;
+        memcpy(copy.message, entry->message, LSTRACE_MESSAGE_LENGTH);
+        copy.message[LSTRACE_MESSAGE_LENGTH - 1] = '\0';
+
+        // the entry was overwritten by a writer wrapping around while it was copied
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&entry->sequence, memory_order_relaxed) != index + 1) {
+            continue;
+        }
+
+        NSUInteger categoryIndex = copy.category ? __builtin_ctzl(copy.category) : 0;
+        [entries addObject:[NSString stringWithFormat:@"%.6f [%s] %s (thread %llu): %s", copy.time,
+                            LSTraceCategoryNames[MIN(categoryIndex, 4)], LSTraceLevelNames[MIN(copy.level, LSTraceLevelDebug)],
+                            (unsigned long long)copy.thread, copy.message]];
+    }
+
+    return entries;
+}
+
++ (void)dumpToLog
+{
+    for (NSString *entry in [self dumpEntries]) {
+        NSLog(@"%@", entry);
+    }
+}
+
++ (void)reset
+{
+    atomic_store_explicit(&LSTraceFirstIndex, atomic_load_explicit(&LSTraceNextIndex, memory_order_acquire), memory_order_relaxed);
+}
+
+@end
@@ -0,0 +1,89 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <UIKit/UIKit.h>
+#import "LSBBCodeSerializer.h"
+
+@class LSStyleRunBuilder;
+@class LSRichTextConfiguration;
+
+/*!
+ *  Returns the attributes of a style for a run of text set in the given font.
+ *
+ *  @param style   the style of the run.
+ *  @param context the context of the run, NSNotFound if it has none.
+ *  @param font    the font of the run in the source text, can be nil.
+ *
+ *  @return the attributes added to the run.
+ */
+typedef NSDictionary *(^LSStyleRunAttributesBlock)(LSBBCodeStyle style, NSUInteger context, UIFont *font);
+
+/*!
+ *  @discussion LSUIKitStyleAdapter maps the styles of the Foundation only core to UIKit text
+ *              attributes and back. Bold and italic are font traits, underline and strike
+ *              through are single line styles, both kept in one table of style parameters.
+ *              Styled runs share interned attribute dictionaries, one per unique style.
+ */
+@interface LSUIKitStyleAdapter : NSObject
+
+/*!
+ *  Creates the text of all runs of a builder keeping the source attributes and adds the
+ *  style attributes.
+ *
+ *  @param runBuilder the run builder.
+ *  @param block      returns the attributes of a style, called for every font of a styled run.
+ *
+ *  @return the styled text.
+ */
++ (NSAttributedString *)attributedStringFromRunBuilder:(LSStyleRunBuilder *)runBuilder
+                                withAttributesForStyle:(LSStyleRunAttributesBlock)block;
+
+/*!
+ *  Creates the attributes of a style for text set in the given font.
+ *
+ *  @param style         the style.
+ *  @param font          the font of the text, the initial font of the configuration if nil.
+ *  @param configuration the configuration providing font cache and initial font.
+ *
+ *  @return the attributes of the style.
+ */
++ (NSMutableDictionary *)attributesForStyle:(LSBBCodeStyle)style withFont:(UIFont *)font
+                           andConfiguration:(LSRichTextConfiguration *)configuration;
+
+/*!
+ *  Returns the style expressed by text attributes.
+ *
+ *  @param attributes the text attributes.
+ *
+ *  @return the style of the attributes.
+ */
++ (LSBBCodeStyle)styleFromAttributes:(NSDictionary *)attributes;
+
+/*!
+ *  Appends the runs of a styled text to a serializer. The serializer isn't finished.
+ *
+ *  @param attributedString the styled text.
+ *  @param serializer       the serializer the runs are written to.
+ */
++ (void)serializeAttributedString:(NSAttributedString *)attributedString withSerializer:(LSBBCodeSerializer *)serializer;
+
+@end
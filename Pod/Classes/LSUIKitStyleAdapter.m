@@ -0,0 +1,176 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSUIKitStyleAdapter.h"
+#import "LSStyleRunBuilder.h"
+#import "LSRichTextConfiguration.h"
+#import "LSAttributesCache.h"
+
+#define LSUIKITSTYLEADAPTER_STYLE_COUNT 4
+
+/*!
+ *  The parameters of a style bit, a style is either a font trait or a single line style.
+ */
+typedef struct {
+    LSBBCodeStyle style;
+    UIFontDescriptorSymbolicTraits fontTrait;
+    __unsafe_unretained NSString *lineStyleAttributeName;
+} LSStyleParameters;
+
+static LSStyleParameters LSStyleParameterTable[LSUIKITSTYLEADAPTER_STYLE_COUNT];
+
+@implementation LSUIKitStyleAdapter
+
++ (void)initialize
+{
+    if (self == [LSUIKitStyleAdapter class]) {
+        LSStyleParameterTable[0] = (LSStyleParameters){LSBBCodeStyleStrikeThrough, 0, NSStrikethroughStyleAttributeName};
+        LSStyleParameterTable[1] = (LSStyleParameters){LSBBCodeStyleUnderlined, 0, NSUnderlineStyleAttributeName};
+        LSStyleParameterTable[2] = (LSStyleParameters){LSBBCodeStyleItalic, UIFontDescriptorTraitItalic, nil};
+        LSStyleParameterTable[3] = (LSStyleParameters){LSBBCodeStyleBold, UIFontDescriptorTraitBold, nil};
+    }
+}
+
++ (NSAttributedString *)attributedStringFromRunBuilder:(LSStyleRunBuilder *)runBuilder
+                                withAttributesForStyle:(LSStyleRunAttributesBlock)block
+{
+    NSMutableAttributedString *resultString = [runBuilder attributedString];
+
+    // contexts are only valid for this run builder, so the cache isn't kept
+    LSAttributesCache *attributesCache = [[LSAttributesCache alloc] init];
+
+    [resultString beginEditing];
+
+    [runBuilder enumerateRunsUsingBlock:^(NSRange runRange, LSBBCodeStyle style, NSUInteger context, BOOL *stop) {
+        if (style == LSBBCodeStyleNone && context == NSNotFound) {
+            return;
+        }
+
+        // a run can span several source fonts, every font gets its own traits
+        [resultString enumerateAttributesInRange:runRange
+                                         options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
+                                      usingBlock:^(NSDictionary *sourceAttributes, NSRange range, BOOL *stopAttributes) {
+            NSDictionary *attributes = [attributesCache attributesForStyle:style
+                                                                andContext:context
+                                                        withBaseAttributes:sourceAttributes
+                                                                usingBlock:^NSDictionary *(LSBBCodeStyle style, NSUInteger context, NSDictionary *baseAttributes) {
+                NSMutableDictionary *styledAttributes = [baseAttributes mutableCopy];
+                [styledAttributes addEntriesFromDictionary:block(style, context, baseAttributes[NSFontAttributeName])];
+                return styledAttributes;
+            }];
+
+            [resultString setAttributes:attributes range:range];
+        }];
+    }];
+
+    [resultString endEditing];
+
+    return resultString;
+}
+
++ (NSMutableDictionary *)attributesForStyle:(LSBBCodeStyle)style withFont:(UIFont *)font
+                           andConfiguration:(LSRichTextConfiguration *)configuration
+{
+    NSMutableDictionary *attributes = [NSMutableDictionary dictionary];
+    UIFontDescriptorSymbolicTraits traitValue = 0;
+
+    for (NSUInteger index = 0; index < LSUIKITSTYLEADAPTER_STYLE_COUNT; index++) {
+        LSStyleParameters parameters = LSStyleParameterTable[index];
+
+        if (!(style & parameters.style)) {
+            continue;
+        }
+
+        if (parameters.lineStyleAttributeName) {
+            attributes[parameters.lineStyleAttributeName] = @(NSUnderlineStyleSingle);
+        }
+        traitValue |= parameters.fontTrait;
+    }
+
+    if (traitValue != 0) {
+        attributes[NSFontAttributeName] = [self fontWithFont:font andTrait:traitValue andConfiguration:configuration];
+    }
+
+    return attributes;
+}
+
++ (UIFont *)fontWithFont:(UIFont *)currentFont andTrait:(uint32_t)traitValue
+        andConfiguration:(LSRichTextConfiguration *)configuration
+{
+    if (!currentFont) {
+        currentFont = configuration.initialTextAttributes[NSFontAttributeName];
+    }
+
+    if (!currentFont) {
+        // failover solution if no font is defined before
+        currentFont = [UIFont systemFontOfSize:[UIFont smallSystemFontSize]];
+    }
+
+    UIFontDescriptor *fontDescriptor = [currentFont fontDescriptor];
+    UIFontDescriptorSymbolicTraits existingTraitsWithNewTrait = [fontDescriptor symbolicTraits] | traitValue;
+
+    UIFont *font = [configuration.fontCache fontWithDescriptor:fontDescriptor andSymbolicTraits:existingTraitsWithNewTrait];
+
+    // in this case the default system font is found and can't set new
+    // descriptors, so we use the textview initial one.
+    return font ?: configuration.initialTextAttributes[NSFontAttributeName] ?: currentFont;
+}
+
++ (LSBBCodeStyle)styleFromAttributes:(NSDictionary *)attributes
+{
+    LSBBCodeStyle style = LSBBCodeStyleNone;
+    UIFontDescriptorSymbolicTraits fontDescriptorSymbolicTraits = [[attributes[NSFontAttributeName] fontDescriptor] symbolicTraits];
+
+    for (NSUInteger index = 0; index < LSUIKITSTYLEADAPTER_STYLE_COUNT; index++) {
+        LSStyleParameters parameters = LSStyleParameterTable[index];
+
+        if (parameters.lineStyleAttributeName ? [attributes[parameters.lineStyleAttributeName] intValue] == NSUnderlineStyleSingle
+                                              : (fontDescriptorSymbolicTraits & parameters.fontTrait) != 0) {
+            style |= parameters.style;
+        }
+    }
+
+    return style;
+}
+
++ (void)serializeAttributedString:(NSAttributedString *)attributedString withSerializer:(LSBBCodeSerializer *)serializer
+{
+    NSString *string = attributedString.string;
+    NSMapTable *stylesByAttributes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                           valueOptions:NSPointerFunctionsStrongMemory];
+
+    [attributedString enumerateAttributesInRange:NSMakeRange(0, attributedString.length)
+                                         options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired
+                                      usingBlock:^(NSDictionary *attributes, NSRange range, BOOL *stop) {
+        // interned attributes are shared by all runs of a style, so the style is looked up once per dictionary
+        NSNumber *style = [stylesByAttributes objectForKey:attributes];
+
+        if (!style) {
+            style = @([self styleFromAttributes:attributes]);
+            [stylesByAttributes setObject:style forKey:attributes];
+        }
+
+        [serializer appendCharactersOfString:string inRange:range withStyle:style.unsignedIntegerValue];
+    }];
+}
+
+@end
@@ -0,0 +1,107 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+@class LSTagRegistry;
+
+/*!
+ *  @typedef LSBBCodeStyle
+ *
+ *  @brief The styles written as BB code tags.
+ *
+ *  @discussion Tags are opened in the order of the values, so strike through is always
+ *              the outermost and bold the innermost tag.
+ *
+ *  @field LSBBCodeStyleNone          no style, plain text
+ *  @field LSBBCodeStyleStrikeThrough written as [s] tag
+ *  @field LSBBCodeStyleUnderlined    written as [u] tag
+ *  @field LSBBCodeStyleItalic        written as [i] tag
+ *  @field LSBBCodeStyleBold          written as [b] tag
+ */
+typedef NS_OPTIONS(NSUInteger, LSBBCodeStyle) {
+    LSBBCodeStyleNone           = 0,
+    LSBBCodeStyleStrikeThrough  = 1 << 0,
+    LSBBCodeStyleUnderlined     = 1 << 1,
+    LSBBCodeStyleItalic         = 1 << 2,
+    LSBBCodeStyleBold           = 1 << 3
+};
+
+/*!
+ *  @discussion LSBBCodeSerializer writes styled text runs as BB code. It keeps a stack of
+ *              open tags and only writes the tags changing between two runs, so adjacent
+ *              runs with the same style share their tags. The output is collected in one
+ *              buffer and appended to a string or written UTF-8 encoded to an output stream.
+ */
+@interface LSBBCodeSerializer : NSObject
+
+/*!
+ *  The serialized text, if the serializer isn't writing to a stream. It's complete after
+ *  finishWithError: is called.
+ */
+@property (nonatomic, strong, readonly) NSString *string;
+
+/*!
+ *  Initializes a serializer writing into a string.
+ *
+ *  @return an instance of LSBBCodeSerializer.
+ */
+- (instancetype)init;
+
+/*!
+ *  Initializes a serializer writing to an output stream.
+ *
+ *  @param outputStream an opened output stream, the text is written UTF-8 encoded.
+ *
+ *  @return an instance of LSBBCodeSerializer.
+ */
+- (instancetype)initWithOutputStream:(NSOutputStream *)outputStream;
+
+/*!
+ *  Initializes a serializer writing the tag names registered for the styles.
+ *
+ *  @param outputStream an opened output stream or nil to write into a string.
+ *  @param tagRegistry  the registry the tag names are taken from.
+ *
+ *  @return an instance of LSBBCodeSerializer.
+ */
+- (instancetype)initWithOutputStream:(NSOutputStream *)outputStream andTagRegistry:(LSTagRegistry *)tagRegistry;
+
+/*!
+ *  Appends a run of text with the given style.
+ *
+ *  @param string the source string of the run.
+ *  @param range  the range of the run in the source string.
+ *  @param style  the style of the run.
+ */
+- (void)appendCharactersOfString:(NSString *)string inRange:(NSRange)range withStyle:(LSBBCodeStyle)style;
+
+/*!
+ *  Closes all open tags and writes the remaining buffered output.
+ *
+ *  @param error set if writing to the output stream failed.
+ *
+ *  @return NO if writing to the output stream failed.
+ */
+- (BOOL)finishWithError:(NSError **)error;
+
+@end
@@ -0,0 +1,245 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSBBCodeSerializer.h"
+#import "LSTagRegistry.h"
+
+#define LSBBCODESERIALIZER_BUFFER_SIZE 4096
+#define LSBBCODESERIALIZER_TAG_COUNT 4
+#define LSBBCODESERIALIZER_REPLACEMENT_CHARACTER 0xFFFD
+
+static inline NSUInteger LSBBCodeEncodeUTF8(UTF32Char character, uint8_t *bytes)
+{
+    if (character < 0x80) {
+        bytes[0] = character;
+        return 1;
+    } else if (character < 0x800) {
+        bytes[0] = 0xC0 | (character >> 6);
+        bytes[1] = 0x80 | (character & 0x3F);
+        return 2;
+    } else if (character < 0x10000) {
+        bytes[0] = 0xE0 | (character >> 12);
+        bytes[1] = 0x80 | ((character >> 6) & 0x3F);
+        bytes[2] = 0x80 | (character & 0x3F);
+        return 3;
+    }
+
+    bytes[0] = 0xF0 | (character >> 18);
+    bytes[1] = 0x80 | ((character >> 12) & 0x3F);
+    bytes[2] = 0x80 | ((character >> 6) & 0x3F);
+    bytes[3] = 0x80 | (character & 0x3F);
+    return 4;
+}
+
+@implementation LSBBCodeSerializer {
+    NSMutableString *_mutableString;
+    NSOutputStream *_outputStream;
+    NSError *_streamError;
+
+    unichar _buffer[LSBBCODESERIALIZER_BUFFER_SIZE];
+    NSUInteger _bufferLength;
+    unichar _pendingSurrogate;
+
+    NSString *_tagNames[LSBBCODESERIALIZER_TAG_COUNT];
+    NSUInteger _openTags[LSBBCODESERIALIZER_TAG_COUNT];
+    NSUInteger _openTagCount;
+    LSBBCodeStyle _openStyle;
+}
+
+- (instancetype)init
+{
+    return [self initWithOutputStream:nil andTagRegistry:[[LSTagRegistry alloc] init]];
+}
+
+- (instancetype)initWithOutputStream:(NSOutputStream *)outputStream
+{
+    return [self initWithOutputStream:outputStream andTagRegistry:[[LSTagRegistry alloc] init]];
+}
+
+- (instancetype)initWithOutputStream:(NSOutputStream *)outputStream andTagRegistry:(LSTagRegistry *)tagRegistry
+{
+    if (self = [super init]) {
+        _outputStream = outputStream;
+        _mutableString = outputStream ? nil : [NSMutableString string];
+
+        // the tag names are looked up once, writing a tag only copies the characters
+        for (NSUInteger tagIndex = 0; tagIndex < LSBBCODESERIALIZER_TAG_COUNT; tagIndex++) {
+            _tagNames[tagIndex] = [tagRegistry tagNameForStyle:(1 << tagIndex)];
+        }
+    }
+
+    return self;
+}
+
+- (NSString *)string
+{
+    return _mutableString;
+}
+
+#pragma mark - serializing
+
+- (void)appendCharactersOfString:(NSString *)string inRange:(NSRange)range withStyle:(LSBBCodeStyle)style
+{
+    if (range.length == 0) {
+        return;
+    }
+
+    [self changeToStyle:style];
+
+    while (range.length > 0) {
+        if (_bufferLength == LSBBCODESERIALIZER_BUFFER_SIZE) {
+            [self flush];
+        }
+
+        NSUInteger length = MIN(range.length, LSBBCODESERIALIZER_BUFFER_SIZE - _bufferLength);
+        [string getCharacters:_buffer + _bufferLength range:NSMakeRange(range.location, length)];
+
+        _bufferLength += length;
+        range.location += length;
+        range.length -= length;
+    }
+}
+
+- (BOOL)finishWithError:(NSError **)error
+{
+    [self changeToStyle:LSBBCodeStyleNone];
+    [self flush];
+
+    if (_pendingSurrogate) {
+        _buffer[_bufferLength++] = LSBBCODESERIALIZER_REPLACEMENT_CHARACTER;
+        _pendingSurrogate = 0;
+        [self flush];
+    }
+
+    if (_streamError) {
+        if (error) {
+            *error = _streamError;
+        }
+        return NO;
+    }
+
+    return YES;
+}
+
+- (void)changeToStyle:(LSBBCodeStyle)style
+{
+    if (style == _openStyle) {
+        return;
+    }
+
+    // tags opened before the first removed style can stay open
+    NSUInteger keptTagCount = 0;
+    while (keptTagCount < _openTagCount && (style & (1 << _openTags[keptTagCount]))) {
+        keptTagCount++;
+    }
+
+    while (_openTagCount > keptTagCount) {
+        NSUInteger tagIndex = _openTags[--_openTagCount];
+        _openStyle &= ~(1 << tagIndex);
+        [self appendTag:tagIndex closing:YES];
+    }
+
+    for (NSUInteger tagIndex = 0; tagIndex < LSBBCODESERIALIZER_TAG_COUNT; tagIndex++) {
+        if ((style & (1 << tagIndex)) && !(_openStyle & (1 << tagIndex))) {
+            _openTags[_openTagCount++] = tagIndex;
+            _openStyle |= (1 << tagIndex);
+            [self appendTag:tagIndex closing:NO];
+        }
+    }
+}
+
+- (void)appendTag:(NSUInteger)tagIndex closing:(BOOL)closing
+{
+    NSString *tagName = _tagNames[tagIndex];
+    NSUInteger tagNameLength = MIN(tagName.length, LSBBCODESERIALIZER_BUFFER_SIZE - 3);
+
+    if (tagNameLength == 0) {
+        return;
+    }
+
+    if (_bufferLength + tagNameLength + 3 > LSBBCODESERIALIZER_BUFFER_SIZE) {
+        [self flush];
+    }
+
+    _buffer[_bufferLength++] = '[';
+    if (closing) {
+        _buffer[_bufferLength++] = '/';
+    }
+    [tagName getCharacters:_buffer + _bufferLength range:NSMakeRange(0, tagNameLength)];
+    _bufferLength += tagNameLength;
+    _buffer[_bufferLength++] = ']';
+}
+
+#pragma mark - output
+
+- (void)flush
+{
+    if (_mutableString) {
+        CFStringAppendCharacters((__bridge CFMutableStringRef)_mutableString, _buffer, _bufferLength);
+    } else if (!_streamError) {
+        [self writeBufferToStream];
+    }
+
+    _bufferLength = 0;
+}
+
+- (void)writeBufferToStream
+{
+    uint8_t bytes[LSBBCODESERIALIZER_BUFFER_SIZE * 3 + 4];
+    NSUInteger byteCount = 0;
+
+    for (NSUInteger index = 0; index < _bufferLength; index++) {
+        UTF32Char character = _buffer[index];
+
+        // a surrogate pair can be split by the end of the buffer
+        if (_pendingSurrogate) {
+            if (CFStringIsSurrogateLowCharacter(_buffer[index])) {
+                character = CFStringGetLongCharacterForSurrogatePair(_pendingSurrogate, _buffer[index]);
+            } else {
+                byteCount += LSBBCodeEncodeUTF8(LSBBCODESERIALIZER_REPLACEMENT_CHARACTER, bytes + byteCount);
+            }
+            _pendingSurrogate = 0;
+        }
+
+        if (character <= 0xFFFF && CFStringIsSurrogateHighCharacter(character)) {
+            _pendingSurrogate = character;
+            continue;
+        } else if (character <= 0xFFFF && CFStringIsSurrogateLowCharacter(character)) {
+            character = LSBBCODESERIALIZER_REPLACEMENT_CHARACTER;
+        }
+
+        byteCount += LSBBCodeEncodeUTF8(character, bytes + byteCount);
+    }
+
+    for (NSUInteger written = 0; written < byteCount; ) {
+        NSInteger length = [_outputStream write:bytes + written maxLength:byteCount - written];
+
+        if (length <= 0) {
+            _streamError = _outputStream.streamError ?: [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil];
+            return;
+        }
+
+        written += length;
+    }
+}
+
+@end
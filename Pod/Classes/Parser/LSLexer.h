@@ -0,0 +1,86 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import "LSToken.h"
+
+/*!
+ *  The error domain used for errors reported by the lexer.
+ */
+extern NSString * const LSLexerErrorDomain;
+
+/*!
+ *  @typedef LSLexerErrorCode
+ *
+ *  @field LSLexerErrorMalformedTag  A tag is empty or not terminated by a closing bracket.
+ *  @field LSLexerErrorInvalidEncoding The markup data isn't valid UTF-8.
+ *  @field LSLexerErrorTagTooLong      A tag is exceeding the maximum tag length.
+ */
+typedef NS_ENUM(NSInteger, LSLexerErrorCode) {
+    LSLexerErrorMalformedTag = 1,
+    LSLexerErrorInvalidEncoding = 2,
+    LSLexerErrorTagTooLong = 3
+};
+
+/*!
+ *  The block called for every token found by the lexer.
+ *
+ *  @param type  the type of the found token.
+ *  @param range the range of the token value in the source string. For tags this is the
+ *               range between the brackets without the leading slash of closing tags.
+ *  @param stop  a reference to a boolean value, set it to YES to stop the lexer.
+ */
+typedef void (^LSLexerTokenBlock)(LSTokenType type, NSRange range, BOOL *stop);
+
+/*!
+ *  @discussion LSLexer splits BB code markup into tokens in a single forward pass. The
+ *              characters are fetched chunk-wise into a stack buffer, tokens are reported
+ *              as ranges into the source string, so no substrings are created while lexing.
+ *              The throughput target is 100 MB/s of UTF-16 markup on current devices.
+ */
+@interface LSLexer : NSObject
+
+/*!
+ *  The source string the lexer is working on.
+ */
+@property (nonatomic, strong, readonly) NSString *string;
+
+/*!
+ *  Initializes a lexer for the given source string.
+ *
+ *  @param string the markup string to be split into tokens.
+ *
+ *  @return an instance of LSLexer.
+ */
+- (instancetype)initWithString:(NSString *)string;
+
+/*!
+ *  Runs the lexer over the whole source string and reports every token to the block.
+ *
+ *  @param block the block called for every found token.
+ *  @param error a reference set to an error object if the markup is malformed.
+ *
+ *  @return YES if the whole string was tokenized, NO on malformed markup.
+ */
+- (BOOL)enumerateTokensUsingBlock:(LSLexerTokenBlock)block error:(NSError **)error;
+
+@end
@@ -0,0 +1,122 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSLexer.h"
+
+#define LSLEXER_BUFFER_SIZE 512
+
+NSString * const LSLexerErrorDomain = @"LSLexerErrorDomain";
+
+typedef struct {
+    __unsafe_unretained NSString *string;
+    NSUInteger length;
+    NSUInteger bufferLocation;
+    NSUInteger bufferLength;
+    unichar buffer[LSLEXER_BUFFER_SIZE];
+} LSLexerReader;
+
+static inline unichar LSLexerCharacterAtIndex(LSLexerReader *reader, NSUInteger index)
+{
+    // the lexer is only moving forward, so the buffer is refilled starting at the requested index
+    if (index < reader->bufferLocation || index >= reader->bufferLocation + reader->bufferLength) {
+        reader->bufferLocation = index;
+        reader->bufferLength = MIN(LSLEXER_BUFFER_SIZE, reader->length - index);
+        [reader->string getCharacters:reader->buffer range:NSMakeRange(index, reader->bufferLength)];
+    }
+
+    return reader->buffer[index - reader->bufferLocation];
+}
+
+@implementation LSLexer
+
+- (instancetype)initWithString:(NSString *)string
+{
+    if (self = [super init]) {
+        _string = [string copy];
+    }
+
+    return self;
+}
+
+- (BOOL)enumerateTokensUsingBlock:(LSLexerTokenBlock)block error:(NSError **)error
+{
+    LSLexerReader reader;
+    reader.string = self.string;
+    reader.length = self.string.length;
+    reader.bufferLocation = 0;
+    reader.bufferLength = 0;
+
+    NSUInteger location = 0;
+    BOOL stop = NO;
+
+    while (location < reader.length && !stop) {
+        unichar character = LSLexerCharacterAtIndex(&reader, location);
+
+        if (character == '\n') {
+            block(LSTokenTypeNewline, NSMakeRange(location, 1), &stop);
+            location++;
+            continue;
+        }
+
+        if (character != '[') {
+            // content runs until the next tag or newline char
+            NSUInteger end = location + 1;
+            while (end < reader.length) {
+                character = LSLexerCharacterAtIndex(&reader, end);
+                if (character == '[' || character == '\n') {
+                    break;
+                }
+                end++;
+            }
+
+            block(LSTokenTypeContent, NSMakeRange(location, end - location), &stop);
+            location = end;
+            continue;
+        }
+
+        BOOL isCloseTag = (location + 1 < reader.length && LSLexerCharacterAtIndex(&reader, location + 1) == '/');
+        NSUInteger valueLocation = location + (isCloseTag ? 2 : 1);
+        NSUInteger end = valueLocation;
+
+        while (end < reader.length && LSLexerCharacterAtIndex(&reader, end) != ']') {
+            end++;
+        }
+
+        if (end == valueLocation || end >= reader.length) {
+            if (error) {
+                *error = [NSError errorWithDomain:LSLexerErrorDomain
+                                             code:LSLexerErrorMalformedTag
+                                         userInfo:@{NSLocalizedDescriptionKey :
+                                                        [NSString stringWithFormat:@"Malformed tag at location %lu",
+                                                         (unsigned long)location]}];
+            }
+            return NO;
+        }
+
+        block(isCloseTag ? LSTokenTypeCloseTag : LSTokenTypeOpenTag, NSMakeRange(valueLocation, end - valueLocation), &stop);
+        location = end + 1;
+    }
+
+    return YES;
+}
+
+@end
@@ -22,19 +22,39 @@
 
 #import <Foundation/Foundation.h>
 
+@class LSNodeTree;
+
+/*!
+ *  @discussion LSNode is a lightweight view onto a node of a LSNodeTree. Properties are
+ *              resolved from the tree on access, children and tag names are created on demand.
+ *              Nodes of a completely parsed tree can be read from any thread.
+ *
+ *              Nodes created with the factory methods aren't part of a tree and keep their
+ *              properties themselves, like nodes did before parsing into trees. Setting a
+ *              property of a tree node copies its properties out of the tree first.
+ */
 @interface LSNode : NSObject
 
+@property (nonatomic, strong, readonly) LSNodeTree *tree;
+@property (nonatomic, assign, readonly) NSUInteger index;
+
 @property (nonatomic, strong) NSString *tagName;
 @property (nonatomic, strong) NSMutableArray *tagNames;
 @property (nonatomic, strong) NSString *content;
+@property (nonatomic, assign, readonly) NSRange contentRange;
+@property (nonatomic, strong, readonly) NSString *sourceString;
 @property (nonatomic, strong) NSMutableArray *children;
 @property (nonatomic, strong) NSDictionary *attributes;
 @property (nonatomic, weak) LSNode *parentNode;
 
-+ (instancetype)nodeWithTagName:(NSString *)tagName andContent:(NSString *)content andAttributes:(NSDictionary *)attributes;
++ (instancetype)nodeWithTree:(LSNodeTree *)tree andIndex:(NSUInteger)index;
 - (NSString *)debugString;
 
-- (instancetype)nodeFromParentNode:(NSString *)tagName andContent:(NSString *)content andAttributes:(NSDictionary *)attributes;
-- (void)addChildNode:(LSNode *)node;
++ (instancetype)nodeWithTagName:(NSString *)tagName andContent:(NSString *)content andAttributes:(NSDictionary *)attributes
+    DEPRECATED_MSG_ATTRIBUTE("parse into a LSNodeTree and use nodeWithTree:andIndex: instead");
+- (instancetype)nodeFromParentNode:(NSString *)tagName andContent:(NSString *)content andAttributes:(NSDictionary *)attributes
+    DEPRECATED_MSG_ATTRIBUTE("parse into a LSNodeTree and use nodeWithTree:andIndex: instead");
+- (void)addChildNode:(LSNode *)node
+    DEPRECATED_MSG_ATTRIBUTE("use -[LSNodeTree addChildNode:toParent:] instead");
 
 @end
@@ -21,8 +21,48 @@
  */
 
 #import "LSNode.h"
+#import "LSNodeTree.h"
 
-@implementation LSNode
+@implementation LSNode {
+    NSString *_tagName;
+    NSMutableArray *_tagNames;
+    NSString *_content;
+    NSMutableArray *_children;
+    NSDictionary *_attributes;
+    __weak LSNode *_parentNode;
+
+    // YES if the properties are kept by the node instead of the tree
+    BOOL _isDetached;
+}
+
++ (instancetype)nodeWithTree:(LSNodeTree *)tree andIndex:(NSUInteger)index
+{
+    return [[LSNode alloc] initWithTree:tree andIndex:index];
+}
+
+- (instancetype)initWithTree:(LSNodeTree *)tree andIndex:(NSUInteger)index
+{
+    if (self = [super init]) {
+        _tree = tree;
+        _index = index;
+    }
+
+    return self;
+}
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _index = NSNotFound;
+        _isDetached = YES;
+        _children = [NSMutableArray array];
+        _tagNames = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+#pragma mark - detached nodes
 
 + (instancetype)nodeWithTagName:(NSString *)tagName andContent:(NSString *)content andAttributes:(NSDictionary *)attributes
 {
@@ -36,23 +76,12 @@
     return node;
 }
 
-- (instancetype)init
-{
-    self = [super init];
-    if (self) {
-        self.children = [NSMutableArray array];
-        self.tagNames = [NSMutableArray array];
-    }
-    
-    return self;
-}
-
 - (instancetype)nodeFromParentNode:(NSString *)tagName andContent:(NSString *)content andAttributes:(NSDictionary *)attributes
 {
     LSNode *node = [[LSNode alloc] init];
 
     node.tagNames = [self.tagNames mutableCopy];
-    
+
     if (tagName) {
         [node.tagNames addObject:tagName];
     }
@@ -74,6 +103,171 @@
     [self.children addObject:node];
 }
 
+- (void)detachFromTree
+{
+    @synchronized (self) {
+        if (_isDetached) {
+            return;
+        }
+
+        // the tree isn't changed, the node keeps copies of its properties instead
+        _tagName = self.tagName;
+        _tagNames = self.tagNames;
+        _content = self.content;
+        _children = [self createChildren];
+        _attributes = self.attributes;
+        _isDetached = YES;
+    }
+}
+
+#pragma mark - accessors
+
+- (NSString *)tagName
+{
+    return _isDetached ? _tagName : [self.tree tagNameAtIndex:[self.tree nodeAtIndex:self.index].tagIndex];
+}
+
+- (void)setTagName:(NSString *)tagName
+{
+    [self detachFromTree];
+    _tagName = tagName;
+}
+
+- (NSMutableArray *)tagNames
+{
+    if (_isDetached) {
+        return _tagNames;
+    }
+
+    // created once, so callers changing the array keep their changes like with the children
+    @synchronized (self) {
+        if (!_tagNames) {
+            _tagNames = [[self.tree tagNamesOfTagPath:[self.tree nodeAtIndex:self.index].tagPath] mutableCopy];
+        }
+
+        return _tagNames;
+    }
+}
+
+- (void)setTagNames:(NSMutableArray *)tagNames
+{
+    [self detachFromTree];
+    _tagNames = tagNames;
+}
+
+- (NSRange)contentRange
+{
+    return self.tree ? [self.tree nodeAtIndex:self.index].contentRange : NSMakeRange(NSNotFound, 0);
+}
+
+- (NSString *)sourceString
+{
+    return self.tree.sourceString;
+}
+
+- (NSString *)content
+{
+    if (_isDetached) {
+        return _content;
+    }
+
+    // content of parsed nodes is only created on demand from the source string
+    NSRange contentRange = self.contentRange;
+
+    @synchronized (self) {
+        if (!_content && contentRange.location != NSNotFound) {
+            _content = [self.sourceString substringWithRange:contentRange];
+        }
+
+        return _content;
+    }
+}
+
+- (void)setContent:(NSString *)content
+{
+    [self detachFromTree];
+    _content = content;
+}
+
+- (NSMutableArray *)children
+{
+    if (_isDetached) {
+        return _children;
+    }
+
+    @synchronized (self) {
+        return [self createChildren];
+    }
+}
+
+- (void)setChildren:(NSMutableArray *)children
+{
+    [self detachFromTree];
+    _children = children;
+}
+
+- (NSMutableArray *)createChildren
+{
+    if (!_children) {
+        NSMutableArray *children = [NSMutableArray array];
+        NSUInteger childIndex = [self.tree nodeAtIndex:self.index].firstChild;
+
+        while (childIndex != NSNotFound) {
+            [children addObject:[self.tree nodeObjectAtIndex:childIndex]];
+            childIndex = [self.tree nodeAtIndex:childIndex].nextSibling;
+        }
+
+        _children = children;
+    }
+
+    return _children;
+}
+
+- (NSDictionary *)attributes
+{
+    return _isDetached ? _attributes : [self.tree attributesOfNodeAtIndex:self.index];
+}
+
+- (void)setAttributes:(NSDictionary *)attributes
+{
+    [self detachFromTree];
+    _attributes = attributes;
+}
+
+- (LSNode *)parentNode
+{
+    // a parent set by addChildNode: isn't part of the tree
+    LSNode *parentNode = _parentNode;
+
+    if (parentNode || !self.tree) {
+        return parentNode;
+    }
+
+    return [self.tree nodeObjectAtIndex:[self.tree nodeAtIndex:self.index].parent];
+}
+
+- (void)setParentNode:(LSNode *)parentNode
+{
+    _parentNode = parentNode;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (![object isKindOfClass:[LSNode class]]) {
+        return NO;
+    }
+
+    LSNode *node = (LSNode *)object;
+
+    // detached nodes are only equal to themselves
+    return node == self || (!node->_isDetached && !_isDetached && node.tree == self.tree && node.index == self.index);
+}
+
+- (NSUInteger)hash
+{
+    return _isDetached ? [super hash] : self.tree.hash ^ self.index;
+}
+
 #pragma mark - debug methods
 
 - (NSString *)debugString
@@ -0,0 +1,255 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+@class LSNode;
+@class LSTagRegistry;
+
+/*!
+ *  @typedef LSNodeRecord
+ *
+ *  @brief A node of the parsed tree, linked to other nodes by index.
+ *
+ *  @field parent          the index of the parent node, NSNotFound for detached nodes and the root.
+ *  @field firstChild      the index of the first child node, NSNotFound if there are no children.
+ *  @field lastChild       the index of the last child node, NSNotFound if there are no children.
+ *  @field nextSibling     the index of the next sibling node, NSNotFound for the last child.
+ *  @field tagIndex        the interned tag name, NSNotFound for content nodes.
+ *  @field tagPath         the interned path of tag names active for this node.
+ *  @field attributesIndex the index of the tag attributes, NSNotFound if there are none.
+ *  @field contentRange    the range of the content in the source string for content nodes.
+ */
+typedef struct {
+    NSUInteger parent;
+    NSUInteger firstChild;
+    NSUInteger lastChild;
+    NSUInteger nextSibling;
+    NSUInteger tagIndex;
+    NSUInteger tagPath;
+    NSUInteger attributesIndex;
+    NSRange contentRange;
+} LSNodeRecord;
+
+/*!
+ *  @discussion LSNodeTree keeps all nodes of a parsed document in one contiguous buffer.
+ *              Nodes are linked by indices, tag names and the paths of active tag names
+ *              are interned, so nodes sharing the same tag context share one tag path.
+ *              LSNode objects are created on demand as views onto the tree.
+ *
+ *              A tree can be reset and built again for another source string, keeping its
+ *              buffers and interned tag paths, so parsing many documents with one tree
+ *              doesn't allocate per document.
+ *
+ *              A tree is built by a single thread. Once the parser returned it, it isn't
+ *              changed anymore and can be handed over to other threads.
+ */
+@interface LSNodeTree : NSObject
+
+/*!
+ *  The source string the content ranges are pointing to.
+ */
+@property (nonatomic, strong, readonly) NSString *sourceString;
+
+/*!
+ *  The number of nodes in the tree, including the root node.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/*!
+ *  The number of tags interned from the tag registry, tag indexes below are tag IDs.
+ */
+@property (nonatomic, assign, readonly) NSUInteger registeredTagCount;
+
+/*!
+ *  The index of the root node.
+ */
+@property (nonatomic, assign, readonly) NSUInteger rootIndex;
+
+/*!
+ *  Initializes a tree containing a root node only.
+ *
+ *  @param sourceString the source string the content ranges are pointing to.
+ *  @param rootTagName  the tag name of the root node.
+ *
+ *  @return an instance of LSNodeTree.
+ */
+- (instancetype)initWithSourceString:(NSString *)sourceString andRootTagName:(NSString *)rootTagName;
+
+/*!
+ *  Initializes a tree containing a root node only. The tags of the registry are interned
+ *  first, so the tag index of a registered tag is its tag ID.
+ *
+ *  @param sourceString the source string the content ranges are pointing to.
+ *  @param rootTagName  the tag name of the root node.
+ *  @param tagRegistry  the registry of known tags, can be nil.
+ *
+ *  @return an instance of LSNodeTree.
+ */
+- (instancetype)initWithSourceString:(NSString *)sourceString andRootTagName:(NSString *)rootTagName
+                      andTagRegistry:(LSTagRegistry *)tagRegistry;
+
+/*!
+ *  Removes all nodes except a new root node, keeping the allocated storage. Interned tag
+ *  names and tag paths are kept unless too many of them piled up.
+ *
+ *  @param sourceString the new source string the content ranges are pointing to.
+ */
+- (void)resetWithSourceString:(NSString *)sourceString;
+
+/*!
+ *  Appends a content node to a parent node. The content node is sharing the tag path
+ *  of its parent.
+ *
+ *  @param contentRange the range of the content in the source string.
+ *  @param parentIndex  the index of the parent node.
+ *
+ *  @return the index of the new node.
+ */
+- (NSUInteger)addContentNodeWithRange:(NSRange)contentRange toParent:(NSUInteger)parentIndex;
+
+/*!
+ *  Creates a detached tag node.
+ *
+ *  @param tagIndex   the interned tag name.
+ *  @param tagPath    the interned tag path of the node.
+ *  @param attributes the tag attributes, can be nil.
+ *
+ *  @return the index of the new node.
+ */
+- (NSUInteger)addTagNodeWithTagIndex:(NSUInteger)tagIndex andTagPath:(NSUInteger)tagPath andAttributes:(NSDictionary *)attributes;
+
+/*!
+ *  Appends a node as last child to a parent node.
+ *
+ *  @param nodeIndex   the index of the node to be added.
+ *  @param parentIndex the index of the parent node.
+ */
+- (void)addChildNode:(NSUInteger)nodeIndex toParent:(NSUInteger)parentIndex;
+
+/*!
+ *  Returns the node at the given index.
+ *
+ *  @param index the node index.
+ *
+ *  @return a copy of the node record.
+ */
+- (LSNodeRecord)nodeAtIndex:(NSUInteger)index;
+
+/*!
+ *  Direct access to the contiguous node buffer.
+ *
+ *  @return a pointer to the root node, valid until the next node is added.
+ */
+- (const LSNodeRecord *)nodes;
+
+/*!
+ *  Returns the attributes of a tag node.
+ *
+ *  @param index the node index.
+ *
+ *  @return the tag attributes or nil.
+ */
+- (NSDictionary *)attributesOfNodeAtIndex:(NSUInteger)index;
+
+/*!
+ *  Interns a tag name.
+ *
+ *  @param tagName the tag name.
+ *
+ *  @return the tag index of the name.
+ */
+- (NSUInteger)internTagName:(NSString *)tagName;
+
+/*!
+ *  Returns the tag name of an interned tag.
+ *
+ *  @param tagIndex the tag index.
+ *
+ *  @return the tag name or nil for NSNotFound.
+ */
+- (NSString *)tagNameAtIndex:(NSUInteger)tagIndex;
+
+/*!
+ *  Returns the interned tag path extending a tag path by one tag.
+ *
+ *  @param tagIndex the tag index to be appended.
+ *  @param tagPath  the tag path to be extended, NSNotFound for the empty path.
+ *
+ *  @return the interned tag path.
+ */
+- (NSUInteger)tagPathByAppendingTag:(NSUInteger)tagIndex toTagPath:(NSUInteger)tagPath;
+
+/*!
+ *  Returns the interned tag path with all occurrences of a tag removed.
+ *
+ *  @param tagIndex the tag index to be removed.
+ *  @param tagPath  the source tag path.
+ *
+ *  @return the interned tag path.
+ */
+- (NSUInteger)tagPathByRemovingTag:(NSUInteger)tagIndex fromTagPath:(NSUInteger)tagPath;
+
+/*!
+ *  Checks if a tag is part of a tag path.
+ *
+ *  @param tagPath  the tag path.
+ *  @param tagIndex the tag index.
+ *
+ *  @return YES if the tag is part of the tag path.
+ */
+- (BOOL)tagPath:(NSUInteger)tagPath containsTag:(NSUInteger)tagIndex;
+
+/*!
+ *  Enumerates the tags of a tag path from the innermost tag outwards.
+ *
+ *  @param tagPath the tag path.
+ *  @param block   the block called for every tag index.
+ */
+- (void)enumerateTagsOfTagPath:(NSUInteger)tagPath usingBlock:(void (^)(NSUInteger tagIndex, BOOL *stop))block;
+
+/*!
+ *  Returns the tag names of a tag path from the outermost tag inwards.
+ *
+ *  @param tagPath the tag path.
+ *
+ *  @return an array of tag names.
+ */
+- (NSArray *)tagNamesOfTagPath:(NSUInteger)tagPath;
+
+/*!
+ *  Returns a LSNode view onto a node of the tree.
+ *
+ *  @param index the node index.
+ *
+ *  @return an instance of LSNode.
+ */
+- (LSNode *)nodeObjectAtIndex:(NSUInteger)index;
+
+/*!
+ *  Returns a LSNode view onto the root node.
+ *
+ *  @return an instance of LSNode.
+ */
+- (LSNode *)rootNode;
+
+@end
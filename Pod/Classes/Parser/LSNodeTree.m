@@ -0,0 +1,338 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSNodeTree.h"
+#import "LSNode.h"
+#import "LSTagRegistry.h"
+
+#define LSNODETREE_INITIAL_CAPACITY 64
+#define LSNODETREE_MAX_RETAINED_TAG_PATHS 4096
+
+typedef struct {
+    NSUInteger parent;
+    NSUInteger tagIndex;
+} LSTagPathRecord;
+
+static inline NSUInteger LSTagPathHash(NSUInteger parent, NSUInteger tagIndex)
+{
+    return (parent + 1) * 31 + tagIndex * 2654435761u;
+}
+
+@implementation LSNodeTree {
+    LSNodeRecord *_nodes;
+    NSUInteger _capacity;
+
+    LSTagPathRecord *_tagPaths;
+    NSUInteger _tagPathCount;
+    NSUInteger _tagPathCapacity;
+
+    // open addressing table of tag path indices + 1, zero marks an empty slot
+    NSUInteger *_tagPathSlots;
+    NSUInteger _tagPathSlotCount;
+
+    NSMutableArray *_tagNames;
+    NSMutableDictionary *_tagIndexes;
+    NSMutableArray *_attributes;
+
+    NSUInteger _rootTagIndex;
+}
+
+- (instancetype)initWithSourceString:(NSString *)sourceString andRootTagName:(NSString *)rootTagName
+{
+    return [self initWithSourceString:sourceString andRootTagName:rootTagName andTagRegistry:nil];
+}
+
+- (instancetype)initWithSourceString:(NSString *)sourceString andRootTagName:(NSString *)rootTagName
+                      andTagRegistry:(LSTagRegistry *)tagRegistry
+{
+    if (self = [super init]) {
+        _sourceString = sourceString;
+        _tagNames = [NSMutableArray array];
+        _tagIndexes = [NSMutableDictionary dictionary];
+        _attributes = [NSMutableArray array];
+
+        for (NSUInteger tagID = 0; tagID < tagRegistry.count; tagID++) {
+            [self internTagName:[tagRegistry tagNameForID:tagID]];
+        }
+        _registeredTagCount = _tagNames.count;
+
+        _rootTagIndex = [self internTagName:rootTagName];
+        [self addRootNode];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_nodes);
+    free(_tagPaths);
+    free(_tagPathSlots);
+}
+
+- (void)resetWithSourceString:(NSString *)sourceString
+{
+    _sourceString = sourceString;
+    _count = 0;
+    [_attributes removeAllObjects];
+
+    if (_tagPathCount > LSNODETREE_MAX_RETAINED_TAG_PATHS) {
+        // unknown tags of former documents are dropped, registered tags and the root tag keep their index
+        for (NSUInteger tagIndex = _rootTagIndex + 1; tagIndex < _tagNames.count; tagIndex++) {
+            [_tagIndexes removeObjectForKey:_tagNames[tagIndex]];
+        }
+        [_tagNames removeObjectsInRange:NSMakeRange(_rootTagIndex + 1, _tagNames.count - _rootTagIndex - 1)];
+
+        _tagPathCount = 0;
+        memset(_tagPathSlots, 0, _tagPathSlotCount * sizeof(NSUInteger));
+    }
+
+    [self addRootNode];
+}
+
+- (void)addRootNode
+{
+    _rootIndex = [self addTagNodeWithTagIndex:_rootTagIndex
+                                   andTagPath:[self tagPathByAppendingTag:_rootTagIndex toTagPath:NSNotFound]
+                                andAttributes:nil];
+}
+
+#pragma mark - nodes
+
+- (NSUInteger)appendNode:(LSNodeRecord)node
+{
+    if (_count == _capacity) {
+        NSUInteger capacity = _capacity ? _capacity * 2 : LSNODETREE_INITIAL_CAPACITY;
+        LSNodeRecord *nodes = realloc(_nodes, capacity * sizeof(LSNodeRecord));
+
+        if (!nodes) {
+            [NSException raise:NSMallocException format:@"Can't grow the node tree to %lu nodes", (unsigned long)capacity];
+        }
+
+        _nodes = nodes;
+        _capacity = capacity;
+    }
+
+    _nodes[_count] = node;
+
+    return _count++;
+}
+
+- (NSUInteger)addContentNodeWithRange:(NSRange)contentRange toParent:(NSUInteger)parentIndex
+{
+    LSNodeRecord node = {NSNotFound, NSNotFound, NSNotFound, NSNotFound,
+                         NSNotFound, _nodes[parentIndex].tagPath, NSNotFound, contentRange};
+
+    NSUInteger nodeIndex = [self appendNode:node];
+    [self addChildNode:nodeIndex toParent:parentIndex];
+
+    return nodeIndex;
+}
+
+- (NSUInteger)addTagNodeWithTagIndex:(NSUInteger)tagIndex andTagPath:(NSUInteger)tagPath andAttributes:(NSDictionary *)attributes
+{
+    NSUInteger attributesIndex = NSNotFound;
+
+    if (attributes) {
+        attributesIndex = _attributes.count;
+        [_attributes addObject:attributes];
+    }
+
+    LSNodeRecord node = {NSNotFound, NSNotFound, NSNotFound, NSNotFound,
+                         tagIndex, tagPath, attributesIndex, NSMakeRange(NSNotFound, 0)};
+
+    return [self appendNode:node];
+}
+
+- (void)addChildNode:(NSUInteger)nodeIndex toParent:(NSUInteger)parentIndex
+{
+    if (nodeIndex == NSNotFound || parentIndex == NSNotFound) {
+        return;
+    }
+
+    LSNodeRecord *parent = &_nodes[parentIndex];
+
+    if (parent->lastChild == NSNotFound) {
+        parent->firstChild = nodeIndex;
+    } else {
+        _nodes[parent->lastChild].nextSibling = nodeIndex;
+    }
+
+    parent->lastChild = nodeIndex;
+    _nodes[nodeIndex].parent = parentIndex;
+}
+
+- (LSNodeRecord)nodeAtIndex:(NSUInteger)index
+{
+    return _nodes[index];
+}
+
+- (const LSNodeRecord *)nodes
+{
+    return _nodes;
+}
+
+- (NSDictionary *)attributesOfNodeAtIndex:(NSUInteger)index
+{
+    NSUInteger attributesIndex = _nodes[index].attributesIndex;
+
+    return (attributesIndex != NSNotFound) ? _attributes[attributesIndex] : nil;
+}
+
+#pragma mark - tag names
+
+- (NSUInteger)internTagName:(NSString *)tagName
+{
+    NSNumber *tagIndex = _tagIndexes[tagName];
+
+    if (!tagIndex) {
+        tagIndex = @(_tagNames.count);
+        [_tagNames addObject:tagName];
+        _tagIndexes[tagName] = tagIndex;
+    }
+
+    return tagIndex.unsignedIntegerValue;
+}
+
+- (NSString *)tagNameAtIndex:(NSUInteger)tagIndex
+{
+    return (tagIndex != NSNotFound) ? _tagNames[tagIndex] : nil;
+}
+
+#pragma mark - tag paths
+
+- (NSUInteger)tagPathByAppendingTag:(NSUInteger)tagIndex toTagPath:(NSUInteger)tagPath
+{
+    if (_tagPathCount * 2 >= _tagPathSlotCount) {
+        [self growTagPathSlots];
+    }
+
+    NSUInteger mask = _tagPathSlotCount - 1;
+    NSUInteger slot = LSTagPathHash(tagPath, tagIndex) & mask;
+
+    while (_tagPathSlots[slot] != 0) {
+        LSTagPathRecord record = _tagPaths[_tagPathSlots[slot] - 1];
+        if (record.parent == tagPath && record.tagIndex == tagIndex) {
+            return _tagPathSlots[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (_tagPathCount == _tagPathCapacity) {
+        NSUInteger tagPathCapacity = _tagPathCapacity ? _tagPathCapacity * 2 : LSNODETREE_INITIAL_CAPACITY;
+        LSTagPathRecord *tagPaths = realloc(_tagPaths, tagPathCapacity * sizeof(LSTagPathRecord));
+
+        if (!tagPaths) {
+            [NSException raise:NSMallocException format:@"Can't grow the tag paths to %lu paths", (unsigned long)tagPathCapacity];
+        }
+
+        _tagPaths = tagPaths;
+        _tagPathCapacity = tagPathCapacity;
+    }
+
+    _tagPaths[_tagPathCount].parent = tagPath;
+    _tagPaths[_tagPathCount].tagIndex = tagIndex;
+    _tagPathSlots[slot] = ++_tagPathCount;
+
+    return _tagPathCount - 1;
+}
+
+- (void)growTagPathSlots
+{
+    NSUInteger tagPathSlotCount = _tagPathSlotCount ? _tagPathSlotCount * 2 : LSNODETREE_INITIAL_CAPACITY;
+    NSUInteger *tagPathSlots = calloc(tagPathSlotCount, sizeof(NSUInteger));
+
+    if (!tagPathSlots) {
+        [NSException raise:NSMallocException format:@"Can't grow the tag paths to %lu slots", (unsigned long)tagPathSlotCount];
+    }
+
+    free(_tagPathSlots);
+    _tagPathSlots = tagPathSlots;
+    _tagPathSlotCount = tagPathSlotCount;
+
+    NSUInteger mask = _tagPathSlotCount - 1;
+
+    for (NSUInteger tagPath = 0; tagPath < _tagPathCount; tagPath++) {
+        NSUInteger slot = LSTagPathHash(_tagPaths[tagPath].parent, _tagPaths[tagPath].tagIndex) & mask;
+        while (_tagPathSlots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _tagPathSlots[slot] = tagPath + 1;
+    }
+}
+
+- (NSUInteger)tagPathByRemovingTag:(NSUInteger)tagIndex fromTagPath:(NSUInteger)tagPath
+{
+    if (tagPath == NSNotFound) {
+        return NSNotFound;
+    }
+
+    LSTagPathRecord record = _tagPaths[tagPath];
+    NSUInteger parentPath = [self tagPathByRemovingTag:tagIndex fromTagPath:record.parent];
+
+    return (record.tagIndex == tagIndex) ? parentPath : [self tagPathByAppendingTag:record.tagIndex toTagPath:parentPath];
+}
+
+- (BOOL)tagPath:(NSUInteger)tagPath containsTag:(NSUInteger)tagIndex
+{
+    for (; tagPath != NSNotFound; tagPath = _tagPaths[tagPath].parent) {
+        if (_tagPaths[tagPath].tagIndex == tagIndex) {
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+- (void)enumerateTagsOfTagPath:(NSUInteger)tagPath usingBlock:(void (^)(NSUInteger tagIndex, BOOL *stop))block
+{
+    BOOL stop = NO;
+
+    for (; tagPath != NSNotFound && !stop; tagPath = _tagPaths[tagPath].parent) {
+        block(_tagPaths[tagPath].tagIndex, &stop);
+    }
+}
+
+- (NSArray *)tagNamesOfTagPath:(NSUInteger)tagPath
+{
+    NSMutableArray *tagNames = [NSMutableArray array];
+
+    for (; tagPath != NSNotFound; tagPath = _tagPaths[tagPath].parent) {
+        [tagNames insertObject:_tagNames[_tagPaths[tagPath].tagIndex] atIndex:0];
+    }
+
+    return tagNames;
+}
+
+#pragma mark - node views
+
+- (LSNode *)nodeObjectAtIndex:(NSUInteger)index
+{
+    return (index != NSNotFound) ? [LSNode nodeWithTree:self andIndex:index] : nil;
+}
+
+- (LSNode *)rootNode
+{
+    return [self nodeObjectAtIndex:self.rootIndex];
+}
+
+@end
@@ -22,12 +22,58 @@
 
 #import <Foundation/Foundation.h>
 #import "LSNode.h"
+#import "LSTokenBuffer.h"
+#import "LSNodeTree.h"
+#import "LSTagRegistry.h"
 
+/*!
+ *  @discussion LSParser turns BB code markup into a LSNodeTree. A parser doesn't keep any
+ *              state between parses and there's no shared state between parsers, so parsing
+ *              can run on background threads, using one parser per thread.
+ *
+ *              Mismatched markup is recovered: close tags without open tag are ignored, a
+ *              close tag of an outer tag closes the inner tags and opens them again after
+ *              it. At most maximumTagDepth tags are open, so a token creates at most
+ *              maximumTagDepth nodes and parsing n tokens takes O(n * maximumTagDepth)
+ *              time in the worst case.
+ */
 @interface LSParser : NSObject
 
+/*!
+ *  The registry of known tags, parsed trees use its tag IDs as tag indexes. Can be nil.
+ */
+@property (nonatomic, strong) LSTagRegistry *tagRegistry;
+
+/*!
+ *  The maximum number of nested open tags, default is 64. Tags opened deeper are dropped
+ *  together with their close tags, the content is kept.
+ */
+@property (nonatomic, assign) NSUInteger maximumTagDepth;
+
 + (NSString *)debugScannedString:(NSMutableArray *)tokens;
 + (NSString *)debugParsedString:(LSNode *)rootNode;
 
 - (LSNode *)parseString:(NSString *)string error:(NSError **)error;
 
+- (LSTokenBuffer *)scanTokens:(NSString *)string error:(NSError **)error;
+- (LSToken *)scanOpenTagValue:(NSString *)tagValue;
+- (LSNode *)parseTokenBuffer:(LSTokenBuffer *)tokenBuffer;
+
+- (LSNodeTree *)parseNodeTreeFromString:(NSString *)string error:(NSError **)error;
+- (LSNodeTree *)parseNodeTreeFromTokenBuffer:(LSTokenBuffer *)tokenBuffer;
+
+/*!
+ *  Parses a string into a token buffer and a node tree reused from a former parse, both
+ *  are reset first. Parsing many strings this way doesn't allocate buffers per string.
+ *
+ *  @param string      the markup string.
+ *  @param tokenBuffer the token buffer to be reused.
+ *  @param nodeTree    the node tree to be reused, created with the tag registry of the parser.
+ *  @param error       set if the string couldn't be scanned.
+ *
+ *  @return the node tree or nil if the string couldn't be scanned.
+ */
+- (LSNodeTree *)parseNodeTreeFromString:(NSString *)string withTokenBuffer:(LSTokenBuffer *)tokenBuffer
+                            andNodeTree:(LSNodeTree *)nodeTree error:(NSError **)error;
+
 @end
@@ -23,187 +23,474 @@
 #import "LSParser.h"
 #import "LSToken.h"
 #import "LSNode.h"
+#import "LSLexer.h"
+#import "LSTokenBuffer.h"
+#import "LSNodeTree.h"
+#import "LSTrace.h"
+
+#define LSPARSER_DEFAULT_MAX_TAG_DEPTH 64
 
 @interface LSParser ()
 
-@property (nonatomic, strong) NSScanner *scanner;
 @property (nonatomic, strong) NSArray *scannedTokens;
 @property (nonatomic, strong) LSNode *parsedRootNode;
 
 @end
 
+static inline unichar LSParserCharacterAtIndex(CFStringInlineBuffer *buffer, NSUInteger index)
+{
+    return CFStringGetCharacterFromInlineBuffer(buffer, (CFIndex)index);
+}
+
+static inline BOOL LSParserIsLineBreak(unichar character)
+{
+    return (character >= 0x0A && character <= 0x0D) || character == 0x85 || character == 0x2028 || character == 0x2029;
+}
+
+static inline BOOL LSParserIsWhitespace(unichar character)
+{
+    return character == ' ' || character == '\t' || LSParserIsLineBreak(character) ||
+        character == 0xA0 || character == 0x1680 || (character >= 0x2000 && character <= 0x200A) ||
+        character == 0x202F || character == 0x205F || character == 0x3000;
+}
+
+// checks if the whitespace at the location is followed by a word containing an equals sign
+static BOOL LSParserIsFollowedByKey(CFStringInlineBuffer *buffer, NSUInteger location, NSUInteger end)
+{
+    while (location < end && LSParserIsWhitespace(LSParserCharacterAtIndex(buffer, location))) {
+        location++;
+    }
+
+    for (NSUInteger index = location; index < end; index++) {
+        unichar character = LSParserCharacterAtIndex(buffer, index);
+
+        if (LSParserIsWhitespace(character)) {
+            return NO;
+        }
+
+        if (character == '=' && index > location) {
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+// an unquoted value ends at quotes, at line breaks or at whitespace followed by the next key
+static NSUInteger LSParserUnquotedValueEnd(CFStringInlineBuffer *buffer, NSUInteger location, NSUInteger end)
+{
+    for (location++; location < end; location++) {
+        unichar character = LSParserCharacterAtIndex(buffer, location);
+
+        if (character == '"' || character == '\'' || character == '>' || LSParserIsLineBreak(character)) {
+            break;
+        }
+
+        if (LSParserIsWhitespace(character) && LSParserIsFollowedByKey(buffer, location, end)) {
+            break;
+        }
+    }
+
+    return location;
+}
+
+/*!
+ *  The open tags while parsing. The depth is bounded, so closing a tag with recovery
+ *  costs at most capacity steps.
+ */
+typedef struct {
+    NSUInteger *nodes;
+    NSUInteger count;
+    NSUInteger capacity;
+
+    // open and dropped tags per tag index, so unmatched close tags are found in constant time
+    NSUInteger *openCounts;
+    NSUInteger *droppedCounts;
+    NSUInteger tagCapacity;
+
+    // the tag indexes with dropped tags, their counts are reset once a tag is closed
+    NSUInteger *droppedTags;
+    NSUInteger droppedTagCount;
+} LSParserTagStack;
+
+static LSParserTagStack LSParserTagStackCreate(NSUInteger capacity)
+{
+    NSUInteger *nodes = malloc(capacity * sizeof(NSUInteger));
+
+    if (!nodes) {
+        [NSException raise:NSMallocException format:@"Can't create a tag stack of %lu tags", (unsigned long)capacity];
+    }
+
+    LSParserTagStack stack = {nodes, 0, capacity, NULL, NULL, 0, NULL, 0};
+
+    return stack;
+}
+
+static void LSParserTagStackReserveTag(LSParserTagStack *stack, NSUInteger tagIndex)
+{
+    if (tagIndex < stack->tagCapacity) {
+        return;
+    }
+
+    NSUInteger tagCapacity = MAX(tagIndex + 1, stack->tagCapacity * 2);
+    NSUInteger *openCounts = realloc(stack->openCounts, tagCapacity * sizeof(NSUInteger));
+    if (openCounts) {
+        stack->openCounts = openCounts;
+    }
+    NSUInteger *droppedCounts = openCounts ? realloc(stack->droppedCounts, tagCapacity * sizeof(NSUInteger)) : NULL;
+    if (droppedCounts) {
+        stack->droppedCounts = droppedCounts;
+    }
+    NSUInteger *droppedTags = droppedCounts ? realloc(stack->droppedTags, tagCapacity * sizeof(NSUInteger)) : NULL;
+
+    if (!droppedTags) {
+        [NSException raise:NSMallocException format:@"Can't grow the tag stack to %lu tags", (unsigned long)tagCapacity];
+    }
+
+    stack->droppedTags = droppedTags;
+
+    memset(stack->openCounts + stack->tagCapacity, 0, (tagCapacity - stack->tagCapacity) * sizeof(NSUInteger));
+    memset(stack->droppedCounts + stack->tagCapacity, 0, (tagCapacity - stack->tagCapacity) * sizeof(NSUInteger));
+    stack->tagCapacity = tagCapacity;
+}
+
+static void LSParserTagStackDropTag(LSParserTagStack *stack, NSUInteger tagIndex)
+{
+    // every tag index is listed once, so the list never outgrows the tag capacity
+    if (stack->droppedCounts[tagIndex]++ == 0) {
+        stack->droppedTags[stack->droppedTagCount++] = tagIndex;
+    }
+}
+
+static void LSParserTagStackResetDroppedTags(LSParserTagStack *stack)
+{
+    for (NSUInteger index = 0; index < stack->droppedTagCount; index++) {
+        stack->droppedCounts[stack->droppedTags[index]] = 0;
+    }
+
+    stack->droppedTagCount = 0;
+}
+
+static void LSParserTagStackFree(LSParserTagStack *stack)
+{
+    free(stack->nodes);
+    free(stack->openCounts);
+    free(stack->droppedCounts);
+    free(stack->droppedTags);
+}
+
 @implementation LSParser
 
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _maximumTagDepth = LSPARSER_DEFAULT_MAX_TAG_DEPTH;
+    }
+
+    return self;
+}
+
 
 #pragma mark - lexer & parser impl
 
 - (LSNode *)parseString:(NSString *)string error:(NSError **)error
 {
-    NSArray *tokens = [self scan:string error:error];
-
-    return [self parseTokens:tokens];
+    return [[self parseNodeTreeFromString:string error:error] rootNode];
 }
 
 - (LSNode *)parseTokens:(NSArray *)tokens
 {
-    LSNode *rootNode = [LSNode nodeWithTagName:@"ROOT" andContent:nil andAttributes:nil];
-    LSNode *currentNode = rootNode;
-    
-    for (LSToken *token in tokens) {
-        
+    return [self parseTokenBuffer:[LSTokenBuffer tokenBufferWithTokens:tokens]];
+}
+
+- (LSNode *)parseTokenBuffer:(LSTokenBuffer *)tokenBuffer
+{
+    return [[self parseNodeTreeFromTokenBuffer:tokenBuffer] rootNode];
+}
+
+- (LSNodeTree *)parseNodeTreeFromString:(NSString *)string error:(NSError **)error
+{
+    LSTokenBuffer *tokenBuffer = [self scanTokens:string error:error];
+
+    return [self parseNodeTreeFromTokenBuffer:tokenBuffer];
+}
+
+- (LSNodeTree *)parseNodeTreeFromString:(NSString *)string withTokenBuffer:(LSTokenBuffer *)tokenBuffer
+                            andNodeTree:(LSNodeTree *)nodeTree error:(NSError **)error
+{
+    if (![self scanTokens:string intoTokenBuffer:tokenBuffer error:error]) {
+        return nil;
+    }
+
+    [nodeTree resetWithSourceString:tokenBuffer.string];
+    [self parseTokenBuffer:tokenBuffer intoNodeTree:nodeTree];
+
+    return nodeTree;
+}
+
+- (LSNodeTree *)parseNodeTreeFromTokenBuffer:(LSTokenBuffer *)tokenBuffer
+{
+    LSNodeTree *tree = [[LSNodeTree alloc] initWithSourceString:tokenBuffer.string andRootTagName:@"ROOT"
+                                                  andTagRegistry:self.tagRegistry];
+    [self parseTokenBuffer:tokenBuffer intoNodeTree:tree];
+
+    return tree;
+}
+
+- (void)parseTokenBuffer:(LSTokenBuffer *)tokenBuffer intoNodeTree:(LSNodeTree *)tree
+{
+    LSParserTagStack stack = LSParserTagStackCreate(MAX(self.maximumTagDepth, 1));
+
+    // the tree index of a token buffer tag index plus one, so every tag name is interned once per parse
+    NSUInteger *treeTagIndexes = calloc(MAX(tokenBuffer.tagNameCount, 1), sizeof(NSUInteger));
+
+    if (!treeTagIndexes) {
+        LSParserTagStackFree(&stack);
+        [NSException raise:NSMallocException format:@"Can't map %lu tag names", (unsigned long)tokenBuffer.tagNameCount];
+    }
+
+    const LSTokenRecord *tokens = tokenBuffer.tokens;
+
+    for (NSUInteger index = 0; index < tokenBuffer.count; index++) {
+        LSTokenRecord token = tokens[index];
+        NSUInteger currentNode = (stack.count > 0) ? stack.nodes[stack.count - 1] : tree.rootIndex;
+
         if (token.type == LSTokenTypeContent || token.type == LSTokenTypeNewline) {
             // newline char is handled like content at the moment
-            LSNode *newContentNode = [currentNode nodeFromParentNode:nil andContent:token.value andAttributes:nil];
-            [currentNode addChildNode:newContentNode];
-        } else if (token.type == LSTokenTypeOpenTag) {
-            LSNode *newContentNode = [currentNode nodeFromParentNode:token.value andContent:nil andAttributes:token.attributes];
-            [currentNode addChildNode:newContentNode];
-            currentNode = newContentNode;
+            [tree addContentNodeWithRange:token.range toParent:currentNode];
+            continue;
+        }
+
+        if (treeTagIndexes[token.tagIndex] == 0) {
+            treeTagIndexes[token.tagIndex] = [tree internTagName:[tokenBuffer tagNameAtIndex:token.tagIndex]] + 1;
+        }
+
+        NSUInteger tagIndex = treeTagIndexes[token.tagIndex] - 1;
+        LSParserTagStackReserveTag(&stack, tagIndex);
 
+        if (token.type == LSTokenTypeOpenTag) {
+            if (stack.count == stack.capacity) {
+                // tags nested too deep are dropped together with their close tags
+                LSParserTagStackDropTag(&stack, tagIndex);
+                LSTrace(LSTraceCategoryParse, LSTraceLevelWarning, "Dropped tag nested deeper than %lu at %lu",
+                        (unsigned long)stack.capacity, (unsigned long)token.range.location);
+                continue;
+            }
+
+            NSUInteger tagPath = [tree tagPathByAppendingTag:tagIndex toTagPath:[tree nodeAtIndex:currentNode].tagPath];
+            NSUInteger newNode = [tree addTagNodeWithTagIndex:tagIndex
+                                                   andTagPath:tagPath
+                                                andAttributes:[tokenBuffer attributesOfTokenAtIndex:index]];
+            [tree addChildNode:newNode toParent:currentNode];
+
+            stack.nodes[stack.count++] = newNode;
+            stack.openCounts[tagIndex]++;
         } else if (token.type == LSTokenTypeCloseTag) {
-            if ([currentNode.tagName isEqual:token.value]) {
-                currentNode = currentNode.parentNode;
-            } else {
-                if ([currentNode.tagNames containsObject:token.value]) {
-
-                    // do a backtracing only if the closing tag has a valid context
-                    LSNode *backtraceNode = nil;
-                    LSNode *saveNode = nil;
-                    while (currentNode.tagName && ![currentNode.tagName isEqual:token.value]) {
-                        LSNode *newNode = [LSNode nodeWithTagName:currentNode.tagName andContent:nil andAttributes:currentNode.attributes];
-                        [newNode addChildNode:backtraceNode];
-                    
-                        NSMutableArray *tagNamesCopy = [currentNode.tagNames mutableCopy];
-                        [tagNamesCopy removeObject:token.value];
-                        newNode.tagNames = tagNamesCopy;
-
-                        currentNode = currentNode.parentNode;
-                        backtraceNode = newNode;
-                        
-                        if (!saveNode) {
-                            saveNode = newNode;
-                        }
-                    }
-
-                    if ([currentNode.tagName isEqual:token.value]) {
-                        currentNode = currentNode.parentNode;
-                    }
-
-                    [currentNode addChildNode:backtraceNode];
-                    currentNode = saveNode;
-                }
+            if (stack.droppedCounts[tagIndex] > 0) {
+                stack.droppedCounts[tagIndex]--;
+            } else if (stack.openCounts[tagIndex] > 0) {
+                [self closeTag:tagIndex ofStack:&stack inTree:tree];
             }
+            // close tags without open tag are ignored
         }
     }
-    
-    return rootNode;
+
+    LSParserTagStackFree(&stack);
+    free(treeTagIndexes);
+
+    LSTrace(LSTraceCategoryParse, LSTraceLevelInfo, "Parsed %lu tokens into %lu nodes",
+            (unsigned long)tokenBuffer.count, (unsigned long)tree.count);
+}
+
+- (void)closeTag:(NSUInteger)tagIndex ofStack:(LSParserTagStack *)stack inTree:(LSNodeTree *)tree
+{
+    NSUInteger closedLevel = stack->count - 1;
+    while ([tree nodeAtIndex:stack->nodes[closedLevel]].tagIndex != tagIndex) {
+        closedLevel--;
+    }
+
+    stack->openCounts[tagIndex]--;
+
+    // the dropped tags were nested in the closed tag or in one inside it, so their close tags
+    // following it don't belong to them anymore
+    LSParserTagStackResetDroppedTags(stack);
+
+    // tags opened inside the closed tag are continuing after it, so they are opened again
+    NSUInteger parentNode = (closedLevel > 0) ? stack->nodes[closedLevel - 1] : tree.rootIndex;
+
+    for (NSUInteger level = closedLevel + 1; level < stack->count; level++) {
+        NSUInteger innerNode = stack->nodes[level];
+        LSNodeRecord inner = [tree nodeAtIndex:innerNode];
+
+        NSUInteger newNode = [tree addTagNodeWithTagIndex:inner.tagIndex
+                                               andTagPath:[tree tagPathByAppendingTag:inner.tagIndex
+                                                                            toTagPath:[tree nodeAtIndex:parentNode].tagPath]
+                                            andAttributes:[tree attributesOfNodeAtIndex:innerNode]];
+        [tree addChildNode:newNode toParent:parentNode];
+
+        stack->nodes[level - 1] = newNode;
+        parentNode = newNode;
+    }
+
+    stack->count--;
 }
 
 #pragma mark - scan tasks
 
 - (NSMutableArray *)scan:(NSString *)string error:(NSError **)error
 {
-    self.scanner = [NSScanner scannerWithString:string];
-    
-    // this line is needed since whitespace chars are stripped out by default
-    [self.scanner setCharactersToBeSkipped:[NSCharacterSet characterSetWithCharactersInString:@""]];
-    
-    NSMutableArray *results = [NSMutableArray array];
-    
-    while (!self.scanner.isAtEnd) {
-        LSTokenType key = LSTokenTypeContent;
-        NSString *value = nil;
-        NSDictionary *attributes = nil;
-        
-        BOOL didScan = [self scanNewLine:&value andKey:&key] ||
-        [self scanContent:&value andKey:&key] ||
-        [self scanCloseTag:&value andKey:&key] ||
-        [self scanOpenTag:&value andKey:&key andAttributes:&attributes];
-        
-        if (!didScan) {
-            NSLog(@"Couldn't parse: %lu", (unsigned long)self.scanner.scanLocation);
-            return nil;
-        }
-        
-        if (value) {
-            [results addObject:[LSToken tokenWithType:key andValue:value andAttributes:attributes]];
-        }
+    LSTokenBuffer *tokenBuffer = [self scanTokens:string error:error];
+
+    if (!tokenBuffer) {
+        return nil;
     }
+
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:tokenBuffer.count];
+
+    for (NSUInteger index = 0; index < tokenBuffer.count; index++) {
+        [results addObject:[tokenBuffer tokenObjectAtIndex:index]];
+    }
+
     return results;
 }
 
-- (BOOL)scanOpenTag:(NSString **)out andKey:(LSTokenType *)key andAttributes:(NSDictionary **)attributes
+- (LSTokenBuffer *)scanTokens:(NSString *)string error:(NSError **)error
 {
-    *key = LSTokenTypeOpenTag;
-    BOOL didScan = [self.scanner scanString:@"[" intoString:NULL] &&
-    [self.scanner scanUpToString:@"]" intoString:out] &&
-    [self.scanner scanString:@"]" intoString:NULL];
-    
-    if (didScan && ([*out rangeOfString:@"="].length > 0)) {
-        NSString *tagString = [*out copy];
-        
-        NSRange firstSeparatorRange = [tagString rangeOfString:@" "];
-        if (firstSeparatorRange.length > 0) {
-            *out = [tagString substringWithRange:NSMakeRange(0, firstSeparatorRange.location)];
-            *attributes = [NSMutableDictionary new];
-
-            NSString *attributesString = [tagString substringWithRange:
-                                          NSMakeRange(firstSeparatorRange.location + 1, tagString.length - [*out length] - 1)];
-
-            NSRegularExpression *regex = [NSRegularExpression
-                                      regularExpressionWithPattern:@"(\\S+)=[\"']?((?:.(?![\"\']?\\s+(?:\\S+)=|[>\"']))+.)[\"']?"
-                                      options:0
-                                      error:nil];
-        
-            [regex enumerateMatchesInString:attributesString
-                                options:0
-                                  range:NSMakeRange(0, attributesString.length)
-                             usingBlock:^(NSTextCheckingResult *match,
-                                          NSMatchingFlags flags,
-                                          BOOL *stop) {
-
-                                 NSRange keyRange = [match rangeAtIndex:1];
-                                 NSRange valueRange = [match rangeAtIndex:2];
-                                 [*attributes setValue:[attributesString substringWithRange:valueRange]
-                                                forKey:[attributesString substringWithRange:keyRange]];
-                             }];
+    return [self scanTokens:string intoTokenBuffer:[[LSTokenBuffer alloc] initWithString:string] error:error];
+}
+
+- (LSTokenBuffer *)scanTokens:(NSString *)string intoTokenBuffer:(LSTokenBuffer *)tokenBuffer error:(NSError **)error
+{
+    NSError *scanError = nil;
+    LSLexer *lexer = [[LSLexer alloc] initWithString:string];
+    [tokenBuffer resetWithString:lexer.string];
+
+    BOOL didScan = [lexer enumerateTokensUsingBlock:^(LSTokenType type, NSRange range, BOOL *stop) {
+        if (type == LSTokenTypeOpenTag) {
+            [self scanOpenTag:range intoTokenBuffer:tokenBuffer];
+        } else {
+            [tokenBuffer addTokenWithType:type andRange:range];
         }
+    } error:&scanError];
+
+    if (!didScan) {
+        LSTrace(LSTraceCategoryParse, LSTraceLevelError, "Couldn't parse: %s", scanError.localizedDescription.UTF8String);
+
+        if (error) {
+            *error = scanError;
+        }
+        return nil;
     }
-    
-    return didScan ? YES : NO;
+
+    return tokenBuffer;
 }
 
-- (BOOL)scanCloseTag:(NSString **)out andKey:(LSTokenType *)key
+- (LSToken *)scanOpenTagValue:(NSString *)tagValue
 {
-    *key = LSTokenTypeCloseTag;
-    BOOL didScan = [self.scanner scanString:@"[/" intoString:NULL] &&
-    [self.scanner scanUpToString:@"]" intoString:out] &&
-    [self.scanner scanString:@"]" intoString:NULL];
-    
-    return didScan ? YES : NO;
+    LSTokenBuffer *tokenBuffer = [[LSTokenBuffer alloc] initWithString:tagValue];
+    [self scanOpenTag:NSMakeRange(0, tokenBuffer.string.length) intoTokenBuffer:tokenBuffer];
+
+    return [tokenBuffer tokenObjectAtIndex:0];
 }
 
-- (BOOL)scanNewLine:(NSString **)out andKey:(LSTokenType *)key
+- (void)scanOpenTag:(NSRange)tagRange intoTokenBuffer:(LSTokenBuffer *)tokenBuffer
 {
-    *key = LSTokenTypeNewline;
-    BOOL didScan = [self.scanner scanString:@"\n" intoString:out];
+    NSString *source = tokenBuffer.string;
+
+    NSRange equalsRange = [source rangeOfString:@"=" options:NSLiteralSearch range:tagRange];
+    NSRange firstSeparatorRange = (equalsRange.length > 0)
+        ? [source rangeOfString:@" " options:NSLiteralSearch range:tagRange]
+        : NSMakeRange(NSNotFound, 0);
+
+    if (equalsRange.length > 0 && equalsRange.location > tagRange.location &&
+        (firstSeparatorRange.length == 0 || equalsRange.location < firstSeparatorRange.location)) {
+        // [url=...] is a tag named url, the value is the attribute named like the tag
+        [tokenBuffer addTokenWithType:LSTokenTypeOpenTag
+                             andRange:NSMakeRange(tagRange.location, equalsRange.location - tagRange.location)];
+        [self scanAttributes:tagRange ofString:source intoTokenBuffer:tokenBuffer];
+        return;
+    }
+
+    if (firstSeparatorRange.length == 0) {
+        [tokenBuffer addTokenWithType:LSTokenTypeOpenTag andRange:tagRange];
+        return;
+    }
+
+    NSRange tagNameRange = NSMakeRange(tagRange.location, firstSeparatorRange.location - tagRange.location);
+    NSRange attributesRange = NSMakeRange(NSMaxRange(firstSeparatorRange), NSMaxRange(tagRange) - NSMaxRange(firstSeparatorRange));
 
-    return didScan ? YES : NO;
+    [tokenBuffer addTokenWithType:LSTokenTypeOpenTag andRange:tagNameRange];
+    [self scanAttributes:attributesRange ofString:source intoTokenBuffer:tokenBuffer];
 }
 
-- (BOOL)scanContent:(NSString **)out andKey:(LSTokenType *)key
+- (void)scanAttributes:(NSRange)attributesRange ofString:(NSString *)source intoTokenBuffer:(LSTokenBuffer *)tokenBuffer
 {
-    *key = LSTokenTypeContent;
-    BOOL didScan = [self.scanner scanUpToString:@"[" intoString:out];
-
-    if (didScan && ([*out rangeOfString:@"\n"].length > 0)) {
-        NSString *contentString = [*out copy];
-        NSRange newlineRange = [contentString rangeOfString:@"\n"];
-        self.scanner.scanLocation = self.scanner.scanLocation - (contentString.length - newlineRange.location);
-        *out = [contentString substringWithRange:NSMakeRange(0, newlineRange.location)];
-    }
+    CFStringInlineBuffer buffer;
+    CFStringInitInlineBuffer((__bridge CFStringRef)source, &buffer, CFRangeMake(0, source.length));
 
-    return didScan ? YES : NO;
+    NSUInteger location = attributesRange.location;
+    NSUInteger end = NSMaxRange(attributesRange);
+
+    while (location < end) {
+        while (location < end && LSParserIsWhitespace(LSParserCharacterAtIndex(&buffer, location))) {
+            location++;
+        }
+
+        // the key runs up to the first equals sign of a word, words without one are skipped
+        NSUInteger keyLocation = location;
+        unichar character = 0;
+
+        while (location < end) {
+            character = LSParserCharacterAtIndex(&buffer, location);
+            if (character == '=' || LSParserIsWhitespace(character)) {
+                break;
+            }
+            location++;
+        }
+
+        if (location >= end || character != '=' || location == keyLocation) {
+            while (location < end && !LSParserIsWhitespace(LSParserCharacterAtIndex(&buffer, location))) {
+                location++;
+            }
+            continue;
+        }
+
+        NSRange keyRange = NSMakeRange(keyLocation, location - keyLocation);
+
+        if (++location >= end) {
+            break;
+        }
+
+        character = LSParserCharacterAtIndex(&buffer, location);
+
+        if (character == '"' || character == '\'') {
+            // quoted values can contain any character, a backslash escapes the next one
+            unichar quote = character;
+            NSUInteger valueLocation = ++location;
+            BOOL hasEscapes = NO;
+
+            while (location < end && (character = LSParserCharacterAtIndex(&buffer, location)) != quote) {
+                if (character == '\\') {
+                    hasEscapes = YES;
+                    location++;
+                }
+                location++;
+            }
+
+            location = MIN(location, end);
+
+            [tokenBuffer addAttributeWithKeyRange:keyRange
+                                    andValueRange:NSMakeRange(valueLocation, location - valueLocation)
+                                       andEscapes:hasEscapes];
+            location++;
+        } else if (!LSParserIsLineBreak(character)) {
+            NSUInteger valueLocation = location;
+            location = LSParserUnquotedValueEnd(&buffer, location, end);
+
+            [tokenBuffer addAttributeWithKeyRange:keyRange
+                                    andValueRange:NSMakeRange(valueLocation, location - valueLocation)];
+        }
+    }
 }
 
 #pragma mark - debug output
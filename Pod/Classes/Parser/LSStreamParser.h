@@ -0,0 +1,134 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+@class LSStreamParser;
+
+/*!
+ *  The delegate of LSStreamParser receives the parsed markup as soon as it's complete.
+ */
+@protocol LSStreamParserDelegate <NSObject>
+
+/*!
+ *  Called for a run of content text, including newline chars. A run crossing the end of
+ *  a chunk is reported in parts.
+ *
+ *  @param streamParser the calling parser.
+ *  @param content      the content text.
+ */
+- (void)streamParser:(LSStreamParser *)streamParser foundContent:(NSString *)content;
+
+/*!
+ *  Called for an opened tag.
+ *
+ *  @param streamParser the calling parser.
+ *  @param tagName      the tag name.
+ *  @param attributes   the tag attributes or nil.
+ */
+- (void)streamParser:(LSStreamParser *)streamParser didOpenTag:(NSString *)tagName withAttributes:(NSDictionary *)attributes;
+
+/*!
+ *  Called for a closed tag.
+ *
+ *  @param streamParser the calling parser.
+ *  @param tagName      the tag name.
+ */
+- (void)streamParser:(LSStreamParser *)streamParser didCloseTag:(NSString *)tagName;
+
+@end
+
+/*!
+ *  @discussion LSStreamParser is parsing markup pushed in chunks. Content, open and close
+ *              tags are reported to the delegate as soon as they are complete, tags and
+ *              UTF-8 sequences split by the end of a chunk are kept until the next chunk.
+ *              So the memory used is bounded by the chunk size, the maximum tag length and
+ *              the stack of open tags, not by the document size.
+ *
+ *              Tags are handled like LSParser does: a close tag without a matching open tag
+ *              is ignored, a close tag of an outer tag closes the inner tags as well and
+ *              opens them again afterwards.
+ */
+@interface LSStreamParser : NSObject
+
+/*!
+ *  The delegate receiving the parsed markup.
+ */
+@property (nonatomic, weak) id<LSStreamParserDelegate> delegate;
+
+/*!
+ *  The maximum length of a tag between the brackets, longer tags are reported as error.
+ *  Defaults to 1024 characters.
+ */
+@property (nonatomic, assign) NSUInteger maximumTagLength;
+
+/*!
+ *  The maximum number of nested open tags, default is 64. Tags opened deeper are dropped
+ *  together with their close tags, the content is kept.
+ */
+@property (nonatomic, assign) NSUInteger maximumTagDepth;
+
+/*!
+ *  The names of the currently open tags, the innermost tag last.
+ */
+@property (nonatomic, strong, readonly) NSArray *openTagNames;
+
+/*!
+ *  Initializes a stream parser.
+ *
+ *  @param delegate the delegate receiving the parsed markup.
+ *
+ *  @return an instance of LSStreamParser.
+ */
+- (instancetype)initWithDelegate:(id<LSStreamParserDelegate>)delegate;
+
+/*!
+ *  Parses the next chunk of UTF-8 encoded markup.
+ *
+ *  @param data  the chunk data.
+ *  @param error a reference set to an error object if the markup is malformed.
+ *
+ *  @return NO if the markup is malformed, the parser can't be used afterwards.
+ */
+- (BOOL)parseData:(NSData *)data error:(NSError **)error;
+
+/*!
+ *  Parses the next chunk of markup.
+ *
+ *  @param string the chunk string.
+ *  @param error  a reference set to an error object if the markup is malformed.
+ *
+ *  @return NO if the markup is malformed, the parser can't be used afterwards.
+ */
+- (BOOL)parseString:(NSString *)string error:(NSError **)error;
+
+/*!
+ *  Ends the markup. Tags still open are closed.
+ *
+ *  @param error a reference set to an error object if the markup ends within a tag or
+ *               an UTF-8 sequence.
+ *
+ *  @return NO if the markup is malformed.
+ */
+- (BOOL)finishWithError:(NSError **)error;
+
+@end
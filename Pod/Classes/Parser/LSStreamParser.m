@@ -0,0 +1,276 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSStreamParser.h"
+#import "LSLexer.h"
+#import "LSParser.h"
+
+#define LSSTREAMPARSER_DEFAULT_MAX_TAG_LENGTH 1024
+
+static inline NSUInteger LSStreamParserCompleteUTF8Length(const uint8_t *bytes, NSUInteger length)
+{
+    // looks for the lead byte of the last sequence and checks if all its bytes are there
+    for (NSUInteger back = 1; back <= MIN(4, length); back++) {
+        uint8_t byte = bytes[length - back];
+
+        if ((byte & 0xC0) == 0x80) {
+            continue;
+        }
+
+        NSUInteger sequenceLength = ((byte & 0xE0) == 0xC0) ? 2 : ((byte & 0xF0) == 0xE0) ? 3 : ((byte & 0xF8) == 0xF0) ? 4 : 1;
+
+        return (sequenceLength > back) ? length - back : length;
+    }
+
+    return length;
+}
+
+@implementation LSStreamParser {
+    LSParser *_parser;
+    NSMutableArray *_openTags;
+    NSCountedSet *_droppedTagNames;
+    NSMutableString *_tagValue;
+    NSData *_pendingBytes;
+    NSError *_error;
+}
+
+- (instancetype)init
+{
+    return [self initWithDelegate:nil];
+}
+
+- (instancetype)initWithDelegate:(id<LSStreamParserDelegate>)delegate
+{
+    if (self = [super init]) {
+        _delegate = delegate;
+        _maximumTagLength = LSSTREAMPARSER_DEFAULT_MAX_TAG_LENGTH;
+        _parser = [LSParser new];
+        _openTags = [NSMutableArray array];
+        _droppedTagNames = [NSCountedSet set];
+    }
+
+    return self;
+}
+
+- (NSUInteger)maximumTagDepth
+{
+    return _parser.maximumTagDepth;
+}
+
+- (void)setMaximumTagDepth:(NSUInteger)maximumTagDepth
+{
+    _parser.maximumTagDepth = maximumTagDepth;
+}
+
+- (NSArray *)openTagNames
+{
+    return [_openTags valueForKey:@"value"];
+}
+
+#pragma mark - parsing
+
+- (BOOL)parseData:(NSData *)data error:(NSError **)error
+{
+    if (_error) {
+        return [self failWithError:_error error:error];
+    }
+
+    if (_pendingBytes) {
+        NSMutableData *joinedData = [_pendingBytes mutableCopy];
+        [joinedData appendData:data];
+        data = joinedData;
+        _pendingBytes = nil;
+    }
+
+    NSUInteger completeLength = LSStreamParserCompleteUTF8Length(data.bytes, data.length);
+    NSString *string = [[NSString alloc] initWithBytes:data.bytes length:completeLength encoding:NSUTF8StringEncoding];
+
+    if (!string) {
+        return [self failWithCode:LSLexerErrorInvalidEncoding description:@"Invalid UTF-8 data" error:error];
+    }
+
+    if (completeLength < data.length) {
+        _pendingBytes = [data subdataWithRange:NSMakeRange(completeLength, data.length - completeLength)];
+    }
+
+    return [self parseString:string error:error];
+}
+
+- (BOOL)parseString:(NSString *)string error:(NSError **)error
+{
+    if (_error) {
+        return [self failWithError:_error error:error];
+    }
+
+    NSUInteger length = string.length;
+    NSUInteger location = 0;
+
+    while (location < length) {
+        NSRange remainingRange = NSMakeRange(location, length - location);
+
+        if (!_tagValue) {
+            NSUInteger tagStart = [string rangeOfString:@"[" options:NSLiteralSearch range:remainingRange].location;
+            NSUInteger contentEnd = (tagStart != NSNotFound) ? tagStart : length;
+
+            if (contentEnd > location) {
+                [self.delegate streamParser:self foundContent:[string substringWithRange:NSMakeRange(location, contentEnd - location)]];
+            }
+
+            if (tagStart == NSNotFound) {
+                break;
+            }
+
+            _tagValue = [NSMutableString string];
+            location = tagStart + 1;
+            continue;
+        }
+
+        // the tag can be started by a previous chunk
+        NSUInteger tagEnd = [string rangeOfString:@"]" options:NSLiteralSearch range:remainingRange].location;
+        NSUInteger valueEnd = (tagEnd != NSNotFound) ? tagEnd : length;
+
+        if (_tagValue.length + valueEnd - location > self.maximumTagLength) {
+            return [self failWithCode:LSLexerErrorTagTooLong description:@"Tag exceeds the maximum tag length" error:error];
+        }
+
+        [_tagValue appendString:[string substringWithRange:NSMakeRange(location, valueEnd - location)]];
+
+        if (tagEnd == NSNotFound) {
+            break;
+        }
+
+        if (![self processTagValue:_tagValue error:error]) {
+            return NO;
+        }
+
+        _tagValue = nil;
+        location = tagEnd + 1;
+    }
+
+    return YES;
+}
+
+- (BOOL)finishWithError:(NSError **)error
+{
+    if (_error) {
+        return [self failWithError:_error error:error];
+    }
+
+    if (_tagValue) {
+        return [self failWithCode:LSLexerErrorMalformedTag description:@"Markup ends within a tag" error:error];
+    }
+
+    if (_pendingBytes) {
+        return [self failWithCode:LSLexerErrorInvalidEncoding description:@"Markup ends within an UTF-8 sequence" error:error];
+    }
+
+    while (_openTags.count > 0) {
+        LSToken *openTag = _openTags.lastObject;
+        [_openTags removeLastObject];
+        [self.delegate streamParser:self didCloseTag:openTag.value];
+    }
+
+    return YES;
+}
+
+#pragma mark - tags
+
+- (BOOL)processTagValue:(NSString *)tagValue error:(NSError **)error
+{
+    BOOL isCloseTag = [tagValue hasPrefix:@"/"];
+    NSString *value = isCloseTag ? [tagValue substringFromIndex:1] : tagValue;
+
+    if (value.length == 0) {
+        return [self failWithCode:LSLexerErrorMalformedTag description:@"Empty tag" error:error];
+    }
+
+    if (isCloseTag) {
+        [self closeTagWithName:value];
+    } else {
+        LSToken *openTag = [_parser scanOpenTagValue:value];
+
+        // same as LSParser, tags nested too deep are dropped together with their close tags
+        if (_openTags.count >= MAX(self.maximumTagDepth, 1)) {
+            [_droppedTagNames addObject:openTag.value];
+            return YES;
+        }
+
+        [_openTags addObject:openTag];
+        [self.delegate streamParser:self didOpenTag:openTag.value withAttributes:openTag.attributes];
+    }
+
+    return YES;
+}
+
+- (void)closeTagWithName:(NSString *)tagName
+{
+    if ([_droppedTagNames countForObject:tagName] > 0) {
+        [_droppedTagNames removeObject:tagName];
+        return;
+    }
+
+    NSUInteger tagIndex = [_openTags indexOfObjectWithOptions:NSEnumerationReverse passingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
+        return [[(LSToken *)obj value] isEqualToString:tagName];
+    }];
+
+    if (tagIndex == NSNotFound) {
+        return;
+    }
+
+    // same as LSParser, the dropped tags were nested in the closed tag, their close tags following it don't belong to them
+    [_droppedTagNames removeAllObjects];
+
+    NSRange innerTagsRange = NSMakeRange(tagIndex + 1, _openTags.count - tagIndex - 1);
+    NSArray *innerTags = [_openTags subarrayWithRange:innerTagsRange];
+
+    for (LSToken *openTag in [[_openTags subarrayWithRange:NSMakeRange(tagIndex, _openTags.count - tagIndex)] reverseObjectEnumerator]) {
+        [self.delegate streamParser:self didCloseTag:openTag.value];
+    }
+
+    [_openTags removeObjectsInRange:NSMakeRange(tagIndex, _openTags.count - tagIndex)];
+
+    // inner tags are continuing after the closed tag
+    for (LSToken *openTag in innerTags) {
+        [_openTags addObject:openTag];
+        [self.delegate streamParser:self didOpenTag:openTag.value withAttributes:openTag.attributes];
+    }
+}
+
+#pragma mark - errors
+
+- (BOOL)failWithCode:(LSLexerErrorCode)code description:(NSString *)description error:(NSError **)error
+{
+    _error = [NSError errorWithDomain:LSLexerErrorDomain code:code userInfo:@{NSLocalizedDescriptionKey : description}];
+
+    return [self failWithError:_error error:error];
+}
+
+- (BOOL)failWithError:(NSError *)failure error:(NSError **)error
+{
+    if (error) {
+        *error = failure;
+    }
+
+    return NO;
+}
+
+@end
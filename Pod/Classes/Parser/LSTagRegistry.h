@@ -0,0 +1,107 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import "LSBBCodeSerializer.h"
+
+/*!
+ *  Adds the attributes of a tag to the attributes of a styled run.
+ *
+ *  @param attributes     the attributes of the run, containing the font of the run.
+ *  @param tagAttributes  the attributes of the tag, for [color=red] it's @{@"color" : @"red"}.
+ *  @param baseAttributes the attributes of unstyled text, e.g. the font a [size] tag falls back to.
+ */
+typedef void (^LSTagHandler)(NSMutableDictionary *attributes, NSDictionary *tagAttributes, NSDictionary *baseAttributes);
+
+/*!
+ *  @discussion LSTagRegistry keeps the tags known to the editor. Every tag gets a small
+ *              integer ID, so the styling code can dispatch on the ID instead of comparing
+ *              tag names. A tag is either one of the styles written by LSBBCodeSerializer
+ *              or has a handler adding attributes to the styled text.
+ *
+ *              A new registry contains the style tags s, u, i and b. Tags have to be
+ *              registered before the registry is used, lookups can run on any thread then.
+ */
+@interface LSTagRegistry : NSObject
+
+/*!
+ *  The number of registered tags, tag IDs are in the range from zero to count.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/*!
+ *  Registers a tag, registering a tag name again replaces style and handler.
+ *
+ *  @param tagName the tag name.
+ *  @param style   the style written for the tag, LSBBCodeStyleNone for handler tags.
+ *  @param handler the handler adding attributes for the tag, can be nil.
+ *
+ *  @return the tag ID.
+ */
+- (NSUInteger)registerTagName:(NSString *)tagName withStyle:(LSBBCodeStyle)style andHandler:(LSTagHandler)handler;
+
+/*!
+ *  Looks up the ID of a tag name.
+ *
+ *  @param tagName the tag name.
+ *
+ *  @return the tag ID or NSNotFound for unknown tags.
+ */
+- (NSUInteger)tagIDForName:(NSString *)tagName;
+
+/*!
+ *  Returns the name of a tag.
+ *
+ *  @param tagID the tag ID.
+ *
+ *  @return the tag name.
+ */
+- (NSString *)tagNameForID:(NSUInteger)tagID;
+
+/*!
+ *  Returns the style of a tag.
+ *
+ *  @param tagID the tag ID.
+ *
+ *  @return the style or LSBBCodeStyleNone for handler tags.
+ */
+- (LSBBCodeStyle)styleForID:(NSUInteger)tagID;
+
+/*!
+ *  Returns the handler of a tag.
+ *
+ *  @param tagID the tag ID.
+ *
+ *  @return the handler or nil.
+ */
+- (LSTagHandler)handlerForID:(NSUInteger)tagID;
+
+/*!
+ *  Returns the name of the tag written for a style.
+ *
+ *  @param style a single style.
+ *
+ *  @return the tag name or nil if no tag is registered for the style.
+ */
+- (NSString *)tagNameForStyle:(LSBBCodeStyle)style;
+
+@end
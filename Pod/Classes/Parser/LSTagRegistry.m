@@ -0,0 +1,154 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSTagRegistry.h"
+
+#define LSTAGREGISTRY_BUCKET_COUNT 64
+#define LSTAGREGISTRY_INITIAL_CAPACITY 16
+
+// tag names are short and mostly differ in the first character or the length
+static inline NSUInteger LSTagRegistryBucket(unichar firstCharacter, NSUInteger length)
+{
+    return (firstCharacter * 31 + length) & (LSTAGREGISTRY_BUCKET_COUNT - 1);
+}
+
+@implementation LSTagRegistry {
+    NSMutableArray *_tagNames;
+    NSMutableArray *_handlers;
+    LSBBCodeStyle *_styles;
+    NSUInteger *_nextInBucket;
+    NSUInteger _capacity;
+
+    NSUInteger _buckets[LSTAGREGISTRY_BUCKET_COUNT];
+}
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _tagNames = [NSMutableArray array];
+        _handlers = [NSMutableArray array];
+
+        for (NSUInteger bucket = 0; bucket < LSTAGREGISTRY_BUCKET_COUNT; bucket++) {
+            _buckets[bucket] = NSNotFound;
+        }
+
+        [self registerTagName:@"s" withStyle:LSBBCodeStyleStrikeThrough andHandler:nil];
+        [self registerTagName:@"u" withStyle:LSBBCodeStyleUnderlined andHandler:nil];
+        [self registerTagName:@"i" withStyle:LSBBCodeStyleItalic andHandler:nil];
+        [self registerTagName:@"b" withStyle:LSBBCodeStyleBold andHandler:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_styles);
+    free(_nextInBucket);
+}
+
+- (NSUInteger)count
+{
+    return _tagNames.count;
+}
+
+- (NSUInteger)registerTagName:(NSString *)tagName withStyle:(LSBBCodeStyle)style andHandler:(LSTagHandler)handler
+{
+    NSUInteger tagID = [self tagIDForName:tagName];
+
+    if (tagID == NSNotFound) {
+        tagID = _tagNames.count;
+
+        if (tagID == _capacity) {
+            NSUInteger capacity = _capacity ? _capacity * 2 : LSTAGREGISTRY_INITIAL_CAPACITY;
+            LSBBCodeStyle *styles = realloc(_styles, capacity * sizeof(LSBBCodeStyle));
+            // the old arrays stay valid if growing fails, so they are replaced one by one
+            if (styles) {
+                _styles = styles;
+            }
+            NSUInteger *nextInBucket = styles ? realloc(_nextInBucket, capacity * sizeof(NSUInteger)) : NULL;
+
+            if (!nextInBucket) {
+                [NSException raise:NSMallocException format:@"Can't grow the tag registry to %lu tags", (unsigned long)capacity];
+            }
+
+            _nextInBucket = nextInBucket;
+            _capacity = capacity;
+        }
+
+        NSUInteger bucket = LSTagRegistryBucket(tagName.length ? [tagName characterAtIndex:0] : 0, tagName.length);
+        _nextInBucket[tagID] = _buckets[bucket];
+        _buckets[bucket] = tagID;
+
+        [_tagNames addObject:[tagName copy]];
+        [_handlers addObject:[NSNull null]];
+    }
+
+    _styles[tagID] = style;
+    _handlers[tagID] = handler ? [handler copy] : [NSNull null];
+
+    return tagID;
+}
+
+- (NSUInteger)tagIDForName:(NSString *)tagName
+{
+    NSUInteger length = tagName.length;
+    NSUInteger bucket = LSTagRegistryBucket(length ? [tagName characterAtIndex:0] : 0, length);
+
+    for (NSUInteger tagID = _buckets[bucket]; tagID != NSNotFound; tagID = _nextInBucket[tagID]) {
+        if ([_tagNames[tagID] isEqualToString:tagName]) {
+            return tagID;
+        }
+    }
+
+    return NSNotFound;
+}
+
+- (NSString *)tagNameForID:(NSUInteger)tagID
+{
+    return (tagID < _tagNames.count) ? _tagNames[tagID] : nil;
+}
+
+- (LSBBCodeStyle)styleForID:(NSUInteger)tagID
+{
+    return (tagID < _tagNames.count) ? _styles[tagID] : LSBBCodeStyleNone;
+}
+
+- (LSTagHandler)handlerForID:(NSUInteger)tagID
+{
+    id handler = (tagID < _tagNames.count) ? _handlers[tagID] : nil;
+
+    return (handler != [NSNull null]) ? handler : nil;
+}
+
+- (NSString *)tagNameForStyle:(LSBBCodeStyle)style
+{
+    for (NSUInteger tagID = 0; tagID < _tagNames.count; tagID++) {
+        if (_styles[tagID] == style) {
+            return _tagNames[tagID];
+        }
+    }
+
+    return nil;
+}
+
+@end
@@ -0,0 +1,179 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import "LSToken.h"
+
+/*!
+ *  @typedef LSTokenRecord
+ *
+ *  @brief A plain token referencing its value by range.
+ *
+ *  @field type           the token type.
+ *  @field range          the range of the token value in the source string, for tags it's the tag name.
+ *  @field tagIndex       the index of the interned tag name, NSNotFound for content tokens.
+ *  @field attributeIndex the index of the first attribute span of the token.
+ *  @field attributeCount the number of attribute spans of the token.
+ */
+typedef struct {
+    LSTokenType type;
+    NSRange range;
+    NSUInteger tagIndex;
+    NSUInteger attributeIndex;
+    NSUInteger attributeCount;
+} LSTokenRecord;
+
+/*!
+ *  @typedef LSAttributeSpan
+ *
+ *  @brief A tag attribute referencing key and value by range.
+ *
+ *  @field keyRange   the range of the attribute key in the source string.
+ *  @field valueRange the range of the attribute value in the source string.
+ *  @field keyIndex   the index of the interned attribute key.
+ *  @field hasEscapes YES if the value contains backslash escapes to be removed.
+ */
+typedef struct {
+    NSRange keyRange;
+    NSRange valueRange;
+    NSUInteger keyIndex;
+    BOOL hasEscapes;
+} LSAttributeSpan;
+
+/*!
+ *  @discussion LSTokenBuffer keeps the tokens of a scanned string as plain structs in one
+ *              contiguous array. Token values are ranges into the source string, tag names
+ *              and attribute keys are interned, so strings are only created if a consumer
+ *              asks for them.
+ */
+@interface LSTokenBuffer : NSObject
+
+/*!
+ *  The source string the token ranges are pointing to.
+ */
+@property (nonatomic, strong, readonly) NSString *string;
+
+/*!
+ *  The number of tokens in the buffer.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/*!
+ *  The number of interned tag names and attribute keys, tag indexes are smaller than it.
+ */
+@property (nonatomic, assign, readonly) NSUInteger tagNameCount;
+
+/*!
+ *  Initializes an empty buffer for tokens of the given source string.
+ *
+ *  @param string the source string.
+ *
+ *  @return an instance of LSTokenBuffer.
+ */
+- (instancetype)initWithString:(NSString *)string;
+
+/*!
+ *  Removes all tokens and interned names, keeping the allocated storage for the tokens
+ *  of another source string.
+ *
+ *  @param string the new source string.
+ */
+- (void)resetWithString:(NSString *)string;
+
+/*!
+ *  Creates a buffer from an array of LSToken objects.
+ *
+ *  @param tokens an array of LSToken objects.
+ *
+ *  @return an instance of LSTokenBuffer.
+ */
++ (instancetype)tokenBufferWithTokens:(NSArray *)tokens;
+
+/*!
+ *  Appends a token. Tag names of open and close tags are interned.
+ *
+ *  @param type  the token type.
+ *  @param range the range of the token value in the source string.
+ */
+- (void)addTokenWithType:(LSTokenType)type andRange:(NSRange)range;
+
+/*!
+ *  Appends an attribute span to the last added token.
+ *
+ *  @param keyRange   the range of the attribute key in the source string.
+ *  @param valueRange the range of the attribute value in the source string.
+ */
+- (void)addAttributeWithKeyRange:(NSRange)keyRange andValueRange:(NSRange)valueRange;
+
+/*!
+ *  Appends an attribute span to the last added token. The key is interned.
+ *
+ *  @param keyRange   the range of the attribute key in the source string.
+ *  @param valueRange the range of the attribute value in the source string.
+ *  @param hasEscapes YES if backslash escapes in the value have to be removed.
+ */
+- (void)addAttributeWithKeyRange:(NSRange)keyRange andValueRange:(NSRange)valueRange andEscapes:(BOOL)hasEscapes;
+
+/*!
+ *  Direct access to the contiguous token array.
+ *
+ *  @return a pointer to the first token, valid until the next token is added.
+ */
+- (const LSTokenRecord *)tokens;
+
+/*!
+ *  Returns the token value as string, the interned tag name for tags.
+ *
+ *  @param index the token index.
+ *
+ *  @return the token value.
+ */
+- (NSString *)valueOfTokenAtIndex:(NSUInteger)index;
+
+/*!
+ *  Returns the interned tag name or attribute key for a tag index.
+ *
+ *  @param tagIndex the tag index of a token or the key index of an attribute.
+ *
+ *  @return the tag name or nil for NSNotFound.
+ */
+- (NSString *)tagNameAtIndex:(NSUInteger)tagIndex;
+
+/*!
+ *  Returns the token attributes, the dictionary is created on demand.
+ *
+ *  @param index the token index.
+ *
+ *  @return a dictionary of attributes or nil if the token has none.
+ */
+- (NSDictionary *)attributesOfTokenAtIndex:(NSUInteger)index;
+
+/*!
+ *  Creates a LSToken object for a token.
+ *
+ *  @param index the token index.
+ *
+ *  @return an instance of LSToken.
+ */
+- (LSToken *)tokenObjectAtIndex:(NSUInteger)index;
+
+@end
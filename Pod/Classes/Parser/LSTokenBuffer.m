@@ -0,0 +1,331 @@
+/*!
+ * This file is part of LSTextEditor.
+ *
+ * Copyright © 2015 LShift Services GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors:
+ * - Peter Lieder <peter@lshift.de>
+ *
+ */
+
+#import "LSTokenBuffer.h"
+
+#define LSTOKENBUFFER_INITIAL_CAPACITY 64
+#define LSTOKENBUFFER_HASH_BUFFER_SIZE 32
+
+static NSUInteger LSTokenBufferHashOfRange(NSString *string, NSRange range)
+{
+    unichar characters[LSTOKENBUFFER_HASH_BUFFER_SIZE];
+
+    // FNV-1a over all characters of the range, read in chunks
+    NSUInteger hash = 2166136261u ^ range.length;
+    for (NSUInteger location = range.location; location < NSMaxRange(range); location += LSTOKENBUFFER_HASH_BUFFER_SIZE) {
+        NSUInteger length = MIN(LSTOKENBUFFER_HASH_BUFFER_SIZE, NSMaxRange(range) - location);
+        [string getCharacters:characters range:NSMakeRange(location, length)];
+
+        for (NSUInteger index = 0; index < length; index++) {
+            hash = (hash ^ characters[index]) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+@implementation LSTokenBuffer {
+    LSTokenRecord *_tokens;
+    NSUInteger _capacity;
+
+    LSAttributeSpan *_attributes;
+    NSUInteger _attributeCount;
+    NSUInteger _attributeCapacity;
+
+    NSMutableArray *_tagNames;
+    NSUInteger *_tagHashes;
+    NSUInteger _tagHashCapacity;
+
+    // open addressing table of tag indices + 1, zero marks an empty slot
+    NSUInteger *_tagSlots;
+    NSUInteger _tagSlotCount;
+}
+
+- (instancetype)initWithString:(NSString *)string
+{
+    if (self = [super init]) {
+        _string = [string copy];
+        _tagNames = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_tokens);
+    free(_attributes);
+    free(_tagHashes);
+    free(_tagSlots);
+}
+
+- (void)resetWithString:(NSString *)string
+{
+    _string = [string copy];
+    _count = 0;
+    _attributeCount = 0;
+
+    [_tagNames removeAllObjects];
+
+    if (_tagSlots) {
+        memset(_tagSlots, 0, _tagSlotCount * sizeof(NSUInteger));
+    }
+}
+
++ (instancetype)tokenBufferWithTokens:(NSArray *)tokens
+{
+    // token objects don't have a source string, so the values are concatenated into a new one
+    NSMutableString *source = [NSMutableString string];
+    NSMutableArray *ranges = [NSMutableArray arrayWithCapacity:tokens.count];
+
+    for (LSToken *token in tokens) {
+        NSRange range = NSMakeRange(source.length, token.value.length);
+        [source appendString:token.value ?: @""];
+        [ranges addObject:[NSValue valueWithRange:range]];
+    }
+
+    NSMutableArray *attributeRanges = [NSMutableArray arrayWithCapacity:tokens.count];
+
+    for (LSToken *token in tokens) {
+        NSMutableArray *tokenAttributeRanges = [NSMutableArray arrayWithCapacity:token.attributes.count];
+        [token.attributes enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+            NSRange keyRange = NSMakeRange(source.length, [key length]);
+            [source appendString:key];
+            NSRange valueRange = NSMakeRange(source.length, [obj length]);
+            [source appendString:obj];
+            [tokenAttributeRanges addObject:@[[NSValue valueWithRange:keyRange], [NSValue valueWithRange:valueRange]]];
+        }];
+        [attributeRanges addObject:tokenAttributeRanges];
+    }
+
+    LSTokenBuffer *tokenBuffer = [[LSTokenBuffer alloc] initWithString:source];
+
+    [tokens enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        [tokenBuffer addTokenWithType:[(LSToken *)obj type] andRange:[ranges[idx] rangeValue]];
+
+        for (NSArray *attributeRange in attributeRanges[idx]) {
+            [tokenBuffer addAttributeWithKeyRange:[attributeRange[0] rangeValue]
+                                    andValueRange:[attributeRange[1] rangeValue]];
+        }
+    }];
+
+    return tokenBuffer;
+}
+
+#pragma mark - building
+
+- (void)addTokenWithType:(LSTokenType)type andRange:(NSRange)range
+{
+    if (_count == _capacity) {
+        NSUInteger capacity = _capacity ? _capacity * 2 : LSTOKENBUFFER_INITIAL_CAPACITY;
+        LSTokenRecord *tokens = realloc(_tokens, capacity * sizeof(LSTokenRecord));
+
+        if (!tokens) {
+            [NSException raise:NSMallocException format:@"Can't grow the token buffer to %lu tokens", (unsigned long)capacity];
+        }
+
+        _tokens = tokens;
+        _capacity = capacity;
+    }
+
+    LSTokenRecord *token = &_tokens[_count++];
+    token->type = type;
+    token->range = range;
+    token->tagIndex = (type == LSTokenTypeOpenTag || type == LSTokenTypeCloseTag) ? [self internTagNameInRange:range] : NSNotFound;
+    token->attributeIndex = _attributeCount;
+    token->attributeCount = 0;
+}
+
+- (void)addAttributeWithKeyRange:(NSRange)keyRange andValueRange:(NSRange)valueRange
+{
+    [self addAttributeWithKeyRange:keyRange andValueRange:valueRange andEscapes:NO];
+}
+
+- (void)addAttributeWithKeyRange:(NSRange)keyRange andValueRange:(NSRange)valueRange andEscapes:(BOOL)hasEscapes
+{
+    if (_count == 0) {
+        return;
+    }
+
+    if (_attributeCount == _attributeCapacity) {
+        NSUInteger attributeCapacity = _attributeCapacity ? _attributeCapacity * 2 : LSTOKENBUFFER_INITIAL_CAPACITY;
+        LSAttributeSpan *attributes = realloc(_attributes, attributeCapacity * sizeof(LSAttributeSpan));
+
+        if (!attributes) {
+            [NSException raise:NSMallocException format:@"Can't grow the token buffer to %lu attributes", (unsigned long)attributeCapacity];
+        }
+
+        _attributes = attributes;
+        _attributeCapacity = attributeCapacity;
+    }
+
+    _attributes[_attributeCount].keyRange = keyRange;
+    _attributes[_attributeCount].valueRange = valueRange;
+    _attributes[_attributeCount].keyIndex = [self internTagNameInRange:keyRange];
+    _attributes[_attributeCount].hasEscapes = hasEscapes;
+    _attributeCount++;
+    _tokens[_count - 1].attributeCount++;
+}
+
+- (NSUInteger)internTagNameInRange:(NSRange)range
+{
+    if (_tagNames.count * 2 >= _tagSlotCount) {
+        [self growTagSlots];
+    }
+
+    NSUInteger hash = LSTokenBufferHashOfRange(_string, range);
+    NSUInteger mask = _tagSlotCount - 1;
+    NSUInteger slot = hash & mask;
+
+    // names are only compared if the full hashes match
+    while (_tagSlots[slot] != 0) {
+        NSUInteger tagIndex = _tagSlots[slot] - 1;
+        if (_tagHashes[tagIndex] == hash && [self tagNameAtIndex:tagIndex matchesRange:range]) {
+            return tagIndex;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    NSUInteger tagIndex = _tagNames.count;
+
+    if (tagIndex == _tagHashCapacity) {
+        NSUInteger tagHashCapacity = _tagHashCapacity ? _tagHashCapacity * 2 : LSTOKENBUFFER_INITIAL_CAPACITY;
+        NSUInteger *tagHashes = realloc(_tagHashes, tagHashCapacity * sizeof(NSUInteger));
+
+        if (!tagHashes) {
+            [NSException raise:NSMallocException format:@"Can't grow the token buffer to %lu tag names", (unsigned long)tagHashCapacity];
+        }
+
+        _tagHashes = tagHashes;
+        _tagHashCapacity = tagHashCapacity;
+    }
+
+    _tagHashes[tagIndex] = hash;
+    _tagSlots[slot] = tagIndex + 1;
+    [_tagNames addObject:[_string substringWithRange:range]];
+
+    return tagIndex;
+}
+
+- (void)growTagSlots
+{
+    NSUInteger tagSlotCount = _tagSlotCount ? _tagSlotCount * 2 : LSTOKENBUFFER_INITIAL_CAPACITY;
+    NSUInteger *tagSlots = calloc(tagSlotCount, sizeof(NSUInteger));
+
+    if (!tagSlots) {
+        [NSException raise:NSMallocException format:@"Can't grow the token buffer to %lu tag slots", (unsigned long)tagSlotCount];
+    }
+
+    free(_tagSlots);
+    _tagSlots = tagSlots;
+    _tagSlotCount = tagSlotCount;
+
+    NSUInteger mask = _tagSlotCount - 1;
+
+    for (NSUInteger tagIndex = 0; tagIndex < _tagNames.count; tagIndex++) {
+        NSUInteger slot = _tagHashes[tagIndex] & mask;
+        while (_tagSlots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _tagSlots[slot] = tagIndex + 1;
+    }
+}
+
+- (BOOL)tagNameAtIndex:(NSUInteger)tagIndex matchesRange:(NSRange)range
+{
+    NSString *tagName = _tagNames[tagIndex];
+
+    return tagName.length == range.length &&
+        [_string compare:tagName options:NSLiteralSearch range:range] == NSOrderedSame;
+}
+
+#pragma mark - accessors
+
+- (const LSTokenRecord *)tokens
+{
+    return _tokens;
+}
+
+- (NSUInteger)tagNameCount
+{
+    return _tagNames.count;
+}
+
+- (NSString *)tagNameAtIndex:(NSUInteger)tagIndex
+{
+    return (tagIndex != NSNotFound) ? _tagNames[tagIndex] : nil;
+}
+
+- (NSString *)valueOfTokenAtIndex:(NSUInteger)index
+{
+    LSTokenRecord token = _tokens[index];
+
+    return (token.tagIndex != NSNotFound) ? _tagNames[token.tagIndex] : [_string substringWithRange:token.range];
+}
+
+- (NSDictionary *)attributesOfTokenAtIndex:(NSUInteger)index
+{
+    LSTokenRecord token = _tokens[index];
+
+    if (token.attributeCount == 0) {
+        return nil;
+    }
+
+    NSMutableDictionary *attributes = [NSMutableDictionary dictionaryWithCapacity:token.attributeCount];
+
+    for (NSUInteger attributeIndex = token.attributeIndex; attributeIndex < token.attributeIndex + token.attributeCount; attributeIndex++) {
+        LSAttributeSpan span = _attributes[attributeIndex];
+        NSString *value = [_string substringWithRange:span.valueRange];
+
+        [attributes setValue:span.hasEscapes ? [self stringByRemovingEscapes:value] : value
+                      forKey:_tagNames[span.keyIndex]];
+    }
+
+    return attributes;
+}
+
+- (NSString *)stringByRemovingEscapes:(NSString *)value
+{
+    NSUInteger length = value.length;
+    unichar *characters = malloc(MAX(length, 1) * sizeof(unichar));
+    [value getCharacters:characters range:NSMakeRange(0, length)];
+
+    // a backslash keeps the following character, the value is shortened in place
+    NSUInteger unescapedLength = 0;
+    for (NSUInteger index = 0; index < length; index++) {
+        if (characters[index] == '\\' && index + 1 < length) {
+            index++;
+        }
+        characters[unescapedLength++] = characters[index];
+    }
+
+    return [[NSString alloc] initWithCharactersNoCopy:characters length:unescapedLength freeWhenDone:YES];
+}
+
+- (LSToken *)tokenObjectAtIndex:(NSUInteger)index
+{
+    return [LSToken tokenWithType:_tokens[index].type
+                         andValue:[self valueOfTokenAtIndex:index]
+                    andAttributes:[self attributesOfTokenAtIndex:index]];
+}
+
+@end